@@ -17,15 +17,47 @@
 */
 
 #include <Box2D/Collision/b2BroadPhase.h>
+#include <Box2D/Collision/b2TreeBroadPhase.h>
+#include <Box2D/Collision/b2SweepBroadPhase.h>
+#include <Box2D/Collision/b2GridBroadPhase.h>
+#include <algorithm>
 #include <cstring>
+#include <new>
 
-b2BroadPhase::b2BroadPhase()
+b2BroadPhase* b2BroadPhase::Create(b2BroadPhaseType type, float32 cellSize)
 {
-	m_proxyCount = 0;
+	switch (type)
+	{
+	case b2_sweepBroadPhase:
+		{
+			void* mem = b2Alloc(sizeof(b2SweepBroadPhase));
+			return new (mem) b2SweepBroadPhase;
+		}
 
-	m_pairCapacity = 16;
-	m_pairCount = 0;
-	m_pairBuffer = (b2Pair*)b2Alloc(m_pairCapacity * sizeof(b2Pair));
+	case b2_gridBroadPhase:
+		{
+			void* mem = b2Alloc(sizeof(b2GridBroadPhase));
+			return new (mem) b2GridBroadPhase(cellSize);
+		}
+
+	default:
+		{
+			void* mem = b2Alloc(sizeof(b2TreeBroadPhase));
+			return new (mem) b2TreeBroadPhase;
+		}
+	}
+}
+
+void b2BroadPhase::Destroy(b2BroadPhase* broadPhase)
+{
+	broadPhase->~b2BroadPhase();
+	b2Free(broadPhase);
+}
+
+b2BroadPhase::b2BroadPhase(b2BroadPhaseType type)
+{
+	m_type = type;
+	m_proxyCount = 0;
 
 	m_moveCapacity = 16;
 	m_moveCount = 0;
@@ -35,31 +67,51 @@ b2BroadPhase::b2BroadPhase()
 b2BroadPhase::~b2BroadPhase()
 {
 	b2Free(m_moveBuffer);
-	b2Free(m_pairBuffer);
 }
 
-int32 b2BroadPhase::CreateProxy(const b2AABB& aabb, void* userData)
+void b2BroadPhase::SetTaskScheduler(b2TaskScheduler* scheduler)
+{
+	B2_NOT_USED(scheduler);
+}
+
+void b2BroadPhase::BeginBatch()
 {
-	int32 proxyId = m_tree.CreateProxy(aabb, userData);
-	++m_proxyCount;
-	BufferMove(proxyId);
-	return proxyId;
 }
 
-void b2BroadPhase::DestroyProxy(int32 proxyId)
+void b2BroadPhase::EndBatch()
 {
-	UnBufferMove(proxyId);
-	--m_proxyCount;
-	m_tree.DestroyProxy(proxyId);
 }
 
-void b2BroadPhase::MoveProxy(int32 proxyId, const b2AABB& aabb, const b2Vec2& displacement)
+b2AABB b2BroadPhase::ComputeFatAABB(const b2AABB& aabb, const b2Vec2& displacement)
 {
-	bool buffer = m_tree.MoveProxy(proxyId, aabb, displacement);
-	if (buffer)
+	// Extend AABB.
+	b2AABB b = aabb;
+	b2Vec2 r(b2_aabbExtension, b2_aabbExtension);
+	b.lowerBound = b.lowerBound - r;
+	b.upperBound = b.upperBound + r;
+
+	// Predict AABB displacement.
+	b2Vec2 d = b2_aabbMultiplier * displacement;
+
+	if (d.x < 0.0f)
+	{
+		b.lowerBound.x += d.x;
+	}
+	else
+	{
+		b.upperBound.x += d.x;
+	}
+
+	if (d.y < 0.0f)
+	{
+		b.lowerBound.y += d.y;
+	}
+	else
 	{
-		BufferMove(proxyId);
+		b.upperBound.y += d.y;
 	}
+
+	return b;
 }
 
 void b2BroadPhase::BufferMove(int32 proxyId)
@@ -79,38 +131,40 @@ void b2BroadPhase::BufferMove(int32 proxyId)
 
 void b2BroadPhase::UnBufferMove(int32 proxyId)
 {
+	// A proxy is buffered again each time it leaves its fat AABB.
 	for (int32 i = 0; i < m_moveCount; ++i)
 	{
 		if (m_moveBuffer[i] == proxyId)
 		{
 			m_moveBuffer[i] = e_nullProxy;
-			return;
 		}
 	}
 }
 
-// This is called from b2DynamicTree::Query when we are gathering pairs.
-bool b2BroadPhase::QueryCallback(int32 proxyId)
+void b2PairBuffer::AddPair(int32 proxyIdA, int32 proxyIdB)
 {
-	// A proxy cannot form a pair with itself.
-	if (proxyId == m_queryProxyId)
-	{
-		return true;
-	}
-
 	// Grow the pair buffer as needed.
-	if (m_pairCount == m_pairCapacity)
+	if (count == capacity)
 	{
-		b2Pair* oldBuffer = m_pairBuffer;
-		m_pairCapacity *= 2;
-		m_pairBuffer = (b2Pair*)b2Alloc(m_pairCapacity * sizeof(b2Pair));
-		memcpy(m_pairBuffer, oldBuffer, m_pairCount * sizeof(b2Pair));
+		b2Pair* oldBuffer = pairs;
+		capacity *= 2;
+		pairs = (b2Pair*)b2Alloc(capacity * sizeof(b2Pair));
+		memcpy(pairs, oldBuffer, count * sizeof(b2Pair));
 		b2Free(oldBuffer);
 	}
 
-	m_pairBuffer[m_pairCount].proxyIdA = b2Min(proxyId, m_queryProxyId);
-	m_pairBuffer[m_pairCount].proxyIdB = b2Max(proxyId, m_queryProxyId);
-	++m_pairCount;
+	pairs[count].proxyIdA = b2Min(proxyIdA, proxyIdB);
+	pairs[count].proxyIdB = b2Max(proxyIdA, proxyIdB);
+	++count;
+}
 
-	return true;
+static bool b2PairEqual(const b2Pair& pair1, const b2Pair& pair2)
+{
+	return pair1.proxyIdA == pair2.proxyIdA && pair1.proxyIdB == pair2.proxyIdB;
+}
+
+void b2PairBuffer::Sort()
+{
+	std::sort(pairs, pairs + count, b2PairLessThan);
+	count = int32(std::unique(pairs, pairs + count, b2PairEqual) - pairs);
 }
@@ -21,8 +21,16 @@
 
 #include <Box2D/Common/b2Settings.h>
 #include <Box2D/Collision/b2Collision.h>
-#include <Box2D/Collision/b2DynamicTree.h>
-#include <algorithm>
+
+class b2TaskScheduler;
+
+/// The available broad-phase implementations.
+enum b2BroadPhaseType
+{
+	b2_treeBroadPhase = 0,
+	b2_sweepBroadPhase,
+	b2_gridBroadPhase
+};
 
 struct b2Pair
 {
@@ -31,9 +39,59 @@ struct b2Pair
 	int32 next;
 };
 
+/// A growable array of proxy pairs.
+struct b2PairBuffer
+{
+	/// Add a pair, keeping the lower proxy id first.
+	void AddPair(int32 proxyIdA, int32 proxyIdB);
+
+	/// Sort the pairs and remove the duplicates.
+	void Sort();
+
+	b2Pair* pairs;
+	int32 capacity;
+	int32 count;
+};
+
+/// Receives the potentially new pairs of the broad-phase.
+class b2PairCallback
+{
+public:
+	virtual ~b2PairCallback() {}
+
+	/// Called for each new pair with the user data of both proxies.
+	virtual void AddPair(void* userDataA, void* userDataB) = 0;
+};
+
+/// Receives the proxies found by a broad-phase query.
+class b2ProxyQueryCallback
+{
+public:
+	virtual ~b2ProxyQueryCallback() {}
+
+	/// Return false to terminate the query.
+	virtual bool QueryCallback(int32 proxyId) = 0;
+};
+
+/// Receives the proxies found by a broad-phase ray cast.
+class b2ProxyRayCastCallback
+{
+public:
+	virtual ~b2ProxyRayCastCallback() {}
+
+	/// Return 0 to terminate the ray cast, the new max fraction to clip
+	/// the ray or a negative value to ignore the proxy.
+	virtual float32 RayCastCallback(const b2RayCastInput& input, int32 proxyId) = 0;
+};
+
 /// The broad-phase is used for computing pairs and performing volume queries and ray casts.
 /// This broad-phase does not persist pairs. Instead, this reports potentially new pairs.
 /// It is up to the client to consume the new pairs and to track subsequent overlap.
+///
+/// Every implementation keeps a fat AABB for each proxy, reports the pairs of
+/// the proxies that moved out of their fat AABB since the last update and never
+/// reports pairs between two static proxies. Pairs are reported in the order of
+/// their proxy ids, so a simulation does not depend on the order proxies are found.
 class b2BroadPhase
 {
 public:
@@ -43,25 +101,38 @@ public:
 		e_nullProxy = -1,
 	};
 
-	b2BroadPhase();
-	~b2BroadPhase();
+	/// Create a broad-phase of the given type. The cell size is only used by
+	/// the grid, see b2GridBroadPhase.
+	static b2BroadPhase* Create(b2BroadPhaseType type, float32 cellSize);
+
+	/// Destroy a broad-phase made by Create.
+	static void Destroy(b2BroadPhase* broadPhase);
+
+	virtual ~b2BroadPhase();
+
+	/// Get the type of this broad-phase.
+	b2BroadPhaseType GetType() const;
 
 	/// Create a proxy with an initial AABB. Pairs are not reported until
-	/// UpdatePairs is called.
-	int32 CreateProxy(const b2AABB& aabb, void* userData);
+	/// UpdatePairs is called. Static proxies should rarely move.
+	virtual int32 CreateProxy(const b2AABB& aabb, void* userData, bool isStatic) = 0;
 
 	/// Destroy a proxy. It is up to the client to remove any pairs.
-	void DestroyProxy(int32 proxyId);
+	virtual void DestroyProxy(int32 proxyId) = 0;
 
 	/// Call MoveProxy as many times as you like, then when you are done
 	/// call UpdatePairs to finalized the proxy pairs (for your time step).
-	void MoveProxy(int32 proxyId, const b2AABB& aabb, const b2Vec2& displacement);
+	virtual void MoveProxy(int32 proxyId, const b2AABB& aabb, const b2Vec2& displacement) = 0;
 
 	/// Get the fat AABB for a proxy.
-	const b2AABB& GetFatAABB(int32 proxyId) const;
+	virtual const b2AABB& GetFatAABB(int32 proxyId) const = 0;
+
+	/// Translate every proxy so that newOrigin becomes the origin. The proxies
+	/// keep their ids and are not reported as moved.
+	virtual void ShiftOrigin(const b2Vec2& newOrigin) = 0;
 
 	/// Get user data from a proxy. Returns NULL if the id is invalid.
-	void* GetUserData(int32 proxyId) const;
+	virtual void* GetUserData(int32 proxyId) const = 0;
 
 	/// Test overlap of fat AABBs.
 	bool TestOverlap(int32 proxyIdA, int32 proxyIdB) const;
@@ -70,49 +141,54 @@ public:
 	int32 GetProxyCount() const;
 
 	/// Update the pairs. This results in pair callbacks. This can only add pairs.
-	template <typename T>
-	void UpdatePairs(T* callback);
+	virtual void UpdatePairs(b2PairCallback* callback) = 0;
 
 	/// Query an AABB for overlapping proxies. The callback class
 	/// is called for each proxy that overlaps the supplied AABB.
 	template <typename T>
 	void Query(T* callback, const b2AABB& aabb) const;
 
-	/// Ray-cast against the proxies in the tree. This relies on the callback
+	/// Ray-cast against the proxies. This relies on the callback
 	/// to perform a exact ray-cast in the case were the proxy contains a shape.
-	/// The callback also performs the any collision filtering. This has performance
-	/// roughly equal to k * log(n), where k is the number of collisions and n is the
-	/// number of proxies in the tree.
+	/// The callback also performs the any collision filtering.
 	/// @param input the ray-cast input data. The ray extends from p1 to p1 + maxFraction * (p2 - p1).
 	/// @param callback a callback class that is called for each proxy that is hit by the ray.
 	template <typename T>
 	void RayCast(T* callback, const b2RayCastInput& input) const;
 
-	/// Compute the height of the embedded tree.
-	int32 ComputeHeight() const;
+	/// Use a task scheduler to find new pairs on several threads. By default
+	/// the pairs are found on the calling thread.
+	virtual void SetTaskScheduler(b2TaskScheduler* scheduler);
 
-private:
+	/// Start a batch of new proxies. An implementation may defer the work of
+	/// creating them until EndBatch, when they can be organized together.
+	/// Queries and ray casts may miss them until then. UpdatePairs ends the
+	/// batch. By default proxies are created as usual.
+	virtual void BeginBatch();
+
+	/// End a batch of new proxies.
+	virtual void EndBatch();
 
-	friend class b2DynamicTree;
+protected:
+
+	b2BroadPhase(b2BroadPhaseType type);
+
+	virtual void QueryProxies(b2ProxyQueryCallback* callback, const b2AABB& aabb) const = 0;
+	virtual void RayCastProxies(b2ProxyRayCastCallback* callback, const b2RayCastInput& input) const = 0;
 
 	void BufferMove(int32 proxyId);
 	void UnBufferMove(int32 proxyId);
 
-	bool QueryCallback(int32 proxyId);
+	// Get the fat AABB of a proxy that moved, as b2DynamicTree does.
+	static b2AABB ComputeFatAABB(const b2AABB& aabb, const b2Vec2& displacement);
 
-	b2DynamicTree m_tree;
+	b2BroadPhaseType m_type;
 
 	int32 m_proxyCount;
 
 	int32* m_moveBuffer;
 	int32 m_moveCapacity;
 	int32 m_moveCount;
-
-	b2Pair* m_pairBuffer;
-	int32 m_pairCapacity;
-	int32 m_pairCount;
-
-	int32 m_queryProxyId;
 };
 
 /// This is used to sort pairs.
@@ -131,99 +207,67 @@ inline bool b2PairLessThan(const b2Pair& pair1, const b2Pair& pair2)
 	return false;
 }
 
-inline void* b2BroadPhase::GetUserData(int32 proxyId) const
-{
-	return m_tree.GetUserData(proxyId);
-}
-
-inline bool b2BroadPhase::TestOverlap(int32 proxyIdA, int32 proxyIdB) const
-{
-	const b2AABB& aabbA = m_tree.GetFatAABB(proxyIdA);
-	const b2AABB& aabbB = m_tree.GetFatAABB(proxyIdB);
-	return b2TestOverlap(aabbA, aabbB);
-}
-
-inline const b2AABB& b2BroadPhase::GetFatAABB(int32 proxyId) const
+// Passes the proxies of a query on to a callback of any type.
+template <typename T>
+class b2ProxyQueryAdapter : public b2ProxyQueryCallback
 {
-	return m_tree.GetFatAABB(proxyId);
-}
+public:
+	b2ProxyQueryAdapter(T* callback) : m_callback(callback) {}
 
-inline int32 b2BroadPhase::GetProxyCount() const
-{
-	return m_proxyCount;
-}
+	bool QueryCallback(int32 proxyId)
+	{
+		return m_callback->QueryCallback(proxyId);
+	}
 
-inline int32 b2BroadPhase::ComputeHeight() const
-{
-	return m_tree.ComputeHeight();
-}
+private:
+	T* m_callback;
+};
 
+// Passes the proxies of a ray cast on to a callback of any type.
 template <typename T>
-void b2BroadPhase::UpdatePairs(T* callback)
+class b2ProxyRayCastAdapter : public b2ProxyRayCastCallback
 {
-	// Reset pair buffer
-	m_pairCount = 0;
+public:
+	b2ProxyRayCastAdapter(T* callback) : m_callback(callback) {}
 
-	// Perform tree queries for all moving proxies.
-	for (int32 i = 0; i < m_moveCount; ++i)
+	float32 RayCastCallback(const b2RayCastInput& input, int32 proxyId)
 	{
-		m_queryProxyId = m_moveBuffer[i];
-		if (m_queryProxyId == e_nullProxy)
-		{
-			continue;
-		}
-
-		// We have to query the tree with the fat AABB so that
-		// we don't fail to create a pair that may touch later.
-		const b2AABB& fatAABB = m_tree.GetFatAABB(m_queryProxyId);
-
-		// Query tree, create pairs and add them pair buffer.
-		m_tree.Query(this, fatAABB);
+		return m_callback->RayCastCallback(input, proxyId);
 	}
 
-	// Reset move buffer
-	m_moveCount = 0;
+private:
+	T* m_callback;
+};
 
-	// Sort the pair buffer to expose duplicates.
-	std::sort(m_pairBuffer, m_pairBuffer + m_pairCount, b2PairLessThan);
+inline b2BroadPhaseType b2BroadPhase::GetType() const
+{
+	return m_type;
+}
 
-	// Send the pairs back to the client.
-	int32 i = 0;
-	while (i < m_pairCount)
-	{
-		b2Pair* primaryPair = m_pairBuffer + i;
-		void* userDataA = m_tree.GetUserData(primaryPair->proxyIdA);
-		void* userDataB = m_tree.GetUserData(primaryPair->proxyIdB);
-
-		callback->AddPair(userDataA, userDataB);
-		++i;
-
-		// Skip any duplicate pairs.
-		while (i < m_pairCount)
-		{
-			b2Pair* pair = m_pairBuffer + i;
-			if (pair->proxyIdA != primaryPair->proxyIdA || pair->proxyIdB != primaryPair->proxyIdB)
-			{
-				break;
-			}
-			++i;
-		}
-	}
+inline bool b2BroadPhase::TestOverlap(int32 proxyIdA, int32 proxyIdB) const
+{
+	const b2AABB& aabbA = GetFatAABB(proxyIdA);
+	const b2AABB& aabbB = GetFatAABB(proxyIdB);
+	return b2TestOverlap(aabbA, aabbB);
+}
 
-	// Try to keep the tree balanced.
-	m_tree.Rebalance(4);
+inline int32 b2BroadPhase::GetProxyCount() const
+{
+	return m_proxyCount;
 }
 
 template <typename T>
 inline void b2BroadPhase::Query(T* callback, const b2AABB& aabb) const
 {
-	m_tree.Query(callback, aabb);
+	b2ProxyQueryAdapter<T> adapter(callback);
+	QueryProxies(&adapter, aabb);
 }
 
 template <typename T>
 inline void b2BroadPhase::RayCast(T* callback, const b2RayCastInput& input) const
 {
-	m_tree.RayCast(callback, input);
+	b2ProxyRayCastAdapter<T> adapter(callback);
+	RayCastProxies(&adapter, input);
 }
 
 #endif
@@ -20,6 +20,16 @@
 #include <cstring>
 #include <cfloat>
 
+// A range of leaves waiting for a node while the tree is built top-down.
+struct b2BuildRange
+{
+	int32 begin;
+	int32 count;
+	int32 parent;
+	int32 child;
+	b2AABB centers;
+};
+
 b2DynamicTree::b2DynamicTree()
 {
 	m_root = b2_nullNode;
@@ -33,13 +43,16 @@ b2DynamicTree::b2DynamicTree()
 	for (int32 i = 0; i < m_nodeCapacity - 1; ++i)
 	{
 		m_nodes[i].next = i + 1;
+		m_nodes[i].height = -1;
 	}
 	m_nodes[m_nodeCapacity-1].next = b2_nullNode;
+	m_nodes[m_nodeCapacity-1].height = -1;
 	m_freeList = 0;
 
-	m_path = 0;
-
 	m_insertionCount = 0;
+
+	m_batching = false;
+	m_detachedCount = 0;
 }
 
 b2DynamicTree::~b2DynamicTree()
@@ -68,8 +81,10 @@ int32 b2DynamicTree::AllocateNode()
 		for (int32 i = m_nodeCount; i < m_nodeCapacity - 1; ++i)
 		{
 			m_nodes[i].next = i + 1;
+			m_nodes[i].height = -1;
 		}
 		m_nodes[m_nodeCapacity-1].next = b2_nullNode;
+		m_nodes[m_nodeCapacity-1].height = -1;
 		m_freeList = m_nodeCount;
 	}
 
@@ -79,6 +94,7 @@ int32 b2DynamicTree::AllocateNode()
 	m_nodes[nodeId].parent = b2_nullNode;
 	m_nodes[nodeId].child1 = b2_nullNode;
 	m_nodes[nodeId].child2 = b2_nullNode;
+	m_nodes[nodeId].height = 0;
 	++m_nodeCount;
 	return nodeId;
 }
@@ -89,6 +105,7 @@ void b2DynamicTree::FreeNode(int32 nodeId)
 	b2Assert(0 <= nodeId && nodeId < m_nodeCapacity);
 	b2Assert(0 < m_nodeCount);
 	m_nodes[nodeId].next = m_freeList;
+	m_nodes[nodeId].height = -1;
 	m_freeList = nodeId;
 	--m_nodeCount;
 }
@@ -106,17 +123,15 @@ int32 b2DynamicTree::CreateProxy(const b2AABB& aabb, void* userData)
 	m_nodes[proxyId].aabb.upperBound = aabb.upperBound + r;
 	m_nodes[proxyId].userData = userData;
 
-	InsertLeaf(proxyId);
+	m_nodes[proxyId].height = 0;
 
-	// Rebalance if necessary.
-	int32 iterationCount = m_nodeCount >> 4;
-	int32 tryCount = 0;
-	int32 height = ComputeHeight();
-	while (height > 64 && tryCount < 10)
+	if (m_batching)
+	{
+		++m_detachedCount;
+	}
+	else
 	{
-		Rebalance(iterationCount);
-		height = ComputeHeight();
-		++tryCount;
+		InsertLeaf(proxyId);
 	}
 
 	return proxyId;
@@ -127,7 +142,14 @@ void b2DynamicTree::DestroyProxy(int32 proxyId)
 	b2Assert(0 <= proxyId && proxyId < m_nodeCapacity);
 	b2Assert(m_nodes[proxyId].IsLeaf());
 
-	RemoveLeaf(proxyId);
+	if (IsDetached(proxyId))
+	{
+		--m_detachedCount;
+	}
+	else
+	{
+		RemoveLeaf(proxyId);
+	}
 	FreeNode(proxyId);
 }
 
@@ -142,7 +164,11 @@ bool b2DynamicTree::MoveProxy(int32 proxyId, const b2AABB& aabb, const b2Vec2& d
 		return false;
 	}
 
-	RemoveLeaf(proxyId);
+	bool detached = IsDetached(proxyId);
+	if (detached == false)
+	{
+		RemoveLeaf(proxyId);
+	}
 
 	// Extend AABB.
 	b2AABB b = aabb;
@@ -173,10 +199,290 @@ bool b2DynamicTree::MoveProxy(int32 proxyId, const b2AABB& aabb, const b2Vec2& d
 
 	m_nodes[proxyId].aabb = b;
 
-	InsertLeaf(proxyId);
+	if (detached == false)
+	{
+		InsertLeaf(proxyId);
+	}
 	return true;
 }
 
+void b2DynamicTree::BeginBatch()
+{
+	m_batching = true;
+}
+
+void b2DynamicTree::EndBatch()
+{
+	if (m_batching == false)
+	{
+		return;
+	}
+
+	// Inserting the leaves one by one is cheaper when there are few of them.
+	// A large batch gets a better tree from a top-down build.
+	int32 treeCount = GetProxyCount() - m_detachedCount;
+	if (m_detachedCount >= treeCount)
+	{
+		Rebuild();
+	}
+	else
+	{
+		for (int32 i = 0; i < m_nodeCapacity && m_detachedCount > 0; ++i)
+		{
+			if (m_nodes[i].height == 0 && IsDetached(i))
+			{
+				InsertLeaf(i);
+				--m_detachedCount;
+			}
+		}
+	}
+
+	m_batching = false;
+	m_detachedCount = 0;
+}
+
+void b2DynamicTree::Rebuild()
+{
+	int32 proxyCount = GetProxyCount();
+	if (proxyCount == 0)
+	{
+		return;
+	}
+
+	int32* leaves = (int32*)b2Alloc(proxyCount * sizeof(int32));
+	b2AABB* aabbs = (b2AABB*)b2Alloc(proxyCount * sizeof(b2AABB));
+	int32* internalNodes = (int32*)b2Alloc(proxyCount * sizeof(int32));
+
+	// Gather the leaves, bound their centers and free the internal nodes.
+	b2Vec2 lower(FLT_MAX, FLT_MAX);
+	b2Vec2 upper(-FLT_MAX, -FLT_MAX);
+	int32 leafCount = 0;
+	for (int32 i = 0; i < m_nodeCapacity; ++i)
+	{
+		if (m_nodes[i].height < 0)
+		{
+			continue;
+		}
+
+		if (m_nodes[i].IsLeaf())
+		{
+			leaves[leafCount] = i;
+			aabbs[leafCount] = m_nodes[i].aabb;
+			b2Vec2 center = aabbs[leafCount].lowerBound + aabbs[leafCount].upperBound;
+			lower = b2Min(lower, center);
+			upper = b2Max(upper, center);
+			++leafCount;
+		}
+		else
+		{
+			FreeNode(i);
+		}
+	}
+	b2Assert(leafCount == proxyCount);
+	m_detachedCount = 0;
+
+	// Split the ranges of leaves until each holds one leaf. The internal nodes
+	// are created before their children.
+	int32 internalCount = 0;
+	b2GrowableStack<b2BuildRange, 64> stack;
+	b2BuildRange range;
+	range.begin = 0;
+	range.count = leafCount;
+	range.parent = b2_nullNode;
+	range.child = 0;
+	range.centers.lowerBound = lower;
+	range.centers.upperBound = upper;
+	stack.Push(range);
+
+	while (stack.GetCount() > 0)
+	{
+		range = stack.Pop();
+
+		int32 nodeId;
+		if (range.count == 1)
+		{
+			nodeId = leaves[range.begin];
+		}
+		else
+		{
+			nodeId = AllocateNode();
+			m_nodes[nodeId].userData = NULL;
+			internalNodes[internalCount++] = nodeId;
+
+			b2BuildRange child1, child2;
+			int32 split = Partition(leaves + range.begin, aabbs + range.begin, range.count,
+									range.centers, &child1.centers, &child2.centers);
+
+			child1.parent = nodeId;
+			child1.begin = range.begin;
+			child1.count = split;
+			child1.child = 1;
+			stack.Push(child1);
+			child2.parent = nodeId;
+			child2.begin = range.begin + split;
+			child2.count = range.count - split;
+			child2.child = 2;
+			stack.Push(child2);
+		}
+
+		m_nodes[nodeId].parent = range.parent;
+		if (range.parent == b2_nullNode)
+		{
+			m_root = nodeId;
+		}
+		else if (range.child == 1)
+		{
+			m_nodes[range.parent].child1 = nodeId;
+		}
+		else
+		{
+			m_nodes[range.parent].child2 = nodeId;
+		}
+	}
+
+	// Fit the internal nodes bottom-up.
+	for (int32 i = internalCount - 1; i >= 0; --i)
+	{
+		b2DynamicTreeNode* node = m_nodes + internalNodes[i];
+		const b2DynamicTreeNode* child1 = m_nodes + node->child1;
+		const b2DynamicTreeNode* child2 = m_nodes + node->child2;
+		node->aabb.Combine(child1->aabb, child2->aabb);
+		node->height = 1 + b2Max(child1->height, child2->height);
+	}
+
+	b2Free(internalNodes);
+	b2Free(aabbs);
+	b2Free(leaves);
+}
+
+void b2DynamicTree::ShiftOrigin(const b2Vec2& newOrigin)
+{
+	for (int32 i = 0; i < m_nodeCapacity; ++i)
+	{
+		if (m_nodes[i].height >= 0)
+		{
+			m_nodes[i].aabb.lowerBound -= newOrigin;
+			m_nodes[i].aabb.upperBound -= newOrigin;
+		}
+	}
+}
+
+// Split a range of leaves in two where the binned surface area heuristic is
+// least, that is the perimeter of each half times its number of leaves. The
+// leaves are binned by their centers along the longest axis. The AABBs are
+// copies of the leaf AABBs, kept next to each other for speed. Centers are
+// taken at twice their value, which saves a multiply, and their bounds are
+// handed down from the parent range so the leaves are read twice, not three
+// times. Returns the number of leaves that go to the first half.
+int32 b2DynamicTree::Partition(int32* leaves, b2AABB* aabbs, int32 count, const b2AABB& centers,
+							   b2AABB* firstCenters, b2AABB* secondCenters)
+{
+	const int32 k_binCount = 16;
+
+	// Two leaves can only be split one way, and single leaves need no bounds.
+	b2Vec2 extent = centers.upperBound - centers.lowerBound;
+	int32 axis = extent.x >= extent.y ? 0 : 1;
+	if (count == 2 || extent(axis) <= 0.0f)
+	{
+		// The centers may coincide, then any split will do.
+		*firstCenters = centers;
+		*secondCenters = centers;
+		return count / 2;
+	}
+
+	float32 origin = centers.lowerBound(axis);
+	float32 scale = k_binCount / extent(axis);
+
+	// Empty bins have inverted bounds, which any combination overrides.
+	b2AABB empty;
+	empty.lowerBound.Set(FLT_MAX, FLT_MAX);
+	empty.upperBound.Set(-FLT_MAX, -FLT_MAX);
+
+	b2AABB binAABBs[k_binCount];
+	b2AABB binCenters[k_binCount];
+	int32 binCounts[k_binCount];
+	for (int32 i = 0; i < k_binCount; ++i)
+	{
+		binAABBs[i] = empty;
+		binCenters[i] = empty;
+		binCounts[i] = 0;
+	}
+
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2Vec2 center = aabbs[i].lowerBound + aabbs[i].upperBound;
+		int32 bin = b2Min(int32((center(axis) - origin) * scale), k_binCount - 1);
+		binAABBs[bin].Combine(binAABBs[bin], aabbs[i]);
+		binCenters[bin].lowerBound = b2Min(binCenters[bin].lowerBound, center);
+		binCenters[bin].upperBound = b2Max(binCenters[bin].upperBound, center);
+		++binCounts[bin];
+	}
+
+	// The first and last bins hold the lowest and highest centers, so they
+	// are never empty and no split leaves a half without leaves.
+	b2Assert(binCounts[0] > 0 && binCounts[k_binCount - 1] > 0);
+
+	// Cost of the bins from each bin up to the last one.
+	float32 upperCosts[k_binCount];
+	b2AABB upperAABB = binAABBs[k_binCount - 1];
+	int32 upperCount = binCounts[k_binCount - 1];
+	upperCosts[k_binCount - 1] = upperCount * upperAABB.GetPerimeter();
+	for (int32 i = k_binCount - 2; i > 0; --i)
+	{
+		upperAABB.Combine(upperAABB, binAABBs[i]);
+		upperCount += binCounts[i];
+		upperCosts[i] = upperCount * upperAABB.GetPerimeter();
+	}
+
+	int32 bestBin = k_binCount - 1;
+	float32 bestCost = FLT_MAX;
+	b2AABB lowerAABB = binAABBs[0];
+	int32 lowerCount = binCounts[0];
+	for (int32 i = 1; i < k_binCount; ++i)
+	{
+		float32 cost = lowerCount * lowerAABB.GetPerimeter() + upperCosts[i];
+		if (cost < bestCost)
+		{
+			bestCost = cost;
+			bestBin = i;
+		}
+
+		lowerAABB.Combine(lowerAABB, binAABBs[i]);
+		lowerCount += binCounts[i];
+	}
+
+	*firstCenters = binCenters[0];
+	for (int32 i = 1; i < bestBin; ++i)
+	{
+		firstCenters->Combine(*firstCenters, binCenters[i]);
+	}
+
+	*secondCenters = binCenters[bestBin];
+	for (int32 i = bestBin + 1; i < k_binCount; ++i)
+	{
+		secondCenters->Combine(*secondCenters, binCenters[i]);
+	}
+
+	// Move the leaves of the lower bins to the front. Every leaf is swapped,
+	// even in place, because which half a leaf goes to is unpredictable and
+	// branching on it costs more than the swap.
+	int32 i = 0;
+	for (int32 k = 0; k < count; ++k)
+	{
+		float32 center = aabbs[k].lowerBound(axis) + aabbs[k].upperBound(axis);
+		int32 bin = b2Min(int32((center - origin) * scale), k_binCount - 1);
+		b2Swap(leaves[i], leaves[k]);
+		b2Swap(aabbs[i], aabbs[k]);
+		i += bin < bestBin ? 1 : 0;
+	}
+
+	b2Assert(0 < i && i < count);
+	return i;
+}
+
+// Insert a leaf where it increases the perimeters of the tree the least
+// (surface area heuristic), then rotate the ancestors to keep the heights
+// of sibling sub-trees within one of each other.
 void b2DynamicTree::InsertLeaf(int32 leaf)
 {
 	++m_insertionCount;
@@ -189,78 +495,102 @@ void b2DynamicTree::InsertLeaf(int32 leaf)
 	}
 
 	// Find the best sibling for this node.
-	b2Vec2 center = m_nodes[leaf].aabb.GetCenter();
+	b2AABB leafAABB = m_nodes[leaf].aabb;
 	int32 sibling = m_root;
-	if (m_nodes[sibling].IsLeaf() == false)
+	while (m_nodes[sibling].IsLeaf() == false)
 	{
-		do 
-		{
-			int32 child1 = m_nodes[sibling].child1;
-			int32 child2 = m_nodes[sibling].child2;
+		int32 child1 = m_nodes[sibling].child1;
+		int32 child2 = m_nodes[sibling].child2;
+
+		float32 area = m_nodes[sibling].aabb.GetPerimeter();
+
+		b2AABB combinedAABB;
+		combinedAABB.Combine(m_nodes[sibling].aabb, leafAABB);
+		float32 combinedArea = combinedAABB.GetPerimeter();
 
-			b2Vec2 delta1 = b2Abs(m_nodes[child1].aabb.GetCenter() - center);
-			b2Vec2 delta2 = b2Abs(m_nodes[child2].aabb.GetCenter() - center);
+		// Cost of creating a new parent for this node and the new leaf.
+		float32 cost = 2.0f * combinedArea;
 
-			float32 norm1 = delta1.x + delta1.y;
-			float32 norm2 = delta2.x + delta2.y;
+		// Minimum cost of pushing the leaf further down the tree.
+		float32 inheritanceCost = 2.0f * (combinedArea - area);
 
-			if (norm1 < norm2)
+		// Cost of descending into each child.
+		float32 cost1 = inheritanceCost;
+		{
+			b2AABB aabb;
+			aabb.Combine(leafAABB, m_nodes[child1].aabb);
+			if (m_nodes[child1].IsLeaf())
 			{
-				sibling = child1;
+				cost1 += aabb.GetPerimeter();
 			}
 			else
 			{
-				sibling = child2;
+				cost1 += aabb.GetPerimeter() - m_nodes[child1].aabb.GetPerimeter();
 			}
+		}
 
+		float32 cost2 = inheritanceCost;
+		{
+			b2AABB aabb;
+			aabb.Combine(leafAABB, m_nodes[child2].aabb);
+			if (m_nodes[child2].IsLeaf())
+			{
+				cost2 += aabb.GetPerimeter();
+			}
+			else
+			{
+				cost2 += aabb.GetPerimeter() - m_nodes[child2].aabb.GetPerimeter();
+			}
 		}
-		while(m_nodes[sibling].IsLeaf() == false);
-	}
 
-	// Create a parent for the siblings.
-	int32 node1 = m_nodes[sibling].parent;
-	int32 node2 = AllocateNode();
-	m_nodes[node2].parent = node1;
-	m_nodes[node2].userData = NULL;
-	m_nodes[node2].aabb.Combine(m_nodes[leaf].aabb, m_nodes[sibling].aabb);
+		// Descend according to the minimum cost.
+		if (cost < cost1 && cost < cost2)
+		{
+			break;
+		}
 
-	if (node1 != b2_nullNode)
-	{
-		if (m_nodes[m_nodes[sibling].parent].child1 == sibling)
+		if (cost1 < cost2)
 		{
-			m_nodes[node1].child1 = node2;
+			sibling = child1;
 		}
 		else
 		{
-			m_nodes[node1].child2 = node2;
+			sibling = child2;
 		}
+	}
 
-		m_nodes[node2].child1 = sibling;
-		m_nodes[node2].child2 = leaf;
-		m_nodes[sibling].parent = node2;
-		m_nodes[leaf].parent = node2;
-
-		do 
+	// Create a parent for the siblings.
+	int32 oldParent = m_nodes[sibling].parent;
+	int32 newParent = AllocateNode();
+	m_nodes[newParent].parent = oldParent;
+	m_nodes[newParent].userData = NULL;
+	m_nodes[newParent].aabb.Combine(leafAABB, m_nodes[sibling].aabb);
+	m_nodes[newParent].height = m_nodes[sibling].height + 1;
+	m_nodes[newParent].child1 = sibling;
+	m_nodes[newParent].child2 = leaf;
+	m_nodes[sibling].parent = newParent;
+	m_nodes[leaf].parent = newParent;
+
+	if (oldParent != b2_nullNode)
+	{
+		// The sibling was not the root.
+		if (m_nodes[oldParent].child1 == sibling)
 		{
-			if (m_nodes[node1].aabb.Contains(m_nodes[node2].aabb))
-			{
-				break;
-			}
-
-			m_nodes[node1].aabb.Combine(m_nodes[m_nodes[node1].child1].aabb, m_nodes[m_nodes[node1].child2].aabb);
-			node2 = node1;
-			node1 = m_nodes[node1].parent;
+			m_nodes[oldParent].child1 = newParent;
+		}
+		else
+		{
+			m_nodes[oldParent].child2 = newParent;
 		}
-		while(node1 != b2_nullNode);
 	}
 	else
 	{
-		m_nodes[node2].child1 = sibling;
-		m_nodes[node2].child2 = leaf;
-		m_nodes[sibling].parent = node2;
-		m_nodes[leaf].parent = node2;
-		m_root = node2;
+		// The sibling was the root.
+		m_root = newParent;
 	}
+
+	// Walk back up the tree fixing heights and AABBs.
+	Refit(m_nodes[leaf].parent);
 }
 
 void b2DynamicTree::RemoveLeaf(int32 leaf)
@@ -271,95 +601,185 @@ void b2DynamicTree::RemoveLeaf(int32 leaf)
 		return;
 	}
 
-	int32 node2 = m_nodes[leaf].parent;
-	int32 node1 = m_nodes[node2].parent;
+	int32 parent = m_nodes[leaf].parent;
+	int32 grandParent = m_nodes[parent].parent;
 	int32 sibling;
-	if (m_nodes[node2].child1 == leaf)
+	if (m_nodes[parent].child1 == leaf)
 	{
-		sibling = m_nodes[node2].child2;
+		sibling = m_nodes[parent].child2;
 	}
 	else
 	{
-		sibling = m_nodes[node2].child1;
+		sibling = m_nodes[parent].child1;
 	}
 
-	if (node1 != b2_nullNode)
+	if (grandParent != b2_nullNode)
 	{
-		// Destroy node2 and connect node1 to sibling.
-		if (m_nodes[node1].child1 == node2)
+		// Destroy the parent and connect the sibling to the grand parent.
+		if (m_nodes[grandParent].child1 == parent)
 		{
-			m_nodes[node1].child1 = sibling;
+			m_nodes[grandParent].child1 = sibling;
 		}
 		else
 		{
-			m_nodes[node1].child2 = sibling;
+			m_nodes[grandParent].child2 = sibling;
 		}
-		m_nodes[sibling].parent = node1;
-		FreeNode(node2);
+		m_nodes[sibling].parent = grandParent;
+		FreeNode(parent);
 
 		// Adjust ancestor bounds.
-		while (node1 != b2_nullNode)
-		{
-			b2AABB oldAABB = m_nodes[node1].aabb;
-			m_nodes[node1].aabb.Combine(m_nodes[m_nodes[node1].child1].aabb, m_nodes[m_nodes[node1].child2].aabb);
-
-			if (oldAABB.Contains(m_nodes[node1].aabb))
-			{
-				break;
-			}
-
-			node1 = m_nodes[node1].parent;
-		}
+		Refit(grandParent);
 	}
 	else
 	{
 		m_root = sibling;
 		m_nodes[sibling].parent = b2_nullNode;
-		FreeNode(node2);
+		FreeNode(parent);
 	}
 }
 
-void b2DynamicTree::Rebalance(int32 iterations)
+// Balance and refit the ancestors of a changed node, starting with the node.
+void b2DynamicTree::Refit(int32 index)
 {
-	if (m_root == b2_nullNode)
+	while (index != b2_nullNode)
 	{
-		return;
+		index = Balance(index);
+
+		int32 child1 = m_nodes[index].child1;
+		int32 child2 = m_nodes[index].child2;
+
+		b2Assert(child1 != b2_nullNode);
+		b2Assert(child2 != b2_nullNode);
+
+		m_nodes[index].height = 1 + b2Max(m_nodes[child1].height, m_nodes[child2].height);
+		m_nodes[index].aabb.Combine(m_nodes[child1].aabb, m_nodes[child2].aabb);
+
+		index = m_nodes[index].parent;
 	}
+}
 
-	for (int32 i = 0; i < iterations; ++i)
+/* Perform a left or right rotation if node A is imbalanced.
+ * Returns the new root index of the sub-tree.
+ *
+ *       A            C
+ *      / \          / \
+ *     B   C   =>   A   F
+ *        / \      / \
+ *       F   G    B   G
+ */
+int32 b2DynamicTree::Balance(int32 iA)
+{
+	b2Assert(iA != b2_nullNode);
+
+	b2DynamicTreeNode* A = m_nodes + iA;
+	if (A->IsLeaf() || A->height < 2)
 	{
-		int32 node = m_root;
+		return iA;
+	}
 
-		uint32 bit = 0;
-		while (m_nodes[node].IsLeaf() == false)
-		{
-			int32* children = &m_nodes[node].child1;
-			node = children[(m_path >> bit) & 1];
-			bit = (bit + 1) & (8* sizeof(uint32) - 1);
-		}
-		++m_path;
+	int32 iB = A->child1;
+	int32 iC = A->child2;
+	b2Assert(0 <= iB && iB < m_nodeCapacity);
+	b2Assert(0 <= iC && iC < m_nodeCapacity);
+
+	b2DynamicTreeNode* B = m_nodes + iB;
+	b2DynamicTreeNode* C = m_nodes + iC;
+
+	int32 balance = C->height - B->height;
 
-		RemoveLeaf(node);
-		InsertLeaf(node);
+	// Rotate C up.
+	if (balance > 1)
+	{
+		return Rotate(iA, iC, iB);
+	}
+
+	// Rotate B up.
+	if (balance < -1)
+	{
+		return Rotate(iA, iB, iC);
 	}
+
+	return iA;
 }
 
-// Compute the height of a sub-tree.
-int32 b2DynamicTree::ComputeHeight(int32 nodeId) const
+// Move the higher child C of A into the place of A. A takes the place of the
+// lower grand child, which is swapped with the other child B of A.
+int32 b2DynamicTree::Rotate(int32 iA, int32 iC, int32 iB)
 {
-	if (nodeId == b2_nullNode)
+	b2DynamicTreeNode* A = m_nodes + iA;
+	b2DynamicTreeNode* B = m_nodes + iB;
+	b2DynamicTreeNode* C = m_nodes + iC;
+
+	int32 iF = C->child1;
+	int32 iG = C->child2;
+	b2DynamicTreeNode* F = m_nodes + iF;
+	b2DynamicTreeNode* G = m_nodes + iG;
+	b2Assert(0 <= iF && iF < m_nodeCapacity);
+	b2Assert(0 <= iG && iG < m_nodeCapacity);
+
+	// Swap A and C.
+	C->parent = A->parent;
+	A->parent = iC;
+
+	// A's old parent should point to C.
+	if (C->parent != b2_nullNode)
 	{
-		return 0;
+		if (m_nodes[C->parent].child1 == iA)
+		{
+			m_nodes[C->parent].child1 = iC;
+		}
+		else
+		{
+			b2Assert(m_nodes[C->parent].child2 == iA);
+			m_nodes[C->parent].child2 = iC;
+		}
+	}
+	else
+	{
+		m_root = iC;
 	}
 
-	b2Assert(0 <= nodeId && nodeId < m_nodeCapacity);
-	b2DynamicTreeNode* node = m_nodes + nodeId;
-	int32 height1 = ComputeHeight(node->child1);
-	int32 height2 = ComputeHeight(node->child2);
-	return 1 + b2Max(height1, height2);
+	// C keeps its higher child and adopts A in place of the lower one.
+	if (F->height < G->height)
+	{
+		b2Swap(iF, iG);
+		b2Swap(F, G);
+	}
+
+	if (C->child1 == iG)
+	{
+		C->child1 = iA;
+	}
+	else
+	{
+		C->child2 = iA;
+	}
+
+	// A keeps B and adopts the lower grand child G in place of C.
+	if (A->child1 == iC)
+	{
+		A->child1 = iG;
+	}
+	else
+	{
+		A->child2 = iG;
+	}
+	G->parent = iA;
+
+	A->aabb.Combine(B->aabb, G->aabb);
+	A->height = 1 + b2Max(B->height, G->height);
+	C->aabb.Combine(A->aabb, F->aabb);
+	C->height = 1 + b2Max(A->height, F->height);
+
+	return iC;
 }
 
 int32 b2DynamicTree::ComputeHeight() const
 {
-	return ComputeHeight(m_root);
+	if (m_root == b2_nullNode)
+	{
+		return 0;
+	}
+
+	return 1 + m_nodes[m_root].height;
 }
@@ -20,6 +20,7 @@
 #define B2_DYNAMIC_TREE_H
 
 #include <Box2D/Collision/b2Collision.h>
+#include <Box2D/Common/b2GrowableStack.h>
 
 /// A dynamic AABB tree broad-phase, inspired by Nathanael Presson's btDbvt.
 
@@ -47,6 +48,9 @@ struct b2DynamicTreeNode
 
 	int32 child1;
 	int32 child2;
+
+	/// Leafs have height 0, free nodes -1.
+	int32 height;
 };
 
 /// A dynamic tree arranges data in a binary tree to accelerate
@@ -55,6 +59,10 @@ struct b2DynamicTreeNode
 /// so that the proxy AABB is bigger than the client object. This allows the client
 /// object to move by small amounts without triggering a tree update.
 ///
+/// Leafs are inserted where they add the least perimeter to the tree, and
+/// local rotations keep the tree balanced. Proxies created in a batch are
+/// inserted together, and a large batch builds the whole tree top-down.
+///
 /// Nodes are pooled and relocatable, so we use node indices rather than pointers.
 class b2DynamicTree
 {
@@ -78,9 +86,6 @@ public:
 	/// @return true if the proxy was re-inserted.
 	bool MoveProxy(int32 proxyId, const b2AABB& aabb1, const b2Vec2& displacement);
 
-	/// Perform some iterations to re-balance the tree.
-	void Rebalance(int32 iterations);
-
 	/// Get proxy user data.
 	/// @return the proxy user data or 0 if the id is invalid.
 	void* GetUserData(int32 proxyId) const;
@@ -88,7 +93,30 @@ public:
 	/// Get the fat AABB for a proxy.
 	const b2AABB& GetFatAABB(int32 proxyId) const;
 
-	/// Compute the height of the tree.
+	/// Get the number of proxies in the tree.
+	int32 GetProxyCount() const;
+
+	/// Start a batch. Proxies created from now on are kept out of the tree
+	/// until EndBatch, so queries and ray casts do not report them.
+	void BeginBatch();
+
+	/// Insert the proxies created since BeginBatch. When they are at least as
+	/// many as the proxies already in the tree, the tree is rebuilt instead.
+	void EndBatch();
+
+	/// Is a batch in progress?
+	bool IsBatching() const;
+
+	/// Build the tree from scratch, top-down. Each node is split where the
+	/// binned surface area heuristic is least. Proxy ids do not change.
+	void Rebuild();
+
+	/// Translate all the nodes so that newOrigin becomes the origin. The
+	/// structure of the tree does not change.
+	void ShiftOrigin(const b2Vec2& newOrigin);
+
+	/// Get the height of the tree. This is the number of nodes on the
+	/// longest path from the root to a leaf.
 	int32 ComputeHeight() const;
 
 	/// Query an AABB for overlapping proxies. The callback class
@@ -114,7 +142,17 @@ private:
 	void InsertLeaf(int32 node);
 	void RemoveLeaf(int32 node);
 
-	int32 ComputeHeight(int32 nodeId) const;
+	// A proxy created in a batch is a leaf without parent until the batch ends.
+	bool IsDetached(int32 node) const;
+
+	static int32 Partition(int32* leaves, b2AABB* aabbs, int32 count, const b2AABB& centers,
+						   b2AABB* firstCenters, b2AABB* secondCenters);
+
+	void Refit(int32 index);
+	int32 Balance(int32 index);
+	int32 Rotate(int32 iA, int32 iC, int32 iB);
+
+	friend class b2WideTree;
 
 	int32 m_root;
 
@@ -124,10 +162,10 @@ private:
 
 	int32 m_freeList;
 
-	/// This is used incrementally traverse the tree for re-balancing.
-	uint32 m_path;
-
 	int32 m_insertionCount;
+
+	bool m_batching;
+	int32 m_detachedCount;
 };
 
 inline void* b2DynamicTree::GetUserData(int32 proxyId) const
@@ -142,18 +180,31 @@ inline const b2AABB& b2DynamicTree::GetFatAABB(int32 proxyId) const
 	return m_nodes[proxyId].aabb;
 }
 
+inline int32 b2DynamicTree::GetProxyCount() const
+{
+	// A full binary tree has one leaf more than internal nodes.
+	return (m_nodeCount - m_detachedCount + 1) / 2 + m_detachedCount;
+}
+
+inline bool b2DynamicTree::IsBatching() const
+{
+	return m_batching;
+}
+
+inline bool b2DynamicTree::IsDetached(int32 proxyId) const
+{
+	return m_batching && m_nodes[proxyId].parent == b2_nullNode && proxyId != m_root;
+}
+
 template <typename T>
 inline void b2DynamicTree::Query(T* callback, const b2AABB& aabb) const
 {
-	const int32 k_stackSize = 128;
-	int32 stack[k_stackSize];
+	b2GrowableStack<int32, 256> stack;
+	stack.Push(m_root);
 
-	int32 count = 0;
-	stack[count++] = m_root;
-
-	while (count > 0)
+	while (stack.GetCount() > 0)
 	{
-		int32 nodeId = stack[--count];
+		int32 nodeId = stack.Pop();
 		if (nodeId == b2_nullNode)
 		{
 			continue;
@@ -173,15 +224,8 @@ inline void b2DynamicTree::Query(T* callback, const b2AABB& aabb) const
 			}
 			else
 			{
-				if (count < k_stackSize)
-				{
-					stack[count++] = node->child1;
-				}
-
-				if (count < k_stackSize)
-				{
-					stack[count++] = node->child2;
-				}
+				stack.Push(node->child1);
+				stack.Push(node->child2);
 			}
 		}
 	}
@@ -213,15 +257,12 @@ inline void b2DynamicTree::RayCast(T* callback, const b2RayCastInput& input) con
 		segmentAABB.upperBound = b2Max(p1, t);
 	}
 
-	const int32 k_stackSize = 128;
-	int32 stack[k_stackSize];
+	b2GrowableStack<int32, 256> stack;
+	stack.Push(m_root);
 
-	int32 count = 0;
-	stack[count++] = m_root;
-
-	while (count > 0)
+	while (stack.GetCount() > 0)
 	{
-		int32 nodeId = stack[--count];
+		int32 nodeId = stack.Pop();
 		if (nodeId == b2_nullNode)
 		{
 			continue;
@@ -270,15 +311,8 @@ inline void b2DynamicTree::RayCast(T* callback, const b2RayCastInput& input) con
 		}
 		else
 		{
-			if (count < k_stackSize)
-			{
-				stack[count++] = node->child1;
-			}
-
-			if (count < k_stackSize)
-			{
-				stack[count++] = node->child2;
-			}
+			stack.Push(node->child1);
+			stack.Push(node->child2);
 		}
 	}
 }
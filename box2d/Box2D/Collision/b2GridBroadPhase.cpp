@@ -0,0 +1,672 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Collision/b2GridBroadPhase.h>
+#include <cmath>
+#include <cstring>
+
+// Cells further out are clamped, which only makes huge proxies large.
+static const float32 b2_maxGridCell = 16777216.0f;
+
+// Tests the ray against the fat AABB of a proxy and reports the proxy if it
+// may be hit. Returns false if the client terminated the ray cast.
+static bool b2RayCastProxy(b2ProxyRayCastCallback* callback, const b2RayCastInput& input,
+						   int32 proxyId, const b2AABB& aabb, const b2Vec2& v, const b2Vec2& abs_v,
+						   float32* maxFraction, b2AABB* segmentAABB)
+{
+	if (b2TestOverlap(aabb, *segmentAABB) == false)
+	{
+		return true;
+	}
+
+	// Separating axis for segment (Gino, p80).
+	// |dot(v, p1 - c)| > dot(|v|, h)
+	b2Vec2 c = aabb.GetCenter();
+	b2Vec2 h = aabb.GetExtents();
+	float32 separation = b2Abs(b2Dot(v, input.p1 - c)) - b2Dot(abs_v, h);
+	if (separation > 0.0f)
+	{
+		return true;
+	}
+
+	b2RayCastInput subInput;
+	subInput.p1 = input.p1;
+	subInput.p2 = input.p2;
+	subInput.maxFraction = *maxFraction;
+
+	float32 value = callback->RayCastCallback(subInput, proxyId);
+
+	if (value == 0.0f)
+	{
+		// The client has terminated the ray cast.
+		return false;
+	}
+
+	if (value > 0.0f)
+	{
+		// Update segment bounding box.
+		*maxFraction = value;
+		b2Vec2 t = input.p1 + value * (input.p2 - input.p1);
+		segmentAABB->lowerBound = b2Min(input.p1, t);
+		segmentAABB->upperBound = b2Max(input.p1, t);
+	}
+
+	return true;
+}
+
+b2GridBroadPhase::b2GridBroadPhase(float32 cellSize) : b2BroadPhase(b2_gridBroadPhase)
+{
+	b2Assert(cellSize > 0.0f);
+	m_cellSize = cellSize;
+	m_inverseCellSize = 1.0f / cellSize;
+
+	m_proxyCapacity = 0;
+	m_proxies = NULL;
+	m_freeProxyList = e_nullProxy;
+
+	m_entryCount = 0;
+	m_entryCapacity = 0;
+	m_entries = NULL;
+	m_freeEntryList = e_nullProxy;
+
+	m_bucketCount = 0;
+	m_buckets = NULL;
+	Rehash(64);
+
+	m_largeProxyCount = 0;
+	m_largeProxyCapacity = 16;
+	m_largeProxies = (int32*)b2Alloc(m_largeProxyCapacity * sizeof(int32));
+
+	m_pairBuffer.capacity = 16;
+	m_pairBuffer.count = 0;
+	m_pairBuffer.pairs = (b2Pair*)b2Alloc(m_pairBuffer.capacity * sizeof(b2Pair));
+}
+
+b2GridBroadPhase::~b2GridBroadPhase()
+{
+	b2Free(m_proxies);
+	b2Free(m_entries);
+	b2Free(m_buckets);
+	b2Free(m_largeProxies);
+	b2Free(m_pairBuffer.pairs);
+}
+
+int32 b2GridBroadPhase::GetCell(float32 x) const
+{
+	float32 cell = floorf(x * m_inverseCellSize);
+	return int32(b2Clamp(cell, -b2_maxGridCell, b2_maxGridCell));
+}
+
+int32 b2GridBroadPhase::GetBucket(int32 x, int32 y) const
+{
+	uint32 hash = uint32(x) * 0x9E3779B1u + uint32(y) * 0x85EBCA77u;
+	hash ^= hash >> 15;
+	return int32(hash & uint32(m_bucketCount - 1));
+}
+
+int32 b2GridBroadPhase::AllocateProxy()
+{
+	// Expand the proxy pool as needed.
+	if (m_freeProxyList == e_nullProxy)
+	{
+		int32 oldCapacity = m_proxyCapacity;
+		b2GridProxy* oldProxies = m_proxies;
+		m_proxyCapacity = b2Max(2 * oldCapacity, 16);
+		m_proxies = (b2GridProxy*)b2Alloc(m_proxyCapacity * sizeof(b2GridProxy));
+		if (oldCapacity > 0)
+		{
+			memcpy(m_proxies, oldProxies, oldCapacity * sizeof(b2GridProxy));
+		}
+		b2Free(oldProxies);
+
+		// Build a linked list for the free list.
+		for (int32 i = oldCapacity; i < m_proxyCapacity; ++i)
+		{
+			m_proxies[i].next = i + 1 < m_proxyCapacity ? i + 1 : e_nullProxy;
+			m_proxies[i].flags = b2GridProxy::e_freeFlag;
+		}
+		m_freeProxyList = oldCapacity;
+	}
+
+	int32 proxyId = m_freeProxyList;
+	m_freeProxyList = m_proxies[proxyId].next;
+	m_proxies[proxyId].next = e_nullProxy;
+	m_proxies[proxyId].flags = 0;
+	return proxyId;
+}
+
+void b2GridBroadPhase::FreeProxy(int32 proxyId)
+{
+	m_proxies[proxyId].next = m_freeProxyList;
+	m_proxies[proxyId].flags = b2GridProxy::e_freeFlag;
+	m_freeProxyList = proxyId;
+}
+
+void b2GridBroadPhase::Rehash(int32 bucketCount)
+{
+	b2Free(m_buckets);
+	m_bucketCount = bucketCount;
+	m_buckets = (int32*)b2Alloc(m_bucketCount * sizeof(int32));
+	for (int32 i = 0; i < m_bucketCount; ++i)
+	{
+		m_buckets[i] = e_nullProxy;
+	}
+
+	for (int32 i = 0; i < m_entryCapacity; ++i)
+	{
+		b2GridEntry* entry = m_entries + i;
+		if (entry->proxyId == e_nullProxy)
+		{
+			continue;
+		}
+
+		int32 bucket = GetBucket(entry->x, entry->y);
+		entry->next = m_buckets[bucket];
+		m_buckets[bucket] = i;
+	}
+}
+
+void b2GridBroadPhase::AddEntry(int32 x, int32 y, int32 proxyId)
+{
+	// Expand the entry pool as needed.
+	if (m_freeEntryList == e_nullProxy)
+	{
+		int32 oldCapacity = m_entryCapacity;
+		b2GridEntry* oldEntries = m_entries;
+		m_entryCapacity = b2Max(2 * oldCapacity, 64);
+		m_entries = (b2GridEntry*)b2Alloc(m_entryCapacity * sizeof(b2GridEntry));
+		if (oldCapacity > 0)
+		{
+			memcpy(m_entries, oldEntries, oldCapacity * sizeof(b2GridEntry));
+		}
+		b2Free(oldEntries);
+
+		for (int32 i = oldCapacity; i < m_entryCapacity; ++i)
+		{
+			m_entries[i].proxyId = e_nullProxy;
+			m_entries[i].next = i + 1 < m_entryCapacity ? i + 1 : e_nullProxy;
+		}
+		m_freeEntryList = oldCapacity;
+	}
+
+	// Keep the buckets short.
+	if (m_entryCount == m_bucketCount)
+	{
+		Rehash(2 * m_bucketCount);
+	}
+
+	int32 index = m_freeEntryList;
+	b2GridEntry* entry = m_entries + index;
+	m_freeEntryList = entry->next;
+
+	int32 bucket = GetBucket(x, y);
+	entry->x = x;
+	entry->y = y;
+	entry->proxyId = proxyId;
+	entry->next = m_buckets[bucket];
+	m_buckets[bucket] = index;
+	++m_entryCount;
+}
+
+void b2GridBroadPhase::RemoveEntry(int32 x, int32 y, int32 proxyId)
+{
+	int32* link = m_buckets + GetBucket(x, y);
+	while (*link != e_nullProxy)
+	{
+		int32 index = *link;
+		b2GridEntry* entry = m_entries + index;
+		if (entry->x == x && entry->y == y && entry->proxyId == proxyId)
+		{
+			*link = entry->next;
+			entry->proxyId = e_nullProxy;
+			entry->next = m_freeEntryList;
+			m_freeEntryList = index;
+			--m_entryCount;
+			return;
+		}
+
+		link = &entry->next;
+	}
+
+	b2Assert(false);
+}
+
+void b2GridBroadPhase::InsertProxy(int32 proxyId)
+{
+	b2GridProxy* proxy = m_proxies + proxyId;
+	proxy->lowerX = GetCell(proxy->aabb.lowerBound.x);
+	proxy->lowerY = GetCell(proxy->aabb.lowerBound.y);
+	proxy->upperX = GetCell(proxy->aabb.upperBound.x);
+	proxy->upperY = GetCell(proxy->aabb.upperBound.y);
+
+	int32 width = proxy->upperX - proxy->lowerX + 1;
+	int32 height = proxy->upperY - proxy->lowerY + 1;
+	if (width > e_maxProxyCells || height > e_maxProxyCells || width * height > e_maxProxyCells)
+	{
+		if (m_largeProxyCount == m_largeProxyCapacity)
+		{
+			int32* oldProxies = m_largeProxies;
+			m_largeProxyCapacity *= 2;
+			m_largeProxies = (int32*)b2Alloc(m_largeProxyCapacity * sizeof(int32));
+			memcpy(m_largeProxies, oldProxies, m_largeProxyCount * sizeof(int32));
+			b2Free(oldProxies);
+		}
+
+		proxy->flags |= b2GridProxy::e_largeFlag;
+		proxy->largeIndex = m_largeProxyCount;
+		m_largeProxies[m_largeProxyCount++] = proxyId;
+		return;
+	}
+
+	for (int32 y = proxy->lowerY; y <= proxy->upperY; ++y)
+	{
+		for (int32 x = proxy->lowerX; x <= proxy->upperX; ++x)
+		{
+			AddEntry(x, y, proxyId);
+		}
+	}
+}
+
+void b2GridBroadPhase::RemoveProxy(int32 proxyId)
+{
+	b2GridProxy* proxy = m_proxies + proxyId;
+
+	if (proxy->flags & b2GridProxy::e_largeFlag)
+	{
+		// Move the last large proxy into the hole.
+		int32 lastId = m_largeProxies[--m_largeProxyCount];
+		m_largeProxies[proxy->largeIndex] = lastId;
+		m_proxies[lastId].largeIndex = proxy->largeIndex;
+		proxy->flags &= ~b2GridProxy::e_largeFlag;
+		return;
+	}
+
+	for (int32 y = proxy->lowerY; y <= proxy->upperY; ++y)
+	{
+		for (int32 x = proxy->lowerX; x <= proxy->upperX; ++x)
+		{
+			RemoveEntry(x, y, proxyId);
+		}
+	}
+}
+
+int32 b2GridBroadPhase::CreateProxy(const b2AABB& aabb, void* userData, bool isStatic)
+{
+	int32 proxyId = AllocateProxy();
+	b2GridProxy* proxy = m_proxies + proxyId;
+
+	// Fatten the aabb.
+	b2Vec2 r(b2_aabbExtension, b2_aabbExtension);
+	proxy->aabb.lowerBound = aabb.lowerBound - r;
+	proxy->aabb.upperBound = aabb.upperBound + r;
+	proxy->userData = userData;
+	if (isStatic)
+	{
+		proxy->flags |= b2GridProxy::e_staticFlag;
+	}
+
+	InsertProxy(proxyId);
+	++m_proxyCount;
+	BufferMove(proxyId);
+	return proxyId;
+}
+
+void b2GridBroadPhase::DestroyProxy(int32 proxyId)
+{
+	b2Assert(0 <= proxyId && proxyId < m_proxyCapacity);
+	b2Assert((m_proxies[proxyId].flags & b2GridProxy::e_freeFlag) == 0);
+
+	UnBufferMove(proxyId);
+	RemoveProxy(proxyId);
+	--m_proxyCount;
+	FreeProxy(proxyId);
+}
+
+void b2GridBroadPhase::MoveProxy(int32 proxyId, const b2AABB& aabb, const b2Vec2& displacement)
+{
+	b2Assert(0 <= proxyId && proxyId < m_proxyCapacity);
+	b2GridProxy* proxy = m_proxies + proxyId;
+	b2Assert((proxy->flags & b2GridProxy::e_freeFlag) == 0);
+
+	if (proxy->aabb.Contains(aabb))
+	{
+		return;
+	}
+
+	b2AABB fatAABB = ComputeFatAABB(aabb, displacement);
+
+	// The cells only change when the fat AABB crosses a cell border.
+	if (GetCell(fatAABB.lowerBound.x) != proxy->lowerX || GetCell(fatAABB.lowerBound.y) != proxy->lowerY ||
+		GetCell(fatAABB.upperBound.x) != proxy->upperX || GetCell(fatAABB.upperBound.y) != proxy->upperY)
+	{
+		RemoveProxy(proxyId);
+		proxy->aabb = fatAABB;
+		InsertProxy(proxyId);
+	}
+	else
+	{
+		proxy->aabb = fatAABB;
+	}
+
+	BufferMove(proxyId);
+}
+
+// The cells are fixed in space, so proxies that end up over other cells are
+// added to them again.
+void b2GridBroadPhase::ShiftOrigin(const b2Vec2& newOrigin)
+{
+	for (int32 i = 0; i < m_proxyCapacity; ++i)
+	{
+		b2GridProxy* proxy = m_proxies + i;
+		if (proxy->flags & b2GridProxy::e_freeFlag)
+		{
+			continue;
+		}
+
+		b2AABB aabb;
+		aabb.lowerBound = proxy->aabb.lowerBound - newOrigin;
+		aabb.upperBound = proxy->aabb.upperBound - newOrigin;
+
+		if (GetCell(aabb.lowerBound.x) != proxy->lowerX || GetCell(aabb.lowerBound.y) != proxy->lowerY ||
+			GetCell(aabb.upperBound.x) != proxy->upperX || GetCell(aabb.upperBound.y) != proxy->upperY)
+		{
+			RemoveProxy(i);
+			proxy->aabb = aabb;
+			InsertProxy(i);
+		}
+		else
+		{
+			proxy->aabb = aabb;
+		}
+	}
+}
+
+void b2GridBroadPhase::FindPairs(int32 proxyId)
+{
+	const b2GridProxy* proxy = m_proxies + proxyId;
+	bool isStatic = (proxy->flags & b2GridProxy::e_staticFlag) != 0;
+
+	// A large proxy is tested against all other proxies.
+	if (proxy->flags & b2GridProxy::e_largeFlag)
+	{
+		for (int32 otherId = 0; otherId < m_proxyCapacity; ++otherId)
+		{
+			const b2GridProxy* other = m_proxies + otherId;
+			if (otherId == proxyId || (other->flags & b2GridProxy::e_freeFlag))
+			{
+				continue;
+			}
+
+			// Static proxies do not pair with each other.
+			if (isStatic && (other->flags & b2GridProxy::e_staticFlag))
+			{
+				continue;
+			}
+
+			if (b2TestOverlap(proxy->aabb, other->aabb))
+			{
+				m_pairBuffer.AddPair(proxyId, otherId);
+			}
+		}
+		return;
+	}
+
+	for (int32 y = proxy->lowerY; y <= proxy->upperY; ++y)
+	{
+		for (int32 x = proxy->lowerX; x <= proxy->upperX; ++x)
+		{
+			for (int32 index = m_buckets[GetBucket(x, y)]; index != e_nullProxy; index = m_entries[index].next)
+			{
+				const b2GridEntry* entry = m_entries + index;
+				if (entry->x != x || entry->y != y || entry->proxyId == proxyId)
+				{
+					continue;
+				}
+
+				// Only test a pair in the first cell both proxies cover.
+				const b2GridProxy* other = m_proxies + entry->proxyId;
+				if (x != b2Max(proxy->lowerX, other->lowerX) || y != b2Max(proxy->lowerY, other->lowerY))
+				{
+					continue;
+				}
+
+				if (isStatic && (other->flags & b2GridProxy::e_staticFlag))
+				{
+					continue;
+				}
+
+				if (b2TestOverlap(proxy->aabb, other->aabb))
+				{
+					m_pairBuffer.AddPair(proxyId, entry->proxyId);
+				}
+			}
+		}
+	}
+
+	for (int32 i = 0; i < m_largeProxyCount; ++i)
+	{
+		int32 otherId = m_largeProxies[i];
+		const b2GridProxy* other = m_proxies + otherId;
+		if (isStatic && (other->flags & b2GridProxy::e_staticFlag))
+		{
+			continue;
+		}
+
+		if (b2TestOverlap(proxy->aabb, other->aabb))
+		{
+			m_pairBuffer.AddPair(proxyId, otherId);
+		}
+	}
+}
+
+void b2GridBroadPhase::UpdatePairs(b2PairCallback* callback)
+{
+	m_pairBuffer.count = 0;
+
+	for (int32 i = 0; i < m_moveCount; ++i)
+	{
+		if (m_moveBuffer[i] != e_nullProxy)
+		{
+			FindPairs(m_moveBuffer[i]);
+		}
+	}
+
+	// Reset move buffer
+	m_moveCount = 0;
+
+	// Send the pairs back to the client in order.
+	m_pairBuffer.Sort();
+	for (int32 i = 0; i < m_pairBuffer.count; ++i)
+	{
+		const b2Pair* pair = m_pairBuffer.pairs + i;
+		callback->AddPair(m_proxies[pair->proxyIdA].userData, m_proxies[pair->proxyIdB].userData);
+	}
+}
+
+void b2GridBroadPhase::QueryProxies(b2ProxyQueryCallback* callback, const b2AABB& aabb) const
+{
+	int32 lowerX = GetCell(aabb.lowerBound.x);
+	int32 lowerY = GetCell(aabb.lowerBound.y);
+	int32 upperX = GetCell(aabb.upperBound.x);
+	int32 upperY = GetCell(aabb.upperBound.y);
+
+	// Visiting all proxies is quicker than visiting many cells.
+	int32 width = upperX - lowerX + 1;
+	int32 height = upperY - lowerY + 1;
+	if (width > e_maxProxyCells || height > e_maxProxyCells || width * height > e_maxProxyCells)
+	{
+		for (int32 proxyId = 0; proxyId < m_proxyCapacity; ++proxyId)
+		{
+			const b2GridProxy* proxy = m_proxies + proxyId;
+			if ((proxy->flags & b2GridProxy::e_freeFlag) == 0 && b2TestOverlap(proxy->aabb, aabb))
+			{
+				bool proceed = callback->QueryCallback(proxyId);
+				if (proceed == false)
+				{
+					return;
+				}
+			}
+		}
+		return;
+	}
+
+	for (int32 y = lowerY; y <= upperY; ++y)
+	{
+		for (int32 x = lowerX; x <= upperX; ++x)
+		{
+			for (int32 index = m_buckets[GetBucket(x, y)]; index != e_nullProxy; index = m_entries[index].next)
+			{
+				const b2GridEntry* entry = m_entries + index;
+				if (entry->x != x || entry->y != y)
+				{
+					continue;
+				}
+
+				// Only report a proxy in the first cell it shares with the query.
+				const b2GridProxy* proxy = m_proxies + entry->proxyId;
+				if (x != b2Max(lowerX, proxy->lowerX) || y != b2Max(lowerY, proxy->lowerY))
+				{
+					continue;
+				}
+
+				if (b2TestOverlap(proxy->aabb, aabb))
+				{
+					bool proceed = callback->QueryCallback(entry->proxyId);
+					if (proceed == false)
+					{
+						return;
+					}
+				}
+			}
+		}
+	}
+
+	for (int32 i = 0; i < m_largeProxyCount; ++i)
+	{
+		int32 proxyId = m_largeProxies[i];
+		if (b2TestOverlap(m_proxies[proxyId].aabb, aabb))
+		{
+			bool proceed = callback->QueryCallback(proxyId);
+			if (proceed == false)
+			{
+				return;
+			}
+		}
+	}
+}
+
+void b2GridBroadPhase::RayCastProxies(b2ProxyRayCastCallback* callback, const b2RayCastInput& input) const
+{
+	b2Vec2 p1 = input.p1;
+	b2Vec2 p2 = input.p2;
+	b2Vec2 d = p2 - p1;
+	b2Vec2 r = d;
+	b2Assert(r.LengthSquared() > 0.0f);
+	r.Normalize();
+
+	// v is perpendicular to the segment.
+	b2Vec2 v = b2Cross(1.0f, r);
+	b2Vec2 abs_v = b2Abs(v);
+
+	float32 maxFraction = input.maxFraction;
+
+	// Build a bounding box for the segment.
+	b2AABB segmentAABB;
+	{
+		b2Vec2 t = p1 + maxFraction * d;
+		segmentAABB.lowerBound = b2Min(p1, t);
+		segmentAABB.upperBound = b2Max(p1, t);
+	}
+
+	for (int32 i = 0; i < m_largeProxyCount; ++i)
+	{
+		int32 proxyId = m_largeProxies[i];
+		if (b2RayCastProxy(callback, input, proxyId, m_proxies[proxyId].aabb, v, abs_v, &maxFraction, &segmentAABB) == false)
+		{
+			return;
+		}
+	}
+
+	// Walk the cells along the ray. The t values are fractions of the ray
+	// where it crosses the next cell border on each axis.
+	int32 x = GetCell(p1.x);
+	int32 y = GetCell(p1.y);
+	int32 stepX = d.x > 0.0f ? 1 : (d.x < 0.0f ? -1 : 0);
+	int32 stepY = d.y > 0.0f ? 1 : (d.y < 0.0f ? -1 : 0);
+	float32 deltaX = stepX != 0 ? m_cellSize / b2Abs(d.x) : b2_maxFloat;
+	float32 deltaY = stepY != 0 ? m_cellSize / b2Abs(d.y) : b2_maxFloat;
+	float32 nextX = stepX != 0 ? ((x + (stepX > 0 ? 1 : 0)) * m_cellSize - p1.x) / d.x : b2_maxFloat;
+	float32 nextY = stepY != 0 ? ((y + (stepY > 0 ? 1 : 0)) * m_cellSize - p1.y) / d.y : b2_maxFloat;
+
+	// The cells of a proxy along the ray follow each other, so a proxy is
+	// only tested in the first of its cells.
+	int32 previousX = x - stepX;
+	int32 previousY = y - stepY;
+	bool first = true;
+
+	for (;;)
+	{
+		for (int32 index = m_buckets[GetBucket(x, y)]; index != e_nullProxy; index = m_entries[index].next)
+		{
+			const b2GridEntry* entry = m_entries + index;
+			if (entry->x != x || entry->y != y)
+			{
+				continue;
+			}
+
+			const b2GridProxy* proxy = m_proxies + entry->proxyId;
+			if (first == false &&
+				proxy->lowerX <= previousX && previousX <= proxy->upperX &&
+				proxy->lowerY <= previousY && previousY <= proxy->upperY)
+			{
+				continue;
+			}
+
+			if (b2RayCastProxy(callback, input, entry->proxyId, proxy->aabb, v, abs_v, &maxFraction, &segmentAABB) == false)
+			{
+				return;
+			}
+		}
+
+		first = false;
+		previousX = x;
+		previousY = y;
+
+		// Step to the next cell unless the ray ends in this one.
+		if (nextX < nextY)
+		{
+			if (nextX > maxFraction)
+			{
+				break;
+			}
+
+			x += stepX;
+			nextX += deltaX;
+		}
+		else
+		{
+			if (nextY > maxFraction)
+			{
+				break;
+			}
+
+			y += stepY;
+			nextY += deltaY;
+		}
+	}
+}
@@ -0,0 +1,150 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_GRID_BROAD_PHASE_H
+#define B2_GRID_BROAD_PHASE_H
+
+#include <Box2D/Collision/b2BroadPhase.h>
+
+/// A proxy of the grid broad-phase. The cell range covers the fat AABB.
+struct b2GridProxy
+{
+	enum
+	{
+		e_staticFlag	= 0x0001,
+		e_largeFlag		= 0x0002,
+		e_freeFlag		= 0x0004,
+	};
+
+	b2AABB aabb;
+	void* userData;
+
+	int32 lowerX, lowerY;
+	int32 upperX, upperY;
+
+	// Index in the large proxies, or the next free proxy.
+	int32 largeIndex;
+	int32 next;
+
+	uint16 flags;
+};
+
+/// A proxy in one cell of the grid. The entries of the cells that hash to
+/// the same bucket are linked.
+struct b2GridEntry
+{
+	int32 x, y;
+	int32 proxyId;
+	int32 next;
+};
+
+/// A uniform grid broad-phase. Each proxy is added to the cells its fat AABB
+/// covers, kept in a hash table so the grid has no bounds. Pairs and queries
+/// only look at the proxies in the same cells. Proxies that cover too many
+/// cells, such as the ground, are kept in a list that is tested against all.
+///
+/// This is cheap when the proxies are of similar size and the cell size is
+/// about the size of a typical proxy.
+class b2GridBroadPhase : public b2BroadPhase
+{
+public:
+
+	enum
+	{
+		e_maxProxyCells = 64
+	};
+
+	/// @param cellSize the width and height of a cell in meters.
+	b2GridBroadPhase(float32 cellSize);
+	~b2GridBroadPhase();
+
+	int32 CreateProxy(const b2AABB& aabb, void* userData, bool isStatic);
+	void DestroyProxy(int32 proxyId);
+	void MoveProxy(int32 proxyId, const b2AABB& aabb, const b2Vec2& displacement);
+	const b2AABB& GetFatAABB(int32 proxyId) const;
+	void* GetUserData(int32 proxyId) const;
+	void UpdatePairs(b2PairCallback* callback);
+	void ShiftOrigin(const b2Vec2& newOrigin);
+
+	/// Get the width and height of a cell.
+	float32 GetCellSize() const;
+
+protected:
+
+	void QueryProxies(b2ProxyQueryCallback* callback, const b2AABB& aabb) const;
+	void RayCastProxies(b2ProxyRayCastCallback* callback, const b2RayCastInput& input) const;
+
+private:
+
+	int32 AllocateProxy();
+	void FreeProxy(int32 proxyId);
+
+	int32 GetCell(float32 x) const;
+	int32 GetBucket(int32 x, int32 y) const;
+
+	// Add a proxy to the cells of its fat AABB, or to the large proxies.
+	void InsertProxy(int32 proxyId);
+	void RemoveProxy(int32 proxyId);
+
+	void AddEntry(int32 x, int32 y, int32 proxyId);
+	void RemoveEntry(int32 x, int32 y, int32 proxyId);
+	void Rehash(int32 bucketCount);
+
+	void FindPairs(int32 proxyId);
+
+	float32 m_cellSize;
+	float32 m_inverseCellSize;
+
+	b2GridProxy* m_proxies;
+	int32 m_proxyCapacity;
+	int32 m_freeProxyList;
+
+	b2GridEntry* m_entries;
+	int32 m_entryCount;
+	int32 m_entryCapacity;
+	int32 m_freeEntryList;
+
+	// The first entry of each bucket. The count is a power of two.
+	int32* m_buckets;
+	int32 m_bucketCount;
+
+	int32* m_largeProxies;
+	int32 m_largeProxyCount;
+	int32 m_largeProxyCapacity;
+
+	b2PairBuffer m_pairBuffer;
+};
+
+inline void* b2GridBroadPhase::GetUserData(int32 proxyId) const
+{
+	b2Assert(0 <= proxyId && proxyId < m_proxyCapacity);
+	return m_proxies[proxyId].userData;
+}
+
+inline const b2AABB& b2GridBroadPhase::GetFatAABB(int32 proxyId) const
+{
+	b2Assert(0 <= proxyId && proxyId < m_proxyCapacity);
+	return m_proxies[proxyId].aabb;
+}
+
+inline float32 b2GridBroadPhase::GetCellSize() const
+{
+	return m_cellSize;
+}
+
+#endif
@@ -0,0 +1,432 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Collision/b2SweepBroadPhase.h>
+#include <cstring>
+
+b2SweepBroadPhase::b2SweepBroadPhase() : b2BroadPhase(b2_sweepBroadPhase)
+{
+	m_proxyCapacity = 0;
+	m_proxies = NULL;
+	m_order = NULL;
+	m_freeList = e_nullProxy;
+
+	m_maxWidth = 0.0f;
+	m_maxWidthExact = true;
+
+	m_pairBuffer.capacity = 16;
+	m_pairBuffer.count = 0;
+	m_pairBuffer.pairs = (b2Pair*)b2Alloc(m_pairBuffer.capacity * sizeof(b2Pair));
+}
+
+b2SweepBroadPhase::~b2SweepBroadPhase()
+{
+	b2Free(m_proxies);
+	b2Free(m_order);
+	b2Free(m_pairBuffer.pairs);
+}
+
+int32 b2SweepBroadPhase::AllocateProxy()
+{
+	// Expand the proxy pool as needed.
+	if (m_freeList == e_nullProxy)
+	{
+		int32 oldCapacity = m_proxyCapacity;
+		b2SweepProxy* oldProxies = m_proxies;
+		int32* oldOrder = m_order;
+		m_proxyCapacity = b2Max(2 * oldCapacity, 16);
+		m_proxies = (b2SweepProxy*)b2Alloc(m_proxyCapacity * sizeof(b2SweepProxy));
+		m_order = (int32*)b2Alloc(m_proxyCapacity * sizeof(int32));
+		if (oldCapacity > 0)
+		{
+			memcpy(m_proxies, oldProxies, oldCapacity * sizeof(b2SweepProxy));
+			memcpy(m_order, oldOrder, m_proxyCount * sizeof(int32));
+		}
+		b2Free(oldProxies);
+		b2Free(oldOrder);
+
+		// Build a linked list for the free list.
+		for (int32 i = oldCapacity; i < m_proxyCapacity; ++i)
+		{
+			m_proxies[i].next = i + 1 < m_proxyCapacity ? i + 1 : e_nullProxy;
+			m_proxies[i].flags = b2SweepProxy::e_freeFlag;
+		}
+		m_freeList = oldCapacity;
+	}
+
+	int32 proxyId = m_freeList;
+	m_freeList = m_proxies[proxyId].next;
+	m_proxies[proxyId].next = e_nullProxy;
+	m_proxies[proxyId].flags = 0;
+	return proxyId;
+}
+
+void b2SweepBroadPhase::FreeProxy(int32 proxyId)
+{
+	m_proxies[proxyId].next = m_freeList;
+	m_proxies[proxyId].flags = b2SweepProxy::e_freeFlag;
+	m_freeList = proxyId;
+}
+
+int32 b2SweepBroadPhase::CreateProxy(const b2AABB& aabb, void* userData, bool isStatic)
+{
+	int32 proxyId = AllocateProxy();
+	b2SweepProxy* proxy = m_proxies + proxyId;
+
+	// Fatten the aabb.
+	b2Vec2 r(b2_aabbExtension, b2_aabbExtension);
+	proxy->aabb.lowerBound = aabb.lowerBound - r;
+	proxy->aabb.upperBound = aabb.upperBound + r;
+	proxy->userData = userData;
+	if (isStatic)
+	{
+		proxy->flags |= b2SweepProxy::e_staticFlag;
+	}
+
+	m_maxWidth = b2Max(m_maxWidth, proxy->aabb.upperBound.x - proxy->aabb.lowerBound.x);
+
+	// Start at the end of the order.
+	SetOrder(m_proxyCount, proxyId);
+	++m_proxyCount;
+	Sort(proxyId);
+
+	BufferMove(proxyId);
+	return proxyId;
+}
+
+void b2SweepBroadPhase::DestroyProxy(int32 proxyId)
+{
+	b2Assert(0 <= proxyId && proxyId < m_proxyCapacity);
+	b2SweepProxy* proxy = m_proxies + proxyId;
+	b2Assert((proxy->flags & b2SweepProxy::e_freeFlag) == 0);
+
+	UnBufferMove(proxyId);
+
+	if (proxy->aabb.upperBound.x - proxy->aabb.lowerBound.x >= m_maxWidth)
+	{
+		m_maxWidthExact = false;
+	}
+
+	// Close the gap in the order.
+	--m_proxyCount;
+	for (int32 i = proxy->orderIndex; i < m_proxyCount; ++i)
+	{
+		SetOrder(i, m_order[i + 1]);
+	}
+
+	FreeProxy(proxyId);
+}
+
+void b2SweepBroadPhase::MoveProxy(int32 proxyId, const b2AABB& aabb, const b2Vec2& displacement)
+{
+	b2Assert(0 <= proxyId && proxyId < m_proxyCapacity);
+	b2SweepProxy* proxy = m_proxies + proxyId;
+	b2Assert((proxy->flags & b2SweepProxy::e_freeFlag) == 0);
+
+	if (proxy->aabb.Contains(aabb))
+	{
+		return;
+	}
+
+	float32 oldWidth = proxy->aabb.upperBound.x - proxy->aabb.lowerBound.x;
+	proxy->aabb = ComputeFatAABB(aabb, displacement);
+	float32 width = proxy->aabb.upperBound.x - proxy->aabb.lowerBound.x;
+
+	if (width >= m_maxWidth)
+	{
+		m_maxWidth = width;
+	}
+	else if (oldWidth >= m_maxWidth)
+	{
+		m_maxWidthExact = false;
+	}
+
+	Sort(proxyId);
+	BufferMove(proxyId);
+}
+
+// Translating every lower bound by the same amount keeps them in order. The
+// widths may round differently, so the widest is found again.
+void b2SweepBroadPhase::ShiftOrigin(const b2Vec2& newOrigin)
+{
+	m_maxWidth = 0.0f;
+	for (int32 i = 0; i < m_proxyCount; ++i)
+	{
+		b2AABB& aabb = m_proxies[m_order[i]].aabb;
+		aabb.lowerBound -= newOrigin;
+		aabb.upperBound -= newOrigin;
+		m_maxWidth = b2Max(m_maxWidth, aabb.upperBound.x - aabb.lowerBound.x);
+	}
+	m_maxWidthExact = true;
+}
+
+void b2SweepBroadPhase::SetOrder(int32 index, int32 proxyId)
+{
+	m_order[index] = proxyId;
+	m_proxies[proxyId].orderIndex = index;
+}
+
+void b2SweepBroadPhase::Sort(int32 proxyId)
+{
+	int32 index = m_proxies[proxyId].orderIndex;
+	float32 x = m_proxies[proxyId].aabb.lowerBound.x;
+
+	while (index > 0 && m_proxies[m_order[index - 1]].aabb.lowerBound.x > x)
+	{
+		SetOrder(index, m_order[index - 1]);
+		--index;
+	}
+
+	while (index + 1 < m_proxyCount && m_proxies[m_order[index + 1]].aabb.lowerBound.x < x)
+	{
+		SetOrder(index, m_order[index + 1]);
+		++index;
+	}
+
+	SetOrder(index, proxyId);
+}
+
+int32 b2SweepBroadPhase::FindUpper(float32 x) const
+{
+	int32 low = 0;
+	int32 high = m_proxyCount;
+	while (low < high)
+	{
+		int32 mid = (low + high) / 2;
+		if (m_proxies[m_order[mid]].aabb.lowerBound.x > x)
+		{
+			high = mid;
+		}
+		else
+		{
+			low = mid + 1;
+		}
+	}
+	return low;
+}
+
+int32 b2SweepBroadPhase::FindLower(float32 x) const
+{
+	int32 low = 0;
+	int32 high = m_proxyCount;
+	while (low < high)
+	{
+		int32 mid = (low + high) / 2;
+		if (m_proxies[m_order[mid]].aabb.lowerBound.x >= x)
+		{
+			high = mid;
+		}
+		else
+		{
+			low = mid + 1;
+		}
+	}
+	return low;
+}
+
+void b2SweepBroadPhase::UpdatePairs(b2PairCallback* callback)
+{
+	if (m_maxWidthExact == false)
+	{
+		m_maxWidth = 0.0f;
+		for (int32 i = 0; i < m_proxyCount; ++i)
+		{
+			const b2AABB& aabb = m_proxies[m_order[i]].aabb;
+			m_maxWidth = b2Max(m_maxWidth, aabb.upperBound.x - aabb.lowerBound.x);
+		}
+		m_maxWidthExact = true;
+	}
+
+	m_pairBuffer.count = 0;
+
+	for (int32 i = 0; i < m_moveCount; ++i)
+	{
+		int32 proxyId = m_moveBuffer[i];
+		if (proxyId == e_nullProxy)
+		{
+			continue;
+		}
+
+		const b2SweepProxy* proxy = m_proxies + proxyId;
+		bool isStatic = (proxy->flags & b2SweepProxy::e_staticFlag) != 0;
+
+		// Sweep to the left. A proxy that starts further left than the widest
+		// proxy cannot reach this one.
+		float32 lowerX = proxy->aabb.lowerBound.x - m_maxWidth;
+		for (int32 j = proxy->orderIndex - 1; j >= 0; --j)
+		{
+			int32 otherId = m_order[j];
+			const b2SweepProxy* other = m_proxies + otherId;
+			if (other->aabb.lowerBound.x < lowerX)
+			{
+				break;
+			}
+
+			// Static proxies do not pair with each other.
+			if (isStatic && (other->flags & b2SweepProxy::e_staticFlag))
+			{
+				continue;
+			}
+
+			if (b2TestOverlap(proxy->aabb, other->aabb))
+			{
+				m_pairBuffer.AddPair(proxyId, otherId);
+			}
+		}
+
+		// Sweep to the right until the proxies start past this one.
+		float32 upperX = proxy->aabb.upperBound.x;
+		for (int32 j = proxy->orderIndex + 1; j < m_proxyCount; ++j)
+		{
+			int32 otherId = m_order[j];
+			const b2SweepProxy* other = m_proxies + otherId;
+			if (other->aabb.lowerBound.x > upperX)
+			{
+				break;
+			}
+
+			if (isStatic && (other->flags & b2SweepProxy::e_staticFlag))
+			{
+				continue;
+			}
+
+			if (b2TestOverlap(proxy->aabb, other->aabb))
+			{
+				m_pairBuffer.AddPair(proxyId, otherId);
+			}
+		}
+	}
+
+	// Reset move buffer
+	m_moveCount = 0;
+
+	// Send the pairs back to the client in order.
+	m_pairBuffer.Sort();
+	for (int32 i = 0; i < m_pairBuffer.count; ++i)
+	{
+		const b2Pair* pair = m_pairBuffer.pairs + i;
+		callback->AddPair(m_proxies[pair->proxyIdA].userData, m_proxies[pair->proxyIdB].userData);
+	}
+}
+
+void b2SweepBroadPhase::QueryProxies(b2ProxyQueryCallback* callback, const b2AABB& aabb) const
+{
+	float32 lowerX = aabb.lowerBound.x - m_maxWidth;
+	for (int32 i = FindUpper(aabb.upperBound.x) - 1; i >= 0; --i)
+	{
+		int32 proxyId = m_order[i];
+		const b2SweepProxy* proxy = m_proxies + proxyId;
+		if (proxy->aabb.lowerBound.x < lowerX)
+		{
+			break;
+		}
+
+		if (b2TestOverlap(proxy->aabb, aabb))
+		{
+			bool proceed = callback->QueryCallback(proxyId);
+			if (proceed == false)
+			{
+				return;
+			}
+		}
+	}
+}
+
+void b2SweepBroadPhase::RayCastProxies(b2ProxyRayCastCallback* callback, const b2RayCastInput& input) const
+{
+	b2Vec2 p1 = input.p1;
+	b2Vec2 p2 = input.p2;
+	b2Vec2 r = p2 - p1;
+	b2Assert(r.LengthSquared() > 0.0f);
+	r.Normalize();
+
+	// v is perpendicular to the segment.
+	b2Vec2 v = b2Cross(1.0f, r);
+	b2Vec2 abs_v = b2Abs(v);
+
+	float32 maxFraction = input.maxFraction;
+
+	// Build a bounding box for the segment.
+	b2AABB segmentAABB;
+	{
+		b2Vec2 t = p1 + maxFraction * (p2 - p1);
+		segmentAABB.lowerBound = b2Min(p1, t);
+		segmentAABB.upperBound = b2Max(p1, t);
+	}
+
+	// Sweep in the direction of the ray, so that clipping the ray cuts the
+	// sweep short.
+	int32 begin = FindLower(segmentAABB.lowerBound.x - m_maxWidth);
+	int32 end = FindUpper(segmentAABB.upperBound.x);
+	int32 step = r.x < 0.0f ? -1 : 1;
+	int32 first = step > 0 ? begin : end - 1;
+	int32 last = step > 0 ? end : begin - 1;
+
+	for (int32 i = first; i != last; i += step)
+	{
+		int32 proxyId = m_order[i];
+		const b2SweepProxy* proxy = m_proxies + proxyId;
+
+		if (step > 0 && proxy->aabb.lowerBound.x > segmentAABB.upperBound.x)
+		{
+			break;
+		}
+
+		if (step < 0 && proxy->aabb.lowerBound.x < segmentAABB.lowerBound.x - m_maxWidth)
+		{
+			break;
+		}
+
+		if (b2TestOverlap(proxy->aabb, segmentAABB) == false)
+		{
+			continue;
+		}
+
+		// Separating axis for segment (Gino, p80).
+		// |dot(v, p1 - c)| > dot(|v|, h)
+		b2Vec2 c = proxy->aabb.GetCenter();
+		b2Vec2 h = proxy->aabb.GetExtents();
+		float32 separation = b2Abs(b2Dot(v, p1 - c)) - b2Dot(abs_v, h);
+		if (separation > 0.0f)
+		{
+			continue;
+		}
+
+		b2RayCastInput subInput;
+		subInput.p1 = input.p1;
+		subInput.p2 = input.p2;
+		subInput.maxFraction = maxFraction;
+
+		float32 value = callback->RayCastCallback(subInput, proxyId);
+
+		if (value == 0.0f)
+		{
+			// The client has terminated the ray cast.
+			return;
+		}
+
+		if (value > 0.0f)
+		{
+			// Update segment bounding box.
+			maxFraction = value;
+			b2Vec2 t = p1 + maxFraction * (p2 - p1);
+			segmentAABB.lowerBound = b2Min(p1, t);
+			segmentAABB.upperBound = b2Max(p1, t);
+		}
+	}
+}
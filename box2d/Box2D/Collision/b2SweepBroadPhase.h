@@ -0,0 +1,113 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_SWEEP_BROAD_PHASE_H
+#define B2_SWEEP_BROAD_PHASE_H
+
+#include <Box2D/Collision/b2BroadPhase.h>
+
+/// A proxy of the sweep-and-prune broad-phase.
+struct b2SweepProxy
+{
+	enum
+	{
+		e_staticFlag	= 0x0001,
+		e_freeFlag		= 0x0002,
+	};
+
+	b2AABB aabb;
+	void* userData;
+
+	// Position in the sorted order, or the next free proxy.
+	int32 orderIndex;
+	int32 next;
+
+	uint16 flags;
+};
+
+/// A sweep-and-prune broad-phase. The proxies are kept sorted on the lower
+/// bound of their fat AABB along the x-axis. A proxy that moves is shifted
+/// to its new place, which takes a few swaps when the motion is coherent.
+/// Pairs are found by sweeping the sorted proxies next to a moved proxy.
+///
+/// This is cheap for worlds that are spread out along the x-axis, such as side
+/// scrollers. Many proxies stacked above each other make the sweeps long.
+class b2SweepBroadPhase : public b2BroadPhase
+{
+public:
+
+	b2SweepBroadPhase();
+	~b2SweepBroadPhase();
+
+	int32 CreateProxy(const b2AABB& aabb, void* userData, bool isStatic);
+	void DestroyProxy(int32 proxyId);
+	void MoveProxy(int32 proxyId, const b2AABB& aabb, const b2Vec2& displacement);
+	const b2AABB& GetFatAABB(int32 proxyId) const;
+	void* GetUserData(int32 proxyId) const;
+	void UpdatePairs(b2PairCallback* callback);
+	void ShiftOrigin(const b2Vec2& newOrigin);
+
+protected:
+
+	void QueryProxies(b2ProxyQueryCallback* callback, const b2AABB& aabb) const;
+	void RayCastProxies(b2ProxyRayCastCallback* callback, const b2RayCastInput& input) const;
+
+private:
+
+	int32 AllocateProxy();
+	void FreeProxy(int32 proxyId);
+
+	// Get the first position in the order with a lower bound above x.
+	int32 FindUpper(float32 x) const;
+
+	// Get the first position in the order with a lower bound at or above x.
+	int32 FindLower(float32 x) const;
+
+	// Shift a proxy to its place in the order after its lower bound changed.
+	void Sort(int32 proxyId);
+
+	void SetOrder(int32 index, int32 proxyId);
+
+	b2SweepProxy* m_proxies;
+	int32 m_proxyCapacity;
+	int32 m_freeList;
+
+	// Proxy ids sorted on the lower bound along the x-axis.
+	int32* m_order;
+
+	// No proxy is wider than this along the x-axis. The width is only
+	// recomputed when the widest proxy may have shrunk.
+	float32 m_maxWidth;
+	bool m_maxWidthExact;
+
+	b2PairBuffer m_pairBuffer;
+};
+
+inline void* b2SweepBroadPhase::GetUserData(int32 proxyId) const
+{
+	b2Assert(0 <= proxyId && proxyId < m_proxyCapacity);
+	return m_proxies[proxyId].userData;
+}
+
+inline const b2AABB& b2SweepBroadPhase::GetFatAABB(int32 proxyId) const
+{
+	b2Assert(0 <= proxyId && proxyId < m_proxyCapacity);
+	return m_proxies[proxyId].aabb;
+}
+
+#endif
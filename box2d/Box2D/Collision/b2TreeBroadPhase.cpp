@@ -0,0 +1,366 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Collision/b2TreeBroadPhase.h>
+#include <Box2D/Common/b2TaskScheduler.h>
+
+// Queries the trees for a range of moved proxies, adding the pairs to the
+// buffer of the executing thread.
+class b2FindPairsTask : public b2Task
+{
+public:
+	b2FindPairsTask(b2TreeBroadPhase* broadPhase) : m_broadPhase(broadPhase) {}
+
+	void Execute(int32 begin, int32 end, int32 threadIndex)
+	{
+		b2TreePairBuffer* buffer = m_broadPhase->m_pairBuffers + threadIndex;
+		const b2ProxyTree* trees = m_broadPhase->m_trees;
+
+		for (int32 i = begin; i < end; ++i)
+		{
+			buffer->queryProxyId = m_broadPhase->m_moveBuffer[i];
+			if (buffer->queryProxyId == b2BroadPhase::e_nullProxy)
+			{
+				continue;
+			}
+
+			// We have to query the tree with the fat AABB so that
+			// we don't fail to create a pair that may touch later.
+			const b2AABB& fatAABB = m_broadPhase->GetFatAABB(buffer->queryProxyId);
+
+			// Query the moving proxies, create pairs and add them pair buffer.
+			buffer->queryTree = b2TreeBroadPhase::e_movingTree;
+			trees[b2TreeBroadPhase::e_movingTree].Query(buffer, fatAABB);
+
+			// Static proxies do not pair with each other.
+			if (b2TreeBroadPhase::GetTreeIndex(buffer->queryProxyId) != b2TreeBroadPhase::e_staticTree)
+			{
+				buffer->queryTree = b2TreeBroadPhase::e_staticTree;
+				trees[b2TreeBroadPhase::e_staticTree].Query(buffer, fatAABB);
+			}
+		}
+	}
+
+private:
+	b2TreeBroadPhase* m_broadPhase;
+};
+
+// Sorts the pair buffers of a range of threads.
+class b2SortPairsTask : public b2Task
+{
+public:
+	b2SortPairsTask(b2TreePairBuffer* buffers) : m_buffers(buffers) {}
+
+	void Execute(int32 begin, int32 end, int32 threadIndex)
+	{
+		B2_NOT_USED(threadIndex);
+
+		for (int32 i = begin; i < end; ++i)
+		{
+			m_buffers[i].Sort();
+		}
+	}
+
+private:
+	b2TreePairBuffer* m_buffers;
+};
+
+// Reports the proxies of one tree with the ids of the broad-phase, and keeps
+// track of how far a ray cast has been clipped.
+template <typename T>
+struct b2ProxyTreeCallback
+{
+	bool QueryCallback(int32 proxyId)
+	{
+		bool proceed = callback->QueryCallback((proxyId << 1) | treeIndex);
+		terminated = proceed == false;
+		return proceed;
+	}
+
+	float32 RayCastCallback(const b2RayCastInput& input, int32 proxyId)
+	{
+		float32 value = callback->RayCastCallback(input, (proxyId << 1) | treeIndex);
+		if (value == 0.0f)
+		{
+			terminated = true;
+		}
+		else if (value > 0.0f)
+		{
+			maxFraction = value;
+		}
+		return value;
+	}
+
+	T* callback;
+	int32 treeIndex;
+	float32 maxFraction;
+	bool terminated;
+};
+
+b2TreeBroadPhase::b2TreeBroadPhase() : b2BroadPhase(b2_treeBroadPhase)
+{
+	for (int32 i = 0; i < e_treeCount; ++i)
+	{
+		m_trees[i].wideTreeValid = false;
+	}
+
+	m_pairBuffers = NULL;
+	m_pairBufferCount = 0;
+	m_taskScheduler = NULL;
+	SetTaskScheduler(NULL);
+}
+
+b2TreeBroadPhase::~b2TreeBroadPhase()
+{
+	for (int32 i = 0; i < m_pairBufferCount; ++i)
+	{
+		b2Free(m_pairBuffers[i].pairs);
+	}
+	b2Free(m_pairBuffers);
+}
+
+void b2TreeBroadPhase::SetTaskScheduler(b2TaskScheduler* scheduler)
+{
+	for (int32 i = 0; i < m_pairBufferCount; ++i)
+	{
+		b2Free(m_pairBuffers[i].pairs);
+	}
+	b2Free(m_pairBuffers);
+
+	m_taskScheduler = scheduler;
+	m_pairBufferCount = scheduler ? b2Max(scheduler->GetThreadCount(), 1) : 1;
+	m_pairBuffers = (b2TreePairBuffer*)b2Alloc(m_pairBufferCount * sizeof(b2TreePairBuffer));
+	for (int32 i = 0; i < m_pairBufferCount; ++i)
+	{
+		b2TreePairBuffer* buffer = m_pairBuffers + i;
+		buffer->capacity = 16;
+		buffer->count = 0;
+		buffer->pairs = (b2Pair*)b2Alloc(buffer->capacity * sizeof(b2Pair));
+		buffer->queryProxyId = e_nullProxy;
+		buffer->queryTree = e_movingTree;
+		buffer->head = 0;
+	}
+}
+
+// Find the pairs of all moved proxies. Each pair buffer ends up sorted
+// and free of duplicates, though the same pair may be in several buffers.
+void b2TreeBroadPhase::FindPairs()
+{
+	// The proxies of a batch have to be in the trees to be found.
+	EndBatch();
+
+	// Reset pair buffers
+	for (int32 i = 0; i < m_pairBufferCount; ++i)
+	{
+		m_pairBuffers[i].count = 0;
+		m_pairBuffers[i].head = 0;
+	}
+
+	// Building a wide tree visits every proxy of the tree. For the moving
+	// proxies this only pays off when a good part of them is queried. The
+	// static tree rarely changes, so its wide tree serves many steps.
+	b2ProxyTree* movingTree = m_trees + e_movingTree;
+	if (m_moveCount >= b2_wideTreeMoveFraction * movingTree->tree.GetProxyCount())
+	{
+		movingTree->BuildWideTree();
+	}
+	m_trees[e_staticTree].BuildWideTree();
+
+	// Perform tree queries for all moving proxies.
+	b2FindPairsTask findTask(this);
+	if (m_taskScheduler && m_pairBufferCount > 1)
+	{
+		b2SortPairsTask sortTask(m_pairBuffers);
+		m_taskScheduler->ParallelFor(&findTask, m_moveCount, 64);
+		m_taskScheduler->ParallelFor(&sortTask, m_pairBufferCount, 1);
+	}
+	else
+	{
+		findTask.Execute(0, m_moveCount, 0);
+		m_pairBuffers[0].Sort();
+	}
+
+	// Reset move buffer
+	m_moveCount = 0;
+}
+
+void b2TreeBroadPhase::UpdatePairs(b2PairCallback* callback)
+{
+	// Fill the pair buffers, each sorted and without duplicates.
+	FindPairs();
+
+	// Merge the pair buffers and send the pairs back to the client. This
+	// gives the same order whatever thread found a pair.
+	for (;;)
+	{
+		const b2Pair* primaryPair = NULL;
+		for (int32 i = 0; i < m_pairBufferCount; ++i)
+		{
+			const b2TreePairBuffer* buffer = m_pairBuffers + i;
+			if (buffer->head < buffer->count)
+			{
+				const b2Pair* pair = buffer->pairs + buffer->head;
+				if (primaryPair == NULL || b2PairLessThan(*pair, *primaryPair))
+				{
+					primaryPair = pair;
+				}
+			}
+		}
+
+		if (primaryPair == NULL)
+		{
+			break;
+		}
+
+		void* userDataA = GetUserData(primaryPair->proxyIdA);
+		void* userDataB = GetUserData(primaryPair->proxyIdB);
+
+		callback->AddPair(userDataA, userDataB);
+
+		// Skip the same pair found by other threads.
+		int32 proxyIdA = primaryPair->proxyIdA;
+		int32 proxyIdB = primaryPair->proxyIdB;
+		for (int32 i = 0; i < m_pairBufferCount; ++i)
+		{
+			b2TreePairBuffer* buffer = m_pairBuffers + i;
+			if (buffer->head < buffer->count)
+			{
+				const b2Pair* pair = buffer->pairs + buffer->head;
+				if (pair->proxyIdA == proxyIdA && pair->proxyIdB == proxyIdB)
+				{
+					++buffer->head;
+				}
+			}
+		}
+	}
+}
+
+void b2TreeBroadPhase::QueryProxies(b2ProxyQueryCallback* callback, const b2AABB& aabb) const
+{
+	b2ProxyTreeCallback<b2ProxyQueryCallback> treeCallback;
+	treeCallback.callback = callback;
+	treeCallback.terminated = false;
+
+	for (int32 i = 0; i < e_treeCount && treeCallback.terminated == false; ++i)
+	{
+		treeCallback.treeIndex = i;
+		m_trees[i].Query(&treeCallback, aabb);
+	}
+}
+
+void b2TreeBroadPhase::RayCastProxies(b2ProxyRayCastCallback* callback, const b2RayCastInput& input) const
+{
+	b2ProxyTreeCallback<b2ProxyRayCastCallback> treeCallback;
+	treeCallback.callback = callback;
+	treeCallback.maxFraction = input.maxFraction;
+	treeCallback.terminated = false;
+
+	// Hits in the first tree clip the ray for the second one.
+	for (int32 i = 0; i < e_treeCount && treeCallback.terminated == false; ++i)
+	{
+		b2RayCastInput treeInput = input;
+		treeInput.maxFraction = treeCallback.maxFraction;
+		treeCallback.treeIndex = i;
+		m_trees[i].RayCast(&treeCallback, treeInput);
+	}
+}
+
+void b2ProxyTree::BuildWideTree()
+{
+	if (wideTreeValid == false)
+	{
+		wideTree.Build(tree);
+		wideTreeValid = true;
+	}
+}
+
+void b2TreeBroadPhase::BeginBatch()
+{
+	for (int32 i = 0; i < e_treeCount; ++i)
+	{
+		m_trees[i].tree.BeginBatch();
+	}
+}
+
+// Creating a proxy already dropped the wide tree, so it is left alone here.
+void b2TreeBroadPhase::EndBatch()
+{
+	for (int32 i = 0; i < e_treeCount; ++i)
+	{
+		m_trees[i].tree.EndBatch();
+	}
+}
+
+int32 b2TreeBroadPhase::CreateProxy(const b2AABB& aabb, void* userData, bool isStatic)
+{
+	int32 treeIndex = isStatic ? e_staticTree : e_movingTree;
+	b2ProxyTree* tree = m_trees + treeIndex;
+	int32 proxyId = (tree->tree.CreateProxy(aabb, userData) << 1) | treeIndex;
+	tree->wideTreeValid = false;
+	++m_proxyCount;
+	BufferMove(proxyId);
+	return proxyId;
+}
+
+void b2TreeBroadPhase::DestroyProxy(int32 proxyId)
+{
+	UnBufferMove(proxyId);
+	--m_proxyCount;
+	b2ProxyTree* tree = m_trees + GetTreeIndex(proxyId);
+	tree->tree.DestroyProxy(GetTreeProxyId(proxyId));
+	tree->wideTreeValid = false;
+}
+
+void b2TreeBroadPhase::MoveProxy(int32 proxyId, const b2AABB& aabb, const b2Vec2& displacement)
+{
+	b2ProxyTree* tree = m_trees + GetTreeIndex(proxyId);
+	bool buffer = tree->tree.MoveProxy(GetTreeProxyId(proxyId), aabb, displacement);
+	if (buffer)
+	{
+		BufferMove(proxyId);
+		tree->wideTreeValid = false;
+	}
+}
+
+void b2TreeBroadPhase::ShiftOrigin(const b2Vec2& newOrigin)
+{
+	for (int32 i = 0; i < e_treeCount; ++i)
+	{
+		b2ProxyTree* tree = m_trees + i;
+		tree->tree.ShiftOrigin(newOrigin);
+		if (tree->wideTreeValid)
+		{
+			tree->wideTree.ShiftOrigin(newOrigin);
+		}
+	}
+}
+
+// This is called from b2DynamicTree::Query when we are gathering pairs.
+bool b2TreePairBuffer::QueryCallback(int32 proxyId)
+{
+	proxyId = (proxyId << 1) | queryTree;
+
+	// A proxy cannot form a pair with itself.
+	if (proxyId == queryProxyId)
+	{
+		return true;
+	}
+
+	AddPair(proxyId, queryProxyId);
+	return true;
+}
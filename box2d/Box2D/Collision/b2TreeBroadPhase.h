@@ -0,0 +1,171 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_TREE_BROAD_PHASE_H
+#define B2_TREE_BROAD_PHASE_H
+
+#include <Box2D/Collision/b2BroadPhase.h>
+#include <Box2D/Collision/b2DynamicTree.h>
+#include <Box2D/Collision/b2WideTree.h>
+
+/// Pairs found by one thread while updating pairs.
+struct b2TreePairBuffer : public b2PairBuffer
+{
+	bool QueryCallback(int32 proxyId);
+
+	int32 queryProxyId;
+	int32 queryTree;
+	int32 head;
+};
+
+/// A dynamic tree of the broad-phase and the wide copy used to query it.
+struct b2ProxyTree
+{
+	template <typename T>
+	void Query(T* callback, const b2AABB& aabb) const;
+
+	template <typename T>
+	void RayCast(T* callback, const b2RayCastInput& input) const;
+
+	/// Build the wide copy if the tree changed since the last build.
+	void BuildWideTree();
+
+	b2DynamicTree tree;
+
+	// The wide copy is only used while the tree does not change.
+	b2WideTree wideTree;
+	bool wideTreeValid;
+};
+
+/// A broad-phase that keeps the proxies in dynamic AABB trees. Queries and
+/// ray casts take roughly k * log(n), where k is the number of proxies found
+/// and n the number of proxies. This suits worlds of any size and density.
+///
+/// Static proxies are kept in a tree of their own. It only changes when static
+/// proxies are created, moved or destroyed.
+///
+/// Proxies created in a batch are added to the trees together when the batch
+/// ends. A batch as large as a tree rebuilds it top-down, which is quicker and
+/// gives a better tree than inserting the proxies one by one.
+class b2TreeBroadPhase : public b2BroadPhase
+{
+public:
+
+	enum
+	{
+		e_movingTree = 0,
+		e_staticTree = 1,
+		e_treeCount = 2
+	};
+
+	b2TreeBroadPhase();
+	~b2TreeBroadPhase();
+
+	int32 CreateProxy(const b2AABB& aabb, void* userData, bool isStatic);
+	void DestroyProxy(int32 proxyId);
+	void MoveProxy(int32 proxyId, const b2AABB& aabb, const b2Vec2& displacement);
+	const b2AABB& GetFatAABB(int32 proxyId) const;
+	void* GetUserData(int32 proxyId) const;
+	void UpdatePairs(b2PairCallback* callback);
+	void ShiftOrigin(const b2Vec2& newOrigin);
+
+	/// Compute the height of the highest embedded tree.
+	int32 ComputeHeight() const;
+
+	/// Use a task scheduler to find new pairs on several threads. Each
+	/// thread gets a pair buffer of its own.
+	void SetTaskScheduler(b2TaskScheduler* scheduler);
+
+	void BeginBatch();
+	void EndBatch();
+
+protected:
+
+	void QueryProxies(b2ProxyQueryCallback* callback, const b2AABB& aabb) const;
+	void RayCastProxies(b2ProxyRayCastCallback* callback, const b2RayCastInput& input) const;
+
+private:
+
+	friend class b2FindPairsTask;
+
+	// Proxy ids keep the tree in the lowest bit.
+	static int32 GetTreeIndex(int32 proxyId);
+	static int32 GetTreeProxyId(int32 proxyId);
+
+	void FindPairs();
+
+	b2ProxyTree m_trees[e_treeCount];
+
+	b2TreePairBuffer* m_pairBuffers;
+	int32 m_pairBufferCount;
+
+	b2TaskScheduler* m_taskScheduler;
+};
+
+template <typename T>
+inline void b2ProxyTree::Query(T* callback, const b2AABB& aabb) const
+{
+	if (wideTreeValid)
+	{
+		wideTree.Query(callback, aabb);
+	}
+	else
+	{
+		tree.Query(callback, aabb);
+	}
+}
+
+template <typename T>
+inline void b2ProxyTree::RayCast(T* callback, const b2RayCastInput& input) const
+{
+	if (wideTreeValid)
+	{
+		wideTree.RayCast(callback, input);
+	}
+	else
+	{
+		tree.RayCast(callback, input);
+	}
+}
+
+inline int32 b2TreeBroadPhase::GetTreeIndex(int32 proxyId)
+{
+	return proxyId & 1;
+}
+
+inline int32 b2TreeBroadPhase::GetTreeProxyId(int32 proxyId)
+{
+	return proxyId >> 1;
+}
+
+inline void* b2TreeBroadPhase::GetUserData(int32 proxyId) const
+{
+	return m_trees[GetTreeIndex(proxyId)].tree.GetUserData(GetTreeProxyId(proxyId));
+}
+
+inline const b2AABB& b2TreeBroadPhase::GetFatAABB(int32 proxyId) const
+{
+	return m_trees[GetTreeIndex(proxyId)].tree.GetFatAABB(GetTreeProxyId(proxyId));
+}
+
+inline int32 b2TreeBroadPhase::ComputeHeight() const
+{
+	return b2Max(m_trees[e_movingTree].tree.ComputeHeight(), m_trees[e_staticTree].tree.ComputeHeight());
+}
+
+#endif
@@ -0,0 +1,154 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Collision/b2WideTree.h>
+#include <cfloat>
+
+b2WideTree::b2WideTree()
+{
+	m_nodes = NULL;
+	m_nodeCount = 0;
+	m_nodeCapacity = 0;
+	m_root = b2_nullNode;
+}
+
+b2WideTree::~b2WideTree()
+{
+	b2Free(m_nodes);
+}
+
+void b2WideTree::Build(const b2DynamicTree& tree)
+{
+	m_nodeCount = 0;
+	m_root = b2_nullNode;
+
+	if (tree.m_root == b2_nullNode)
+	{
+		return;
+	}
+
+	// Every node takes at least one internal node of the dynamic tree, so
+	// the nodes never have to move while building.
+	int32 capacity = b2Max(tree.m_nodeCount / 2 + 1, 1);
+	if (m_nodeCapacity < capacity)
+	{
+		b2Free(m_nodes);
+		m_nodeCapacity = capacity;
+		m_nodes = (b2WideTreeNode*)b2Alloc(m_nodeCapacity * sizeof(b2WideTreeNode));
+	}
+
+	m_root = BuildNode(tree, tree.m_root);
+}
+
+// Create a node for a sub-tree of the dynamic tree. Returns the node index.
+int32 b2WideTree::BuildNode(const b2DynamicTree& tree, int32 nodeId)
+{
+	const b2DynamicTreeNode* nodes = tree.m_nodes;
+
+	// Open up the largest internal nodes until there are four children.
+	int32 children[4];
+	int32 childCount = 0;
+	if (nodes[nodeId].IsLeaf())
+	{
+		children[childCount++] = nodeId;
+	}
+	else
+	{
+		children[childCount++] = nodes[nodeId].child1;
+		children[childCount++] = nodes[nodeId].child2;
+	}
+
+	while (childCount < 4)
+	{
+		int32 best = -1;
+		float32 bestPerimeter = -1.0f;
+		for (int32 i = 0; i < childCount; ++i)
+		{
+			const b2DynamicTreeNode* child = nodes + children[i];
+			if (child->IsLeaf() == false && child->aabb.GetPerimeter() > bestPerimeter)
+			{
+				best = i;
+				bestPerimeter = child->aabb.GetPerimeter();
+			}
+		}
+
+		if (best == -1)
+		{
+			break;
+		}
+
+		int32 child = children[best];
+		children[best] = nodes[child].child1;
+		children[childCount++] = nodes[child].child2;
+	}
+
+	b2Assert(m_nodeCount < m_nodeCapacity);
+	int32 index = m_nodeCount++;
+
+	// Empty lanes get an inverted box.
+	b2AABB empty;
+	empty.lowerBound.Set(FLT_MAX, FLT_MAX);
+	empty.upperBound.Set(-FLT_MAX, -FLT_MAX);
+
+	for (int32 i = 0; i < 4; ++i)
+	{
+		if (i >= childCount)
+		{
+			SetChild(index, i, empty, b2_nullNode);
+		}
+		else if (nodes[children[i]].IsLeaf())
+		{
+			SetChild(index, i, nodes[children[i]].aabb, EncodeLeaf(children[i]));
+		}
+		else
+		{
+			SetChild(index, i, nodes[children[i]].aabb, BuildNode(tree, children[i]));
+		}
+	}
+
+	return index;
+}
+
+void b2WideTree::ShiftOrigin(const b2Vec2& newOrigin)
+{
+	for (int32 i = 0; i < m_nodeCount; ++i)
+	{
+		b2WideTreeNode* node = m_nodes + i;
+		for (int32 j = 0; j < 4; ++j)
+		{
+			// Empty lanes keep their inverted bounds.
+			if (node->children[j] != b2_nullNode)
+			{
+				node->lowerX[j] -= newOrigin.x;
+				node->lowerY[j] -= newOrigin.y;
+				node->upperX[j] -= newOrigin.x;
+				node->upperY[j] -= newOrigin.y;
+			}
+		}
+	}
+}
+
+void b2WideTree::SetChild(int32 index, int32 lane, const b2AABB& aabb, int32 child)
+{
+	b2WideTreeNode* node = m_nodes + index;
+	node->lowerX[lane] = aabb.lowerBound.x;
+	node->lowerY[lane] = aabb.lowerBound.y;
+	node->upperX[lane] = aabb.upperBound.x;
+	node->upperY[lane] = aabb.upperBound.y;
+	node->children[lane] = child;
+}
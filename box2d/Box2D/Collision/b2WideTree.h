@@ -0,0 +1,281 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_WIDE_TREE_H
+#define B2_WIDE_TREE_H
+
+#include <Box2D/Collision/b2DynamicTree.h>
+#include <Box2D/Common/b2SIMD.h>
+
+/// A node of the wide tree. The bounds of the children are stored lane by
+/// lane, so that all four children are tested against a box at once.
+struct b2WideTreeNode
+{
+	float32 lowerX[4];
+	float32 lowerY[4];
+	float32 upperX[4];
+	float32 upperY[4];
+
+	/// A node index, a leaf made by b2WideTree::EncodeLeaf or b2_nullNode.
+	int32 children[4];
+};
+
+/// A read-only copy of a dynamic tree with four children per node. Every
+/// node collapses two levels of the dynamic tree, so queries visit half as
+/// many nodes and test each node with a few SIMD instructions. The tree must
+/// be built again after the dynamic tree changes. Leafs are reported with
+/// the proxy ids of the dynamic tree.
+class b2WideTree
+{
+public:
+
+	b2WideTree();
+	~b2WideTree();
+
+	/// Copy the fat AABBs and the structure of a dynamic tree.
+	void Build(const b2DynamicTree& tree);
+
+	/// Translate the copy along with b2DynamicTree::ShiftOrigin, so that it
+	/// need not be built again.
+	void ShiftOrigin(const b2Vec2& newOrigin);
+
+	/// Query an AABB for overlapping proxies. The callback class
+	/// is called for each proxy that overlaps the supplied AABB.
+	template <typename T>
+	void Query(T* callback, const b2AABB& aabb) const;
+
+	/// Ray-cast against the proxies in the tree. This works like
+	/// b2DynamicTree::RayCast.
+	template <typename T>
+	void RayCast(T* callback, const b2RayCastInput& input) const;
+
+private:
+
+	static int32 EncodeLeaf(int32 proxyId);
+	static bool IsLeaf(int32 child);
+	static int32 DecodeLeaf(int32 child);
+
+	int32 BuildNode(const b2DynamicTree& tree, int32 nodeId);
+	void SetChild(int32 index, int32 lane, const b2AABB& aabb, int32 child);
+
+	int32 OverlapMask(const b2WideTreeNode* node, const b2AABB& aabb) const;
+
+	b2WideTreeNode* m_nodes;
+	int32 m_nodeCount;
+	int32 m_nodeCapacity;
+
+	int32 m_root;
+};
+
+inline int32 b2WideTree::EncodeLeaf(int32 proxyId)
+{
+	return -2 - proxyId;
+}
+
+inline bool b2WideTree::IsLeaf(int32 child)
+{
+	return child < b2_nullNode;
+}
+
+inline int32 b2WideTree::DecodeLeaf(int32 child)
+{
+	return -2 - child;
+}
+
+// Get a bit for every child whose AABB overlaps the given AABB.
+inline int32 b2WideTree::OverlapMask(const b2WideTreeNode* node, const b2AABB& aabb) const
+{
+#if defined(B2_SIMD4)
+	b2Float4 mask = b2GreaterEqual4(b2Splat4(aabb.upperBound.x), b2Load4(node->lowerX));
+	mask = b2And4(mask, b2GreaterEqual4(b2Splat4(aabb.upperBound.y), b2Load4(node->lowerY)));
+	mask = b2And4(mask, b2GreaterEqual4(b2Load4(node->upperX), b2Splat4(aabb.lowerBound.x)));
+	mask = b2And4(mask, b2GreaterEqual4(b2Load4(node->upperY), b2Splat4(aabb.lowerBound.y)));
+	return b2MoveMask4(mask);
+#else
+	int32 mask = 0;
+	for (int32 i = 0; i < 4; ++i)
+	{
+		if (aabb.upperBound.x >= node->lowerX[i] && aabb.upperBound.y >= node->lowerY[i] &&
+			node->upperX[i] >= aabb.lowerBound.x && node->upperY[i] >= aabb.lowerBound.y)
+		{
+			mask |= 1 << i;
+		}
+	}
+	return mask;
+#endif
+}
+
+template <typename T>
+inline void b2WideTree::Query(T* callback, const b2AABB& aabb) const
+{
+	if (m_root == b2_nullNode)
+	{
+		return;
+	}
+
+	b2GrowableStack<int32, 256> stack;
+	stack.Push(m_root);
+
+	while (stack.GetCount() > 0)
+	{
+		const b2WideTreeNode* node = m_nodes + stack.Pop();
+
+		int32 mask = OverlapMask(node, aabb);
+		for (int32 i = 0; i < 4; ++i)
+		{
+			int32 child = node->children[i];
+			if ((mask & (1 << i)) == 0 || child == b2_nullNode)
+			{
+				continue;
+			}
+
+			if (IsLeaf(child))
+			{
+				bool proceed = callback->QueryCallback(DecodeLeaf(child));
+				if (proceed == false)
+				{
+					return;
+				}
+			}
+			else
+			{
+				stack.Push(child);
+			}
+		}
+	}
+}
+
+template <typename T>
+inline void b2WideTree::RayCast(T* callback, const b2RayCastInput& input) const
+{
+	if (m_root == b2_nullNode)
+	{
+		return;
+	}
+
+	b2Vec2 p1 = input.p1;
+	b2Vec2 p2 = input.p2;
+	b2Vec2 r = p2 - p1;
+	b2Assert(r.LengthSquared() > 0.0f);
+	r.Normalize();
+
+	// v is perpendicular to the segment.
+	b2Vec2 v = b2Cross(1.0f, r);
+	b2Vec2 abs_v = b2Abs(v);
+
+	float32 maxFraction = input.maxFraction;
+
+	// Build a bounding box for the segment.
+	b2AABB segmentAABB;
+	{
+		b2Vec2 t = p1 + maxFraction * (p2 - p1);
+		segmentAABB.lowerBound = b2Min(p1, t);
+		segmentAABB.upperBound = b2Max(p1, t);
+	}
+
+	b2GrowableStack<int32, 256> stack;
+	stack.Push(m_root);
+
+	while (stack.GetCount() > 0)
+	{
+		const b2WideTreeNode* node = m_nodes + stack.Pop();
+
+		int32 mask = OverlapMask(node, segmentAABB);
+		if (mask == 0)
+		{
+			continue;
+		}
+
+		// Separating axis for segment (Gino, p80).
+		// |dot(v, p1 - c)| > dot(|v|, h)
+#if defined(B2_SIMD4)
+		{
+			b2Float4 half = b2Splat4(0.5f);
+			b2Float4 lowerX = b2Load4(node->lowerX);
+			b2Float4 lowerY = b2Load4(node->lowerY);
+			b2Float4 upperX = b2Load4(node->upperX);
+			b2Float4 upperY = b2Load4(node->upperY);
+			b2Float4 dx = b2Sub4(b2Splat4(p1.x), b2Mul4(half, b2Add4(lowerX, upperX)));
+			b2Float4 dy = b2Sub4(b2Splat4(p1.y), b2Mul4(half, b2Add4(lowerY, upperY)));
+			b2Float4 hx = b2Mul4(half, b2Sub4(upperX, lowerX));
+			b2Float4 hy = b2Mul4(half, b2Sub4(upperY, lowerY));
+			b2Float4 d = b2Add4(b2Mul4(b2Splat4(v.x), dx), b2Mul4(b2Splat4(v.y), dy));
+			d = b2Max4(d, b2Sub4(b2Splat4(0.0f), d));
+			b2Float4 h = b2Add4(b2Mul4(b2Splat4(abs_v.x), hx), b2Mul4(b2Splat4(abs_v.y), hy));
+			mask &= b2MoveMask4(b2GreaterEqual4(h, d));
+		}
+#else
+		for (int32 i = 0; i < 4; ++i)
+		{
+			b2Vec2 c(0.5f * (node->lowerX[i] + node->upperX[i]), 0.5f * (node->lowerY[i] + node->upperY[i]));
+			b2Vec2 h(0.5f * (node->upperX[i] - node->lowerX[i]), 0.5f * (node->upperY[i] - node->lowerY[i]));
+			float32 separation = b2Abs(b2Dot(v, p1 - c)) - b2Dot(abs_v, h);
+			if (separation > 0.0f)
+			{
+				mask &= ~(1 << i);
+			}
+		}
+#endif
+
+		for (int32 i = 0; i < 4; ++i)
+		{
+			int32 child = node->children[i];
+			if ((mask & (1 << i)) == 0 || child == b2_nullNode)
+			{
+				continue;
+			}
+
+			if (IsLeaf(child) == false)
+			{
+				stack.Push(child);
+				continue;
+			}
+
+			// The segment may have been clipped by an earlier child.
+			if (segmentAABB.upperBound.x < node->lowerX[i] || segmentAABB.upperBound.y < node->lowerY[i] ||
+				node->upperX[i] < segmentAABB.lowerBound.x || node->upperY[i] < segmentAABB.lowerBound.y)
+			{
+				continue;
+			}
+
+			b2RayCastInput subInput;
+			subInput.p1 = input.p1;
+			subInput.p2 = input.p2;
+			subInput.maxFraction = maxFraction;
+
+			float32 value = callback->RayCastCallback(subInput, DecodeLeaf(child));
+
+			if (value == 0.0f)
+			{
+				// The client has terminated the ray cast.
+				return;
+			}
+
+			if (value > 0.0f)
+			{
+				// Update segment bounding box.
+				maxFraction = value;
+				b2Vec2 t = p1 + maxFraction * (p2 - p1);
+				segmentAABB.lowerBound = b2Min(p1, t);
+				segmentAABB.upperBound = b2Max(p1, t);
+			}
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,167 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Common/b2PairSet.h>
+#include <Box2D/Common/b2Math.h>
+
+#include <cstring>
+
+// Order the pair and mix the two addresses into an index.
+static inline void b2OrderPair(void*& a, void*& b)
+{
+	if ((size_t)b < (size_t)a)
+	{
+		b2Swap(a, b);
+	}
+}
+
+static inline uint32 b2HashPair(const void* a, const void* b)
+{
+	size_t x = (size_t)a * 31 + (size_t)b;
+	uint32 h = uint32(x) ^ uint32((x >> 16) >> 16);
+
+	// Finalizer of MurmurHash3.
+	h ^= h >> 16;
+	h *= 0x85ebca6b;
+	h ^= h >> 13;
+	h *= 0xc2b2ae35;
+	h ^= h >> 16;
+	return h;
+}
+
+b2PairSet::b2PairSet()
+{
+	m_capacity = 32;
+	m_count = 0;
+	m_entries = (b2PairSetEntry*)b2Alloc(m_capacity * sizeof(b2PairSetEntry));
+	memset(m_entries, 0, m_capacity * sizeof(b2PairSetEntry));
+}
+
+b2PairSet::~b2PairSet()
+{
+	b2Free(m_entries);
+}
+
+// Returns the slot of the pair, or the empty slot that ends its probe.
+int32 b2PairSet::Find(void* a, void* b) const
+{
+	b2OrderPair(a, b);
+
+	int32 mask = m_capacity - 1;
+	int32 index = int32(b2HashPair(a, b) & uint32(mask));
+	while (m_entries[index].a != NULL)
+	{
+		if (m_entries[index].a == a && m_entries[index].b == b)
+		{
+			break;
+		}
+
+		index = (index + 1) & mask;
+	}
+
+	return index;
+}
+
+void b2PairSet::Grow()
+{
+	b2PairSetEntry* oldEntries = m_entries;
+	int32 oldCapacity = m_capacity;
+
+	m_capacity *= 2;
+	m_entries = (b2PairSetEntry*)b2Alloc(m_capacity * sizeof(b2PairSetEntry));
+	memset(m_entries, 0, m_capacity * sizeof(b2PairSetEntry));
+
+	for (int32 i = 0; i < oldCapacity; ++i)
+	{
+		if (oldEntries[i].a != NULL)
+		{
+			// The pairs are unique and already ordered.
+			int32 index = Find(oldEntries[i].a, oldEntries[i].b);
+			m_entries[index] = oldEntries[i];
+		}
+	}
+
+	b2Free(oldEntries);
+}
+
+bool b2PairSet::Add(void* a, void* b)
+{
+	b2Assert(a != NULL && b != NULL);
+
+	// Keep the load factor under one half.
+	if (2 * (m_count + 1) > m_capacity)
+	{
+		Grow();
+	}
+
+	int32 index = Find(a, b);
+	if (m_entries[index].a != NULL)
+	{
+		return false;
+	}
+
+	b2OrderPair(a, b);
+	m_entries[index].a = a;
+	m_entries[index].b = b;
+	++m_count;
+	return true;
+}
+
+bool b2PairSet::Remove(void* a, void* b)
+{
+	int32 index = Find(a, b);
+	if (m_entries[index].a == NULL)
+	{
+		return false;
+	}
+
+	--m_count;
+
+	// Move back the following pairs of the probe that would no longer be
+	// found past the hole.
+	int32 mask = m_capacity - 1;
+	int32 hole = index;
+	int32 next = (hole + 1) & mask;
+	while (m_entries[next].a != NULL)
+	{
+		int32 home = int32(b2HashPair(m_entries[next].a, m_entries[next].b) & uint32(mask));
+
+		// Is the home slot cyclically outside of (hole, next]?
+		bool move;
+		if (hole <= next)
+		{
+			move = home <= hole || next < home;
+		}
+		else
+		{
+			move = home <= hole && next < home;
+		}
+
+		if (move)
+		{
+			m_entries[hole] = m_entries[next];
+			hole = next;
+		}
+
+		next = (next + 1) & mask;
+	}
+
+	m_entries[hole].a = NULL;
+	m_entries[hole].b = NULL;
+	return true;
+}
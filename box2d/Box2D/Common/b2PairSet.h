@@ -0,0 +1,72 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_PAIR_SET_H
+#define B2_PAIR_SET_H
+
+#include <Box2D/Common/b2Settings.h>
+
+/// An unordered set of pointer pairs. The pair (a, b) is the same as (b, a).
+/// Inserting, looking up and removing a pair take constant time on average.
+/// This uses open addressing with linear probing, so removing a pair moves
+/// the following pairs back instead of leaving tombstones.
+class b2PairSet
+{
+public:
+	b2PairSet();
+	~b2PairSet();
+
+	/// Add a pair. Returns false if the pair was already in the set.
+	bool Add(void* a, void* b);
+
+	/// Remove a pair. Returns false if the pair was not in the set.
+	bool Remove(void* a, void* b);
+
+	/// Is this pair in the set?
+	bool Contains(void* a, void* b) const;
+
+	/// Get the number of pairs in the set.
+	int32 GetCount() const;
+
+private:
+
+	struct b2PairSetEntry
+	{
+		void* a;
+		void* b;
+	};
+
+	int32 Find(void* a, void* b) const;
+	void Grow();
+
+	b2PairSetEntry* m_entries;
+	int32 m_capacity;
+	int32 m_count;
+};
+
+inline bool b2PairSet::Contains(void* a, void* b) const
+{
+	return m_entries[Find(a, b)].a != NULL;
+}
+
+inline int32 b2PairSet::GetCount() const
+{
+	return m_count;
+}
+
+#endif
@@ -0,0 +1,200 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_SIMD_H
+#define B2_SIMD_H
+
+#include <Box2D/Common/b2Math.h>
+
+// Wide floats hold B2_SIMD_WIDTH lanes that are processed by one instruction.
+// The widest instruction set enabled by the compiler is used: AVX gives 8 lanes,
+// SSE2 and NEON give 4. Define B2_NO_SIMD to use the scalar code everywhere.
+// B2_SIMD_WIDTH is not defined when there is no instruction set to use.
+//
+// Comparisons return masks with all bits of a lane set or cleared, stored in
+// wide floats, for use with b2SelectW, b2AndW and b2OrW.
+
+#if defined(B2_NO_SIMD)
+
+#elif defined(__AVX__)
+
+#include <immintrin.h>
+
+#define B2_SIMD_WIDTH 8
+
+typedef __m256 b2FloatW;
+
+inline b2FloatW b2ZeroW() { return _mm256_setzero_ps(); }
+inline b2FloatW b2SplatW(float32 x) { return _mm256_set1_ps(x); }
+inline b2FloatW b2LoadW(const float32* p) { return _mm256_loadu_ps(p); }
+inline void b2StoreW(float32* p, b2FloatW a) { _mm256_storeu_ps(p, a); }
+inline b2FloatW b2AddW(b2FloatW a, b2FloatW b) { return _mm256_add_ps(a, b); }
+inline b2FloatW b2SubW(b2FloatW a, b2FloatW b) { return _mm256_sub_ps(a, b); }
+inline b2FloatW b2MulW(b2FloatW a, b2FloatW b) { return _mm256_mul_ps(a, b); }
+inline b2FloatW b2DivW(b2FloatW a, b2FloatW b) { return _mm256_div_ps(a, b); }
+inline b2FloatW b2MinW(b2FloatW a, b2FloatW b) { return _mm256_min_ps(a, b); }
+inline b2FloatW b2MaxW(b2FloatW a, b2FloatW b) { return _mm256_max_ps(a, b); }
+inline b2FloatW b2SqrtW(b2FloatW a) { return _mm256_sqrt_ps(a); }
+inline b2FloatW b2GreaterEqualW(b2FloatW a, b2FloatW b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+inline b2FloatW b2GreaterW(b2FloatW a, b2FloatW b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+inline b2FloatW b2AndW(b2FloatW a, b2FloatW b) { return _mm256_and_ps(a, b); }
+inline b2FloatW b2OrW(b2FloatW a, b2FloatW b) { return _mm256_or_ps(a, b); }
+inline b2FloatW b2SelectW(b2FloatW mask, b2FloatW a, b2FloatW b) { return _mm256_blendv_ps(b, a, mask); }
+
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+
+#include <emmintrin.h>
+
+#define B2_SIMD_WIDTH 4
+
+typedef __m128 b2FloatW;
+
+inline b2FloatW b2ZeroW() { return _mm_setzero_ps(); }
+inline b2FloatW b2SplatW(float32 x) { return _mm_set1_ps(x); }
+inline b2FloatW b2LoadW(const float32* p) { return _mm_loadu_ps(p); }
+inline void b2StoreW(float32* p, b2FloatW a) { _mm_storeu_ps(p, a); }
+inline b2FloatW b2AddW(b2FloatW a, b2FloatW b) { return _mm_add_ps(a, b); }
+inline b2FloatW b2SubW(b2FloatW a, b2FloatW b) { return _mm_sub_ps(a, b); }
+inline b2FloatW b2MulW(b2FloatW a, b2FloatW b) { return _mm_mul_ps(a, b); }
+inline b2FloatW b2DivW(b2FloatW a, b2FloatW b) { return _mm_div_ps(a, b); }
+inline b2FloatW b2MinW(b2FloatW a, b2FloatW b) { return _mm_min_ps(a, b); }
+inline b2FloatW b2MaxW(b2FloatW a, b2FloatW b) { return _mm_max_ps(a, b); }
+inline b2FloatW b2SqrtW(b2FloatW a) { return _mm_sqrt_ps(a); }
+inline b2FloatW b2GreaterEqualW(b2FloatW a, b2FloatW b) { return _mm_cmpge_ps(a, b); }
+inline b2FloatW b2GreaterW(b2FloatW a, b2FloatW b) { return _mm_cmpgt_ps(a, b); }
+inline b2FloatW b2AndW(b2FloatW a, b2FloatW b) { return _mm_and_ps(a, b); }
+inline b2FloatW b2OrW(b2FloatW a, b2FloatW b) { return _mm_or_ps(a, b); }
+inline b2FloatW b2SelectW(b2FloatW mask, b2FloatW a, b2FloatW b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+
+#include <arm_neon.h>
+
+#define B2_SIMD_WIDTH 4
+
+typedef float32x4_t b2FloatW;
+
+inline b2FloatW b2ZeroW() { return vdupq_n_f32(0.0f); }
+inline b2FloatW b2SplatW(float32 x) { return vdupq_n_f32(x); }
+inline b2FloatW b2LoadW(const float32* p) { return vld1q_f32(p); }
+inline void b2StoreW(float32* p, b2FloatW a) { vst1q_f32(p, a); }
+inline b2FloatW b2AddW(b2FloatW a, b2FloatW b) { return vaddq_f32(a, b); }
+inline b2FloatW b2SubW(b2FloatW a, b2FloatW b) { return vsubq_f32(a, b); }
+inline b2FloatW b2MulW(b2FloatW a, b2FloatW b) { return vmulq_f32(a, b); }
+inline b2FloatW b2DivW(b2FloatW a, b2FloatW b) { return vdivq_f32(a, b); }
+inline b2FloatW b2MinW(b2FloatW a, b2FloatW b) { return vminq_f32(a, b); }
+inline b2FloatW b2MaxW(b2FloatW a, b2FloatW b) { return vmaxq_f32(a, b); }
+inline b2FloatW b2SqrtW(b2FloatW a) { return vsqrtq_f32(a); }
+inline b2FloatW b2GreaterEqualW(b2FloatW a, b2FloatW b) { return vreinterpretq_f32_u32(vcgeq_f32(a, b)); }
+inline b2FloatW b2GreaterW(b2FloatW a, b2FloatW b) { return vreinterpretq_f32_u32(vcgtq_f32(a, b)); }
+inline b2FloatW b2AndW(b2FloatW a, b2FloatW b) { return vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b))); }
+inline b2FloatW b2OrW(b2FloatW a, b2FloatW b) { return vreinterpretq_f32_u32(vorrq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b))); }
+inline b2FloatW b2SelectW(b2FloatW mask, b2FloatW a, b2FloatW b) { return vbslq_f32(vreinterpretq_u32_f32(mask), a, b); }
+
+#endif
+
+// Four lane floats for data that comes in groups of four, whatever the widest
+// instruction set is. B2_SIMD4 is defined when these are available.
+// b2MoveMask4 packs the comparison masks into the low four bits of an integer.
+
+#if defined(B2_NO_SIMD)
+
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+
+#include <emmintrin.h>
+
+#define B2_SIMD4
+
+typedef __m128 b2Float4;
+
+inline b2Float4 b2Splat4(float32 x) { return _mm_set1_ps(x); }
+inline b2Float4 b2Load4(const float32* p) { return _mm_loadu_ps(p); }
+inline b2Float4 b2Add4(b2Float4 a, b2Float4 b) { return _mm_add_ps(a, b); }
+inline b2Float4 b2Sub4(b2Float4 a, b2Float4 b) { return _mm_sub_ps(a, b); }
+inline b2Float4 b2Mul4(b2Float4 a, b2Float4 b) { return _mm_mul_ps(a, b); }
+inline b2Float4 b2Max4(b2Float4 a, b2Float4 b) { return _mm_max_ps(a, b); }
+inline b2Float4 b2GreaterEqual4(b2Float4 a, b2Float4 b) { return _mm_cmpge_ps(a, b); }
+inline b2Float4 b2And4(b2Float4 a, b2Float4 b) { return _mm_and_ps(a, b); }
+inline int32 b2MoveMask4(b2Float4 a) { return _mm_movemask_ps(a); }
+
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+
+#include <arm_neon.h>
+
+#define B2_SIMD4
+
+typedef float32x4_t b2Float4;
+
+inline b2Float4 b2Splat4(float32 x) { return vdupq_n_f32(x); }
+inline b2Float4 b2Load4(const float32* p) { return vld1q_f32(p); }
+inline b2Float4 b2Add4(b2Float4 a, b2Float4 b) { return vaddq_f32(a, b); }
+inline b2Float4 b2Sub4(b2Float4 a, b2Float4 b) { return vsubq_f32(a, b); }
+inline b2Float4 b2Mul4(b2Float4 a, b2Float4 b) { return vmulq_f32(a, b); }
+inline b2Float4 b2Max4(b2Float4 a, b2Float4 b) { return vmaxq_f32(a, b); }
+inline b2Float4 b2GreaterEqual4(b2Float4 a, b2Float4 b) { return vreinterpretq_f32_u32(vcgeq_f32(a, b)); }
+inline b2Float4 b2And4(b2Float4 a, b2Float4 b) { return vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b))); }
+inline int32 b2MoveMask4(b2Float4 a)
+{
+	static const uint32 bits[4] = { 1, 2, 4, 8 };
+	return int32(vaddvq_u32(vandq_u32(vreinterpretq_u32_f32(a), vld1q_u32(bits))));
+}
+
+#endif
+
+#ifdef B2_SIMD_WIDTH
+
+/// A 2D column vector with wide components.
+struct b2Vec2W
+{
+	b2FloatW x, y;
+};
+
+/// Clamp each lane of a between low and high.
+inline b2FloatW b2ClampW(b2FloatW a, b2FloatW low, b2FloatW high)
+{
+	return b2MaxW(low, b2MinW(a, high));
+}
+
+/// Perform the dot product on two wide vectors.
+inline b2FloatW b2DotW(const b2Vec2W& a, const b2Vec2W& b)
+{
+	return b2AddW(b2MulW(a.x, b.x), b2MulW(a.y, b.y));
+}
+
+/// Perform the cross product on two wide vectors. In 2D this produces a scalar.
+inline b2FloatW b2CrossW(const b2Vec2W& a, const b2Vec2W& b)
+{
+	return b2SubW(b2MulW(a.x, b.y), b2MulW(a.y, b.x));
+}
+
+/// Get the minimum of the lanes of a.
+inline float32 b2ReduceMinW(b2FloatW a)
+{
+	float32 lanes[B2_SIMD_WIDTH];
+	b2StoreW(lanes, a);
+	float32 result = lanes[0];
+	for (int32 i = 1; i < B2_SIMD_WIDTH; ++i)
+	{
+		result = b2Min(result, lanes[i]);
+	}
+	return result;
+}
+
+#endif
+
+#endif
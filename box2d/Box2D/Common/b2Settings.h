@@ -59,6 +59,11 @@ typedef float float32;
 /// This is a dimensionless multiplier.
 #define b2_aabbMultiplier		2.0f
 
+/// The broad-phase builds a wide copy of its tree to find pairs when at least
+/// this fraction of the proxies moved. Otherwise the copy costs more to build
+/// than it saves.
+#define b2_wideTreeMoveFraction	0.0625f
+
 /// A small length used as a collision and constraint tolerance. Usually it is
 /// chosen to be numerically significant, but visually insignificant.
 #define b2_linearSlop			0.005f
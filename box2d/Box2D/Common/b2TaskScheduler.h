@@ -0,0 +1,59 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_TASK_SCHEDULER_H
+#define B2_TASK_SCHEDULER_H
+
+#include <Box2D/Common/b2Settings.h>
+
+/// A unit of work that the world wants to spread over several threads. The
+/// work consists of a number of items that can be processed independently.
+class b2Task
+{
+public:
+	virtual ~b2Task() {}
+
+	/// Process the items in the range [begin, end).
+	/// @param threadIndex the thread this is called on, in the range
+	/// [0, b2TaskScheduler::GetThreadCount()). Ranges that execute at the same
+	/// time always have a different thread index, so it can be used to pick
+	/// per-thread scratch memory.
+	virtual void Execute(int32 begin, int32 end, int32 threadIndex) = 0;
+};
+
+/// Implement this class to let the world run parts of a time step on several
+/// threads. Box2D does not create any threads itself. The results of a time
+/// step do not depend on the number of threads or the order in which ranges
+/// are executed.
+class b2TaskScheduler
+{
+public:
+	virtual ~b2TaskScheduler() {}
+
+	/// Get the maximum number of threads that execute tasks at the same time,
+	/// including the calling thread. This must not change while the scheduler
+	/// is used by a world.
+	virtual int32 GetThreadCount() const = 0;
+
+	/// Execute the items [0, count) of a task, split into ranges of at least
+	/// minRange items (except for the last range), and return once all the
+	/// ranges have been executed.
+	virtual void ParallelFor(b2Task* task, int32 count, int32 minRange) = 0;
+};
+
+#endif
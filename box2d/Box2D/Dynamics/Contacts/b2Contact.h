@@ -99,15 +99,18 @@ public:
 
 protected:
 	friend class b2ContactManager;
+	friend class b2CollideTask;
 	friend class b2World;
 	friend class b2ContactSolver;
+	friend class b2Island;
+	friend struct b2PersistentIsland;
 	friend class b2Body;
 	friend class b2Fixture;
 
 	// Flags stored in m_flags
 	enum
 	{
-		// Used when crawling contact graph when forming islands.
+		// Set while the contact is linked into the island of its bodies.
 		e_islandFlag		= 0x0001,
 
         // Set when the shapes are touching.
@@ -139,6 +142,8 @@ protected:
 	virtual ~b2Contact() {}
 
 	void Update(b2ContactListener* listener);
+	bool UpdateManifold(b2Manifold* oldManifold);
+	void UpdateState(const b2Manifold& oldManifold, bool touching, b2ContactListener* listener);
 
 	static b2ContactRegister s_registers[b2Shape::e_typeCount][b2Shape::e_typeCount];
 	static bool s_initialized;
@@ -153,11 +158,21 @@ protected:
 	b2ContactEdge m_nodeA;
 	b2ContactEdge m_nodeB;
 
+	// Persistent island list pointers.
+	b2Contact* m_islandPrev;
+	b2Contact* m_islandNext;
+
+	// Index in the awake contacts of the contact manager, -1 while asleep.
+	int32 m_awakeIndex;
+
 	b2Fixture* m_fixtureA;
 	b2Fixture* m_fixtureB;
 
 	b2Manifold m_manifold;
 
+	// Island indices of the bodies, set by b2Island::AssignIndices.
+	int32 m_indexA, m_indexB;
+
 	int32 m_toiCount;
 //	float32 m_toi;
 };
@@ -22,13 +22,20 @@
 #include <Box2D/Dynamics/b2Fixture.h>
 #include <Box2D/Dynamics/b2World.h>
 #include <Box2D/Common/b2StackAllocator.h>
+#include <Box2D/Common/b2TaskScheduler.h>
+
+#include <cstring>
 
 #define B2_DEBUG_SOLVER 0
 
 b2ContactSolver::b2ContactSolver(b2Contact** contacts, int32 contactCount,
-								b2StackAllocator* allocator, float32 impulseRatio)
+								b2Position* positions, b2Velocity* velocities,
+								b2StackAllocator* allocator, float32 impulseRatio, bool wide)
 {
 	m_allocator = allocator;
+	m_taskScheduler = NULL;
+	m_positions = positions;
+	m_velocities = velocities;
 
 	m_constraintCount = contactCount;
 	m_constraints = (b2ContactConstraint*)m_allocator->Allocate(m_constraintCount * sizeof(b2ContactConstraint));
@@ -50,10 +57,14 @@ b2ContactSolver::b2ContactSolver(b2Contact** contacts, int32 contactCount,
 		float32 friction = b2MixFriction(fixtureA->GetFriction(), fixtureB->GetFriction());
 		float32 restitution = b2MixRestitution(fixtureA->GetRestitution(), fixtureB->GetRestitution());
 
-		b2Vec2 vA = bodyA->m_linearVelocity;
-		b2Vec2 vB = bodyB->m_linearVelocity;
-		float32 wA = bodyA->m_angularVelocity;
-		float32 wB = bodyB->m_angularVelocity;
+		int32 indexA = contact->m_indexA;
+		int32 indexB = contact->m_indexB;
+		b2Vec2 cA = m_positions[indexA].c;
+		b2Vec2 cB = m_positions[indexB].c;
+		b2Vec2 vA = m_velocities[indexA].v;
+		b2Vec2 vB = m_velocities[indexB].v;
+		float32 wA = m_velocities[indexA].w;
+		float32 wB = m_velocities[indexB].w;
 
 		b2Assert(manifold->pointCount > 0);
 
@@ -61,8 +72,18 @@ b2ContactSolver::b2ContactSolver(b2Contact** contacts, int32 contactCount,
 		worldManifold.Initialize(manifold, bodyA->m_xf, radiusA, bodyB->m_xf, radiusB);
 
 		b2ContactConstraint* cc = m_constraints + i;
-		cc->bodyA = bodyA;
-		cc->bodyB = bodyB;
+		cc->indexA = indexA;
+		cc->indexB = indexB;
+		cc->invMassA = bodyA->m_invMass;
+		cc->invIA = bodyA->m_invI;
+		cc->invMassB = bodyB->m_invMass;
+		cc->invIB = bodyB->m_invI;
+		cc->positionInvMassA = bodyA->m_mass * bodyA->m_invMass;
+		cc->positionInvIA = bodyA->m_mass * bodyA->m_invI;
+		cc->positionInvMassB = bodyB->m_mass * bodyB->m_invMass;
+		cc->positionInvIB = bodyB->m_mass * bodyB->m_invI;
+		cc->localCenterA = bodyA->m_sweep.localCenter;
+		cc->localCenterB = bodyB->m_sweep.localCenter;
 		cc->manifold = manifold;
 		cc->normal = worldManifold.normal;
 		cc->pointCount = manifold->pointCount;
@@ -83,15 +104,15 @@ b2ContactSolver::b2ContactSolver(b2Contact** contacts, int32 contactCount,
 
 			ccp->localPoint = cp->localPoint;
 
-			ccp->rA = worldManifold.points[j] - bodyA->m_sweep.c;
-			ccp->rB = worldManifold.points[j] - bodyB->m_sweep.c;
+			ccp->rA = worldManifold.points[j] - cA;
+			ccp->rB = worldManifold.points[j] - cB;
 
 			float32 rnA = b2Cross(ccp->rA, cc->normal);
 			float32 rnB = b2Cross(ccp->rB, cc->normal);
 			rnA *= rnA;
 			rnB *= rnB;
 
-			float32 kNormal = bodyA->m_invMass + bodyB->m_invMass + bodyA->m_invI * rnA + bodyB->m_invI * rnB;
+			float32 kNormal = cc->invMassA + cc->invMassB + cc->invIA * rnA + cc->invIB * rnB;
 
 			b2Assert(kNormal > b2_epsilon);
 			ccp->normalMass = 1.0f / kNormal;
@@ -103,7 +124,7 @@ b2ContactSolver::b2ContactSolver(b2Contact** contacts, int32 contactCount,
 			rtA *= rtA;
 			rtB *= rtB;
 
-			float32 kTangent = bodyA->m_invMass + bodyB->m_invMass + bodyA->m_invI * rtA + bodyB->m_invI * rtB;
+			float32 kTangent = cc->invMassA + cc->invMassB + cc->invIA * rtA + cc->invIB * rtB;
 
 			b2Assert(kTangent > b2_epsilon);
 			ccp->tangentMass = 1.0f /  kTangent;
@@ -123,10 +144,10 @@ b2ContactSolver::b2ContactSolver(b2Contact** contacts, int32 contactCount,
 			b2ContactConstraintPoint* ccp1 = cc->points + 0;
 			b2ContactConstraintPoint* ccp2 = cc->points + 1;
 			
-			float32 invMassA = bodyA->m_invMass;
-			float32 invIA = bodyA->m_invI;
-			float32 invMassB = bodyB->m_invMass;
-			float32 invIB = bodyB->m_invI;
+			float32 invMassA = cc->invMassA;
+			float32 invIA = cc->invIA;
+			float32 invMassB = cc->invMassB;
+			float32 invIB = cc->invIB;
 
 			float32 rn1A = b2Cross(ccp1->rA, cc->normal);
 			float32 rn1B = b2Cross(ccp1->rB, cc->normal);
@@ -154,56 +175,104 @@ b2ContactSolver::b2ContactSolver(b2Contact** contacts, int32 contactCount,
 			}
 		}
 	}
+
+	m_scalarIndices = NULL;
+	m_scalarCount = m_constraintCount;
+
+#ifdef B2_SIMD_WIDTH
+	m_wideMemory = NULL;
+	m_wideConstraints = NULL;
+	m_wideCount = 0;
+	m_colorCount = 0;
+	m_colorStarts[0] = 0;
+
+	if (wide && m_constraintCount >= B2_SIMD_WIDTH)
+	{
+		BuildWideConstraints(contacts);
+	}
+#else
+	B2_NOT_USED(wide);
+#endif
 }
 
 b2ContactSolver::~b2ContactSolver()
 {
+	if (m_scalarIndices)
+	{
+		m_allocator->Free(m_scalarIndices);
+	}
+
+#ifdef B2_SIMD_WIDTH
+	if (m_wideMemory)
+	{
+		m_allocator->Free(m_wideMemory);
+	}
+#endif
+
 	m_allocator->Free(m_constraints);
 }
 
 void b2ContactSolver::WarmStart()
 {
+#ifdef B2_SIMD_WIDTH
+	SolveWide(e_warmStartPass, 0.0f);
+#endif
+
 	// Warm start.
-	for (int32 i = 0; i < m_constraintCount; ++i)
+	for (int32 i = 0; i < m_scalarCount; ++i)
 	{
-		b2ContactConstraint* c = m_constraints + i;
-
-		b2Body* bodyA = c->bodyA;
-		b2Body* bodyB = c->bodyB;
-		float32 invMassA = bodyA->m_invMass;
-		float32 invIA = bodyA->m_invI;
-		float32 invMassB = bodyB->m_invMass;
-		float32 invIB = bodyB->m_invI;
+		b2ContactConstraint* c = m_constraints + (m_scalarIndices ? m_scalarIndices[i] : i);
+
+		int32 indexA = c->indexA;
+		int32 indexB = c->indexB;
+		float32 invMassA = c->invMassA;
+		float32 invIA = c->invIA;
+		float32 invMassB = c->invMassB;
+		float32 invIB = c->invIB;
 		b2Vec2 normal = c->normal;
 		b2Vec2 tangent = b2Cross(normal, 1.0f);
 
+		b2Vec2 vA = m_velocities[indexA].v;
+		float32 wA = m_velocities[indexA].w;
+		b2Vec2 vB = m_velocities[indexB].v;
+		float32 wB = m_velocities[indexB].w;
+
 		for (int32 j = 0; j < c->pointCount; ++j)
 		{
 			b2ContactConstraintPoint* ccp = c->points + j;
 			b2Vec2 P = ccp->normalImpulse * normal + ccp->tangentImpulse * tangent;
-			bodyA->m_angularVelocity -= invIA * b2Cross(ccp->rA, P);
-			bodyA->m_linearVelocity -= invMassA * P;
-			bodyB->m_angularVelocity += invIB * b2Cross(ccp->rB, P);
-			bodyB->m_linearVelocity += invMassB * P;
+			wA -= invIA * b2Cross(ccp->rA, P);
+			vA -= invMassA * P;
+			wB += invIB * b2Cross(ccp->rB, P);
+			vB += invMassB * P;
 		}
+
+		m_velocities[indexA].v = vA;
+		m_velocities[indexA].w = wA;
+		m_velocities[indexB].v = vB;
+		m_velocities[indexB].w = wB;
 	}
 }
 
 void b2ContactSolver::SolveVelocityConstraints()
 {
-	for (int32 i = 0; i < m_constraintCount; ++i)
+#ifdef B2_SIMD_WIDTH
+	SolveWide(e_velocityPass, 0.0f);
+#endif
+
+	for (int32 i = 0; i < m_scalarCount; ++i)
 	{
-		b2ContactConstraint* c = m_constraints + i;
-		b2Body* bodyA = c->bodyA;
-		b2Body* bodyB = c->bodyB;
-		float32 wA = bodyA->m_angularVelocity;
-		float32 wB = bodyB->m_angularVelocity;
-		b2Vec2 vA = bodyA->m_linearVelocity;
-		b2Vec2 vB = bodyB->m_linearVelocity;
-		float32 invMassA = bodyA->m_invMass;
-		float32 invIA = bodyA->m_invI;
-		float32 invMassB = bodyB->m_invMass;
-		float32 invIB = bodyB->m_invI;
+		b2ContactConstraint* c = m_constraints + (m_scalarIndices ? m_scalarIndices[i] : i);
+		int32 indexA = c->indexA;
+		int32 indexB = c->indexB;
+		float32 wA = m_velocities[indexA].w;
+		float32 wB = m_velocities[indexB].w;
+		b2Vec2 vA = m_velocities[indexA].v;
+		b2Vec2 vB = m_velocities[indexB].v;
+		float32 invMassA = c->invMassA;
+		float32 invIA = c->invIA;
+		float32 invMassB = c->invMassB;
+		float32 invIB = c->invIB;
 		b2Vec2 normal = c->normal;
 		b2Vec2 tangent = b2Cross(normal, 1.0f);
 		float32 friction = c->friction;
@@ -481,15 +550,44 @@ void b2ContactSolver::SolveVelocityConstraints()
 			}
 		}
 
-		bodyA->m_linearVelocity = vA;
-		bodyA->m_angularVelocity = wA;
-		bodyB->m_linearVelocity = vB;
-		bodyB->m_angularVelocity = wB;
+		m_velocities[indexA].v = vA;
+		m_velocities[indexA].w = wA;
+		m_velocities[indexB].v = vB;
+		m_velocities[indexB].w = wB;
 	}
 }
 
 void b2ContactSolver::StoreImpulses()
 {
+#ifdef B2_SIMD_WIDTH
+	// Copy the impulses of the groups back to the constraints first.
+	for (int32 i = 0; i < m_wideCount; ++i)
+	{
+		const b2WideContactConstraint* wc = m_wideConstraints + i;
+
+		float32 normalImpulse1[B2_SIMD_WIDTH], normalImpulse2[B2_SIMD_WIDTH];
+		float32 tangentImpulse1[B2_SIMD_WIDTH], tangentImpulse2[B2_SIMD_WIDTH];
+		b2StoreW(normalImpulse1, wc->normalImpulse1);
+		b2StoreW(normalImpulse2, wc->normalImpulse2);
+		b2StoreW(tangentImpulse1, wc->tangentImpulse1);
+		b2StoreW(tangentImpulse2, wc->tangentImpulse2);
+
+		for (int32 j = 0; j < B2_SIMD_WIDTH; ++j)
+		{
+			if (wc->indices[j] < 0)
+			{
+				continue;
+			}
+
+			b2ContactConstraint* c = m_constraints + wc->indices[j];
+			c->points[0].normalImpulse = normalImpulse1[j];
+			c->points[0].tangentImpulse = tangentImpulse1[j];
+			c->points[1].normalImpulse = normalImpulse2[j];
+			c->points[1].tangentImpulse = tangentImpulse2[j];
+		}
+	}
+#endif
+
 	for (int32 i = 0; i < m_constraintCount; ++i)
 	{
 		b2ContactConstraint* c = m_constraints + i;
@@ -505,7 +603,7 @@ void b2ContactSolver::StoreImpulses()
 
 struct b2PositionSolverManifold
 {
-	void Initialize(b2ContactConstraint* cc, int32 index)
+	void Initialize(b2ContactConstraint* cc, const b2Transform& xfA, const b2Transform& xfB, int32 index)
 	{
 		b2Assert(cc->pointCount > 0);
 
@@ -513,8 +611,8 @@ struct b2PositionSolverManifold
 		{
 		case b2Manifold::e_circles:
 			{
-				b2Vec2 pointA = cc->bodyA->GetWorldPoint(cc->localPoint);
-				b2Vec2 pointB = cc->bodyB->GetWorldPoint(cc->points[0].localPoint);
+				b2Vec2 pointA = b2Mul(xfA, cc->localPoint);
+				b2Vec2 pointB = b2Mul(xfB, cc->points[0].localPoint);
 				if (b2DistanceSquared(pointA, pointB) > b2_epsilon * b2_epsilon)
 				{
 					normal = pointB - pointA;
@@ -532,10 +630,10 @@ struct b2PositionSolverManifold
 
 		case b2Manifold::e_faceA:
 			{
-				normal = cc->bodyA->GetWorldVector(cc->localNormal);
-				b2Vec2 planePoint = cc->bodyA->GetWorldPoint(cc->localPoint);
+				normal = b2Mul(xfA.R, cc->localNormal);
+				b2Vec2 planePoint = b2Mul(xfA, cc->localPoint);
 
-				b2Vec2 clipPoint = cc->bodyB->GetWorldPoint(cc->points[index].localPoint);
+				b2Vec2 clipPoint = b2Mul(xfB, cc->points[index].localPoint);
 				separation = b2Dot(clipPoint - planePoint, normal) - cc->radius;
 				point = clipPoint;
 			}
@@ -543,10 +641,10 @@ struct b2PositionSolverManifold
 
 		case b2Manifold::e_faceB:
 			{
-				normal = cc->bodyB->GetWorldVector(cc->localNormal);
-				b2Vec2 planePoint = cc->bodyB->GetWorldPoint(cc->localPoint);
+				normal = b2Mul(xfB.R, cc->localNormal);
+				b2Vec2 planePoint = b2Mul(xfB, cc->localPoint);
 
-				b2Vec2 clipPoint = cc->bodyA->GetWorldPoint(cc->points[index].localPoint);
+				b2Vec2 clipPoint = b2Mul(xfA, cc->points[index].localPoint);
 				separation = b2Dot(clipPoint - planePoint, normal) - cc->radius;
 				point = clipPoint;
 
@@ -567,29 +665,46 @@ bool b2ContactSolver::SolvePositionConstraints(float32 baumgarte)
 {
 	float32 minSeparation = 0.0f;
 
-	for (int32 i = 0; i < m_constraintCount; ++i)
-	{
-		b2ContactConstraint* c = m_constraints + i;
-		b2Body* bodyA = c->bodyA;
-		b2Body* bodyB = c->bodyB;
+#ifdef B2_SIMD_WIDTH
+	minSeparation = SolveWide(e_positionPass, baumgarte);
+#endif
 
-		float32 invMassA = bodyA->m_mass * bodyA->m_invMass;
-		float32 invIA = bodyA->m_mass * bodyA->m_invI;
-		float32 invMassB = bodyB->m_mass * bodyB->m_invMass;
-		float32 invIB = bodyB->m_mass * bodyB->m_invI;
+	for (int32 i = 0; i < m_scalarCount; ++i)
+	{
+		b2ContactConstraint* c = m_constraints + (m_scalarIndices ? m_scalarIndices[i] : i);
+		int32 indexA = c->indexA;
+		int32 indexB = c->indexB;
+		b2Vec2 localCenterA = c->localCenterA;
+		b2Vec2 localCenterB = c->localCenterB;
+
+		float32 invMassA = c->positionInvMassA;
+		float32 invIA = c->positionInvIA;
+		float32 invMassB = c->positionInvMassB;
+		float32 invIB = c->positionInvIB;
+
+		b2Vec2 cA = m_positions[indexA].c;
+		float32 aA = m_positions[indexA].a;
+		b2Vec2 cB = m_positions[indexB].c;
+		float32 aB = m_positions[indexB].a;
 
 		// Solve normal constraints
 		for (int32 j = 0; j < c->pointCount; ++j)
 		{
+			b2Transform xfA, xfB;
+			xfA.R.Set(aA);
+			xfB.R.Set(aB);
+			xfA.position = cA - b2Mul(xfA.R, localCenterA);
+			xfB.position = cB - b2Mul(xfB.R, localCenterB);
+
 			b2PositionSolverManifold psm;
-			psm.Initialize(c, j);
+			psm.Initialize(c, xfA, xfB, j);
 			b2Vec2 normal = psm.normal;
 
 			b2Vec2 point = psm.point;
 			float32 separation = psm.separation;
 
-			b2Vec2 rA = point - bodyA->m_sweep.c;
-			b2Vec2 rB = point - bodyB->m_sweep.c;
+			b2Vec2 rA = point - cA;
+			b2Vec2 rB = point - cB;
 
 			// Track max constraint error.
 			minSeparation = b2Min(minSeparation, separation);
@@ -607,17 +722,726 @@ bool b2ContactSolver::SolvePositionConstraints(float32 baumgarte)
 
 			b2Vec2 P = impulse * normal;
 
-			bodyA->m_sweep.c -= invMassA * P;
-			bodyA->m_sweep.a -= invIA * b2Cross(rA, P);
-			bodyA->SynchronizeTransform();
+			cA -= invMassA * P;
+			aA -= invIA * b2Cross(rA, P);
 
-			bodyB->m_sweep.c += invMassB * P;
-			bodyB->m_sweep.a += invIB * b2Cross(rB, P);
-			bodyB->SynchronizeTransform();
+			cB += invMassB * P;
+			aB += invIB * b2Cross(rB, P);
 		}
+
+		m_positions[indexA].c = cA;
+		m_positions[indexA].a = aA;
+		m_positions[indexB].c = cB;
+		m_positions[indexB].a = aB;
 	}
 
 	// We can't expect minSpeparation >= -b2_linearSlop because we don't
 	// push the separation above -b2_linearSlop.
 	return minSeparation >= -1.5f * b2_linearSlop;
 }
+
+#ifdef B2_SIMD_WIDTH
+
+inline void b2SetLane(b2FloatW& w, int32 lane, float32 x)
+{
+	((float32*)&w)[lane] = x;
+}
+
+inline void b2SetLane(b2Vec2W& w, int32 lane, const b2Vec2& v)
+{
+	((float32*)&w.x)[lane] = v.x;
+	((float32*)&w.y)[lane] = v.y;
+}
+
+inline void b2SetMaskLane(b2FloatW& w, int32 lane, bool set)
+{
+	((uint32*)&w)[lane] = set ? 0xffffffff : 0;
+}
+
+inline b2Vec2W b2SelectW(b2FloatW mask, const b2Vec2W& a, const b2Vec2W& b)
+{
+	b2Vec2W v;
+	v.x = b2SelectW(mask, a.x, b.x);
+	v.y = b2SelectW(mask, a.y, b.y);
+	return v;
+}
+
+// Lanes without a body are at rest.
+b2VelocityW b2ContactSolver::GatherVelocities(const int32* indices) const
+{
+	float32 vx[B2_SIMD_WIDTH], vy[B2_SIMD_WIDTH], w[B2_SIMD_WIDTH];
+
+	for (int32 i = 0; i < B2_SIMD_WIDTH; ++i)
+	{
+		int32 index = indices[i];
+		vx[i] = index != -1 ? m_velocities[index].v.x : 0.0f;
+		vy[i] = index != -1 ? m_velocities[index].v.y : 0.0f;
+		w[i] = index != -1 ? m_velocities[index].w : 0.0f;
+	}
+
+	b2VelocityW velocity;
+	velocity.v.x = b2LoadW(vx);
+	velocity.v.y = b2LoadW(vy);
+	velocity.w = b2LoadW(w);
+	return velocity;
+}
+
+void b2ContactSolver::ScatterVelocities(const int32* indices, const bool* dynamic, const b2VelocityW& velocity)
+{
+	float32 vx[B2_SIMD_WIDTH], vy[B2_SIMD_WIDTH], w[B2_SIMD_WIDTH];
+	b2StoreW(vx, velocity.v.x);
+	b2StoreW(vy, velocity.v.y);
+	b2StoreW(w, velocity.w);
+
+	for (int32 i = 0; i < B2_SIMD_WIDTH; ++i)
+	{
+		if (dynamic[i])
+		{
+			b2Velocity* v = m_velocities + indices[i];
+			v->v.Set(vx[i], vy[i]);
+			v->w = w[i];
+		}
+	}
+}
+
+// Lanes without a body are at the origin. The transform is derived the same
+// way as b2Body::SynchronizeTransform.
+b2PositionW b2ContactSolver::GatherPositions(const int32* indices, const b2Vec2* localCenters) const
+{
+	float32 cx[B2_SIMD_WIDTH], cy[B2_SIMD_WIDTH], a[B2_SIMD_WIDTH];
+	float32 px[B2_SIMD_WIDTH], py[B2_SIMD_WIDTH], cos[B2_SIMD_WIDTH], sin[B2_SIMD_WIDTH];
+
+	for (int32 i = 0; i < B2_SIMD_WIDTH; ++i)
+	{
+		int32 index = indices[i];
+		if (index != -1)
+		{
+			const b2Position* p = m_positions + index;
+			b2Mat22 R(p->a);
+			b2Vec2 position = p->c - b2Mul(R, localCenters[i]);
+			cx[i] = p->c.x;
+			cy[i] = p->c.y;
+			a[i] = p->a;
+			px[i] = position.x;
+			py[i] = position.y;
+			cos[i] = R.col1.x;
+			sin[i] = R.col1.y;
+		}
+		else
+		{
+			cx[i] = cy[i] = a[i] = px[i] = py[i] = sin[i] = 0.0f;
+			cos[i] = 1.0f;
+		}
+	}
+
+	b2PositionW position;
+	position.c.x = b2LoadW(cx);
+	position.c.y = b2LoadW(cy);
+	position.a = b2LoadW(a);
+	position.p.x = b2LoadW(px);
+	position.p.y = b2LoadW(py);
+	position.cos = b2LoadW(cos);
+	position.sin = b2LoadW(sin);
+	return position;
+}
+
+void b2ContactSolver::ScatterPositions(const int32* indices, const bool* dynamic, const int32* pointCounts, int32 index, const b2PositionW& position)
+{
+	float32 cx[B2_SIMD_WIDTH], cy[B2_SIMD_WIDTH], a[B2_SIMD_WIDTH];
+	b2StoreW(cx, position.c.x);
+	b2StoreW(cy, position.c.y);
+	b2StoreW(a, position.a);
+
+	for (int32 i = 0; i < B2_SIMD_WIDTH; ++i)
+	{
+		if (dynamic[i] && index < pointCounts[i])
+		{
+			b2Position* p = m_positions + indices[i];
+			p->c.Set(cx[i], cy[i]);
+			p->a = a[i];
+		}
+	}
+}
+
+inline b2Vec2W b2RotateW(const b2PositionW& xf, const b2Vec2W& v)
+{
+	b2Vec2W u;
+	u.x = b2SubW(b2MulW(xf.cos, v.x), b2MulW(xf.sin, v.y));
+	u.y = b2AddW(b2MulW(xf.sin, v.x), b2MulW(xf.cos, v.y));
+	return u;
+}
+
+inline b2Vec2W b2TransformW(const b2PositionW& xf, const b2Vec2W& v)
+{
+	b2Vec2W u = b2RotateW(xf, v);
+	u.x = b2AddW(xf.p.x, u.x);
+	u.y = b2AddW(xf.p.y, u.y);
+	return u;
+}
+
+inline b2PositionW b2SelectW(b2FloatW mask, const b2PositionW& a, const b2PositionW& b)
+{
+	b2PositionW xf;
+	xf.c = b2SelectW(mask, a.c, b.c);
+	xf.a = b2SelectW(mask, a.a, b.a);
+	xf.p = b2SelectW(mask, a.p, b.p);
+	xf.cos = b2SelectW(mask, a.cos, b.cos);
+	xf.sin = b2SelectW(mask, a.sin, b.sin);
+	return xf;
+}
+
+// Relative velocity at a contact point, vB + b2Cross(wB, rB) - vA - b2Cross(wA, rA).
+inline b2Vec2W b2RelativeVelocityW(const b2VelocityW& A, const b2Vec2W& rA, const b2VelocityW& B, const b2Vec2W& rB)
+{
+	b2Vec2W dv;
+	dv.x = b2AddW(b2SubW(b2SubW(B.v.x, b2MulW(B.w, rB.y)), A.v.x), b2MulW(A.w, rA.y));
+	dv.y = b2SubW(b2SubW(b2AddW(B.v.y, b2MulW(B.w, rB.x)), A.v.y), b2MulW(A.w, rA.x));
+	return dv;
+}
+
+// Apply the impulses P1 at rA1, rB1 and P2 at rA2, rB2.
+inline void b2ApplyImpulsesW(const b2WideContactConstraint* wc, b2VelocityW* A, b2VelocityW* B,
+							 const b2Vec2W& P1, const b2Vec2W& rA1, const b2Vec2W& rB1,
+							 const b2Vec2W& P2, const b2Vec2W& rA2, const b2Vec2W& rB2)
+{
+	b2Vec2W P;
+	P.x = b2AddW(P1.x, P2.x);
+	P.y = b2AddW(P1.y, P2.y);
+
+	A->v.x = b2SubW(A->v.x, b2MulW(wc->invMassA, P.x));
+	A->v.y = b2SubW(A->v.y, b2MulW(wc->invMassA, P.y));
+	A->w = b2SubW(A->w, b2MulW(wc->invIA, b2AddW(b2CrossW(rA1, P1), b2CrossW(rA2, P2))));
+
+	B->v.x = b2AddW(B->v.x, b2MulW(wc->invMassB, P.x));
+	B->v.y = b2AddW(B->v.y, b2MulW(wc->invMassB, P.y));
+	B->w = b2AddW(B->w, b2MulW(wc->invIB, b2AddW(b2CrossW(rB1, P1), b2CrossW(rB2, P2))));
+}
+
+// Apply a single impulse P at rA, rB.
+inline void b2ApplyImpulseW(const b2WideContactConstraint* wc, b2VelocityW* A, b2VelocityW* B,
+							const b2Vec2W& P, const b2Vec2W& rA, const b2Vec2W& rB)
+{
+	A->v.x = b2SubW(A->v.x, b2MulW(wc->invMassA, P.x));
+	A->v.y = b2SubW(A->v.y, b2MulW(wc->invMassA, P.y));
+	A->w = b2SubW(A->w, b2MulW(wc->invIA, b2CrossW(rA, P)));
+
+	B->v.x = b2AddW(B->v.x, b2MulW(wc->invMassB, P.x));
+	B->v.y = b2AddW(B->v.y, b2MulW(wc->invMassB, P.y));
+	B->w = b2AddW(B->w, b2MulW(wc->invIB, b2CrossW(rB, P)));
+}
+
+// Runs a pass of the wide solver over some of the groups of one color.
+class b2WideContactTask : public b2Task
+{
+public:
+	void Execute(int32 begin, int32 end, int32 threadIndex)
+	{
+		begin += m_start;
+		end += m_start;
+
+		switch (m_pass)
+		{
+		case b2ContactSolver::e_warmStartPass:
+			m_solver->WarmStartWide(begin, end);
+			break;
+
+		case b2ContactSolver::e_velocityPass:
+			m_solver->SolveVelocityConstraintsWide(begin, end);
+			break;
+
+		case b2ContactSolver::e_positionPass:
+			{
+				float32 separation = m_solver->SolvePositionConstraintsWide(begin, end, m_baumgarte);
+				m_minSeparations[threadIndex] = b2Min(m_minSeparations[threadIndex], separation);
+			}
+			break;
+		}
+	}
+
+	b2ContactSolver* m_solver;
+	b2ContactSolver::WidePass m_pass;
+	float32 m_baumgarte;
+	int32 m_start;
+	float32* m_minSeparations;
+};
+
+// Solve the colors one after another. The groups of a color share no dynamic
+// body, so they can be solved on several threads at the same time without
+// changing the result. Returns the minimum separation of the position pass.
+float32 b2ContactSolver::SolveWide(WidePass pass, float32 baumgarte)
+{
+	int32 threadCount = m_taskScheduler ? b2Max(m_taskScheduler->GetThreadCount(), 1) : 1;
+	float32* minSeparations = (float32*)m_allocator->Allocate(threadCount * sizeof(float32));
+	for (int32 i = 0; i < threadCount; ++i)
+	{
+		minSeparations[i] = 0.0f;
+	}
+
+	b2WideContactTask task;
+	task.m_solver = this;
+	task.m_pass = pass;
+	task.m_baumgarte = baumgarte;
+	task.m_minSeparations = minSeparations;
+
+	for (int32 i = 0; i < m_colorCount; ++i)
+	{
+		task.m_start = m_colorStarts[i];
+		int32 count = m_colorStarts[i + 1] - m_colorStarts[i];
+		if (m_taskScheduler && count > e_minParallelGroups)
+		{
+			m_taskScheduler->ParallelFor(&task, count, e_minParallelGroups);
+		}
+		else
+		{
+			task.Execute(0, count, 0);
+		}
+	}
+
+	float32 minSeparation = 0.0f;
+	for (int32 i = 0; i < threadCount; ++i)
+	{
+		minSeparation = b2Min(minSeparation, minSeparations[i]);
+	}
+
+	m_allocator->Free(minSeparations);
+	return minSeparation;
+}
+
+// Sort the constraints into groups that can be solved side by side, using
+// greedy graph coloring: a constraint gets the first color that neither of
+// its dynamic bodies has yet. Static and kinematic bodies don't take part,
+// as the solver doesn't change their velocity or position.
+void b2ContactSolver::BuildWideConstraints(b2Contact* const* contacts)
+{
+	// Each color has less than one group of unused lanes.
+	int32 maxWideCount = (m_constraintCount + B2_SIMD_WIDTH - 1) / B2_SIMD_WIDTH + e_maxColors;
+	int32 alignment = sizeof(b2FloatW);
+	m_wideMemory = m_allocator->Allocate(maxWideCount * sizeof(b2WideContactConstraint) + alignment);
+	int32 misalignment = int32((size_t)m_wideMemory % alignment);
+	m_wideConstraints = (b2WideContactConstraint*)((char*)m_wideMemory + (misalignment ? alignment - misalignment : 0));
+
+	m_scalarIndices = (int32*)m_allocator->Allocate(m_constraintCount * sizeof(int32));
+	m_scalarCount = 0;
+
+	// Find the dynamic bodies and the range of their island indices.
+	int32* dynamic = (int32*)m_allocator->Allocate(2 * m_constraintCount * sizeof(int32));
+	int32 lowIndex = 0;
+	int32 highIndex = -1;
+	for (int32 i = 0; i < m_constraintCount; ++i)
+	{
+		dynamic[2 * i + 0] = contacts[i]->m_fixtureA->GetBody()->GetType() == b2_dynamicBody;
+		dynamic[2 * i + 1] = contacts[i]->m_fixtureB->GetBody()->GetType() == b2_dynamicBody;
+
+		int32 indices[2] = { m_constraints[i].indexA, m_constraints[i].indexB };
+		for (int32 j = 0; j < 2; ++j)
+		{
+			if (dynamic[2 * i + j] == 0)
+			{
+				continue;
+			}
+
+			int32 index = indices[j];
+			lowIndex = highIndex < lowIndex ? index : b2Min(lowIndex, index);
+			highIndex = highIndex < lowIndex ? index : b2Max(highIndex, index);
+		}
+	}
+
+	int32 bodyCount = b2Max(highIndex - lowIndex + 1, 1);
+	int32* colors = (int32*)m_allocator->Allocate(m_constraintCount * sizeof(int32));
+	uint32* bodyColors = (uint32*)m_allocator->Allocate(bodyCount * sizeof(uint32));
+	memset(bodyColors, 0, bodyCount * sizeof(uint32));
+
+	int32 colorCounts[e_maxColors];
+	memset(colorCounts, 0, sizeof(colorCounts));
+
+	for (int32 i = 0; i < m_constraintCount; ++i)
+	{
+		b2ContactConstraint* c = m_constraints + i;
+
+		int32 indexA = dynamic[2 * i + 0] != 0 ? c->indexA - lowIndex : -1;
+		int32 indexB = dynamic[2 * i + 1] != 0 ? c->indexB - lowIndex : -1;
+
+		uint32 used = 0;
+		used |= indexA != -1 ? bodyColors[indexA] : 0;
+		used |= indexB != -1 ? bodyColors[indexB] : 0;
+
+		int32 color = 0;
+		while (color < e_maxColors && (used & (1u << color)))
+		{
+			++color;
+		}
+
+		if (color == e_maxColors)
+		{
+			colors[i] = -1;
+			m_scalarIndices[m_scalarCount++] = i;
+			continue;
+		}
+
+		colors[i] = color;
+		++colorCounts[color];
+		m_colorCount = b2Max(m_colorCount, color + 1);
+
+		if (indexA != -1)
+		{
+			bodyColors[indexA] |= 1u << color;
+		}
+		if (indexB != -1)
+		{
+			bodyColors[indexB] |= 1u << color;
+		}
+	}
+
+	for (int32 i = 0; i < m_colorCount; ++i)
+	{
+		int32 groupCount = (colorCounts[i] + B2_SIMD_WIDTH - 1) / B2_SIMD_WIDTH;
+		m_colorStarts[i + 1] = m_colorStarts[i] + groupCount;
+	}
+	m_wideCount = m_colorStarts[m_colorCount];
+	b2Assert(m_wideCount <= maxWideCount);
+
+	// Unused lanes have no bodies, zero mass and zero masks.
+	memset((void*)m_wideConstraints, 0, m_wideCount * sizeof(b2WideContactConstraint));
+	for (int32 i = 0; i < m_wideCount; ++i)
+	{
+		for (int32 j = 0; j < B2_SIMD_WIDTH; ++j)
+		{
+			m_wideConstraints[i].indexA[j] = -1;
+			m_wideConstraints[i].indexB[j] = -1;
+			m_wideConstraints[i].indices[j] = -1;
+		}
+	}
+
+	memset(colorCounts, 0, sizeof(colorCounts));
+	for (int32 i = 0; i < m_constraintCount; ++i)
+	{
+		int32 color = colors[i];
+		if (color == -1)
+		{
+			continue;
+		}
+
+		int32 slot = colorCounts[color]++;
+		b2WideContactConstraint* wc = m_wideConstraints + m_colorStarts[color] + slot / B2_SIMD_WIDTH;
+		int32 j = slot % B2_SIMD_WIDTH;
+
+		const b2ContactConstraint* c = m_constraints + i;
+		const b2ContactConstraintPoint* cp1 = c->points + 0;
+		const b2ContactConstraintPoint* cp2 = c->points + 1;
+
+		wc->indexA[j] = c->indexA;
+		wc->indexB[j] = c->indexB;
+		wc->dynamicA[j] = dynamic[2 * i + 0] != 0;
+		wc->dynamicB[j] = dynamic[2 * i + 1] != 0;
+		wc->localCenterA[j] = c->localCenterA;
+		wc->localCenterB[j] = c->localCenterB;
+		wc->indices[j] = i;
+		wc->pointCounts[j] = c->pointCount;
+
+		b2SetLane(wc->invMassA, j, c->invMassA);
+		b2SetLane(wc->invIA, j, c->invIA);
+		b2SetLane(wc->invMassB, j, c->invMassB);
+		b2SetLane(wc->invIB, j, c->invIB);
+		b2SetLane(wc->normal, j, c->normal);
+		b2SetLane(wc->friction, j, c->friction);
+
+		b2SetLane(wc->rA1, j, cp1->rA);
+		b2SetLane(wc->rB1, j, cp1->rB);
+		b2SetLane(wc->normalImpulse1, j, cp1->normalImpulse);
+		b2SetLane(wc->tangentImpulse1, j, cp1->tangentImpulse);
+		b2SetLane(wc->normalMass1, j, cp1->normalMass);
+		b2SetLane(wc->tangentMass1, j, cp1->tangentMass);
+		b2SetLane(wc->velocityBias1, j, cp1->velocityBias);
+
+		if (c->pointCount == 2)
+		{
+			b2SetLane(wc->rA2, j, cp2->rA);
+			b2SetLane(wc->rB2, j, cp2->rB);
+			b2SetLane(wc->normalImpulse2, j, cp2->normalImpulse);
+			b2SetLane(wc->tangentImpulse2, j, cp2->tangentImpulse);
+			b2SetLane(wc->normalMass2, j, cp2->normalMass);
+			b2SetLane(wc->tangentMass2, j, cp2->tangentMass);
+			b2SetLane(wc->velocityBias2, j, cp2->velocityBias);
+
+			b2SetLane(wc->K1, j, c->K.col1);
+			b2SetLane(wc->K2, j, c->K.col2);
+			b2SetLane(wc->normalMassCol1, j, c->normalMass.col1);
+			b2SetLane(wc->normalMassCol2, j, c->normalMass.col2);
+			b2SetMaskLane(wc->blockMask, j, true);
+
+			b2SetLane(wc->localPoint2, j, cp2->localPoint);
+		}
+
+		b2SetLane(wc->positionInvMassA, j, c->positionInvMassA);
+		b2SetLane(wc->positionInvIA, j, c->positionInvIA);
+		b2SetLane(wc->positionInvMassB, j, c->positionInvMassB);
+		b2SetLane(wc->positionInvIB, j, c->positionInvIB);
+		b2SetLane(wc->localNormal, j, c->localNormal);
+		b2SetLane(wc->localPoint, j, c->localPoint);
+		b2SetLane(wc->localPoint1, j, cp1->localPoint);
+		b2SetLane(wc->radius, j, c->radius);
+		b2SetMaskLane(wc->circlesMask, j, c->type == b2Manifold::e_circles);
+		b2SetMaskLane(wc->faceBMask, j, c->type == b2Manifold::e_faceB);
+		b2SetMaskLane(wc->laneMask, j, true);
+	}
+
+	m_allocator->Free(bodyColors);
+	m_allocator->Free(colors);
+	m_allocator->Free(dynamic);
+}
+
+void b2ContactSolver::WarmStartWide(int32 begin, int32 end)
+{
+	for (int32 i = begin; i < end; ++i)
+	{
+		const b2WideContactConstraint* wc = m_wideConstraints + i;
+
+		b2VelocityW A = GatherVelocities(wc->indexA);
+		b2VelocityW B = GatherVelocities(wc->indexB);
+
+		b2Vec2W normal = wc->normal;
+		b2Vec2W tangent;
+		tangent.x = normal.y;
+		tangent.y = b2SubW(b2ZeroW(), normal.x);
+
+		b2Vec2W P1, P2;
+		P1.x = b2AddW(b2MulW(wc->normalImpulse1, normal.x), b2MulW(wc->tangentImpulse1, tangent.x));
+		P1.y = b2AddW(b2MulW(wc->normalImpulse1, normal.y), b2MulW(wc->tangentImpulse1, tangent.y));
+		P2.x = b2AddW(b2MulW(wc->normalImpulse2, normal.x), b2MulW(wc->tangentImpulse2, tangent.x));
+		P2.y = b2AddW(b2MulW(wc->normalImpulse2, normal.y), b2MulW(wc->tangentImpulse2, tangent.y));
+
+		b2ApplyImpulseW(wc, &A, &B, P1, wc->rA1, wc->rB1);
+		b2ApplyImpulseW(wc, &A, &B, P2, wc->rA2, wc->rB2);
+
+		ScatterVelocities(wc->indexA, wc->dynamicA, A);
+		ScatterVelocities(wc->indexB, wc->dynamicB, B);
+	}
+}
+
+// The lane-parallel version of SolveVelocityConstraints. Constraints with a
+// single point compute the block solution too, but keep the single point
+// solution.
+void b2ContactSolver::SolveVelocityConstraintsWide(int32 begin, int32 end)
+{
+	const b2FloatW zero = b2ZeroW();
+
+	for (int32 i = begin; i < end; ++i)
+	{
+		b2WideContactConstraint* wc = m_wideConstraints + i;
+
+		b2VelocityW A = GatherVelocities(wc->indexA);
+		b2VelocityW B = GatherVelocities(wc->indexB);
+
+		b2Vec2W normal = wc->normal;
+		b2Vec2W tangent;
+		tangent.x = normal.y;
+		tangent.y = b2SubW(zero, normal.x);
+
+		// Solve tangent constraints
+		{
+			b2Vec2W dv = b2RelativeVelocityW(A, wc->rA1, B, wc->rB1);
+			b2FloatW vt = b2DotW(dv, tangent);
+			b2FloatW lambda = b2MulW(wc->tangentMass1, b2SubW(zero, vt));
+			b2FloatW maxFriction = b2MulW(wc->friction, wc->normalImpulse1);
+			b2FloatW newImpulse = b2ClampW(b2AddW(wc->tangentImpulse1, lambda), b2SubW(zero, maxFriction), maxFriction);
+			lambda = b2SubW(newImpulse, wc->tangentImpulse1);
+
+			b2Vec2W P;
+			P.x = b2MulW(lambda, tangent.x);
+			P.y = b2MulW(lambda, tangent.y);
+			b2ApplyImpulseW(wc, &A, &B, P, wc->rA1, wc->rB1);
+
+			wc->tangentImpulse1 = newImpulse;
+		}
+
+		{
+			b2Vec2W dv = b2RelativeVelocityW(A, wc->rA2, B, wc->rB2);
+			b2FloatW vt = b2DotW(dv, tangent);
+			b2FloatW lambda = b2MulW(wc->tangentMass2, b2SubW(zero, vt));
+			b2FloatW maxFriction = b2MulW(wc->friction, wc->normalImpulse2);
+			b2FloatW newImpulse = b2ClampW(b2AddW(wc->tangentImpulse2, lambda), b2SubW(zero, maxFriction), maxFriction);
+			lambda = b2SubW(newImpulse, wc->tangentImpulse2);
+
+			b2Vec2W P;
+			P.x = b2MulW(lambda, tangent.x);
+			P.y = b2MulW(lambda, tangent.y);
+			b2ApplyImpulseW(wc, &A, &B, P, wc->rA2, wc->rB2);
+
+			wc->tangentImpulse2 = newImpulse;
+		}
+
+		// Solve normal constraints
+		b2FloatW a1 = wc->normalImpulse1;
+		b2FloatW a2 = wc->normalImpulse2;
+
+		b2Vec2W dv1 = b2RelativeVelocityW(A, wc->rA1, B, wc->rB1);
+		b2Vec2W dv2 = b2RelativeVelocityW(A, wc->rA2, B, wc->rB2);
+		b2FloatW vn1 = b2DotW(dv1, normal);
+		b2FloatW vn2 = b2DotW(dv2, normal);
+
+		// Single point
+		b2FloatW lambda = b2MulW(b2SubW(zero, wc->normalMass1), b2SubW(vn1, wc->velocityBias1));
+		b2FloatW x1 = b2MaxW(b2AddW(a1, lambda), zero);
+		b2FloatW x2 = a2;
+
+		// Block solver, see SolveVelocityConstraints. The cases are checked in
+		// reverse order, so that the first valid one wins.
+		b2FloatW bx = b2SubW(vn1, wc->velocityBias1);
+		b2FloatW by = b2SubW(vn2, wc->velocityBias2);
+		bx = b2SubW(bx, b2AddW(b2MulW(wc->K1.x, a1), b2MulW(wc->K2.x, a2)));
+		by = b2SubW(by, b2AddW(b2MulW(wc->K1.y, a1), b2MulW(wc->K2.y, a2)));
+
+		// Case 4: x1 = 0 and x2 = 0, no solution keeps the old impulses.
+		b2FloatW valid = b2AndW(b2GreaterEqualW(bx, zero), b2GreaterEqualW(by, zero));
+		b2FloatW blockX1 = b2SelectW(valid, zero, a1);
+		b2FloatW blockX2 = b2SelectW(valid, zero, a2);
+
+		// Case 3: vn2 = 0 and x1 = 0
+		b2FloatW caseX2 = b2MulW(b2SubW(zero, wc->normalMass2), by);
+		b2FloatW caseVn = b2AddW(b2MulW(wc->K2.x, caseX2), bx);
+		valid = b2AndW(b2GreaterEqualW(caseX2, zero), b2GreaterEqualW(caseVn, zero));
+		blockX1 = b2SelectW(valid, zero, blockX1);
+		blockX2 = b2SelectW(valid, caseX2, blockX2);
+
+		// Case 2: vn1 = 0 and x2 = 0
+		b2FloatW caseX1 = b2MulW(b2SubW(zero, wc->normalMass1), bx);
+		caseVn = b2AddW(b2MulW(wc->K1.y, caseX1), by);
+		valid = b2AndW(b2GreaterEqualW(caseX1, zero), b2GreaterEqualW(caseVn, zero));
+		blockX1 = b2SelectW(valid, caseX1, blockX1);
+		blockX2 = b2SelectW(valid, zero, blockX2);
+
+		// Case 1: vn = 0
+		caseX1 = b2SubW(zero, b2AddW(b2MulW(wc->normalMassCol1.x, bx), b2MulW(wc->normalMassCol2.x, by)));
+		caseX2 = b2SubW(zero, b2AddW(b2MulW(wc->normalMassCol1.y, bx), b2MulW(wc->normalMassCol2.y, by)));
+		valid = b2AndW(b2GreaterEqualW(caseX1, zero), b2GreaterEqualW(caseX2, zero));
+		blockX1 = b2SelectW(valid, caseX1, blockX1);
+		blockX2 = b2SelectW(valid, caseX2, blockX2);
+
+		x1 = b2SelectW(wc->blockMask, blockX1, x1);
+		x2 = b2SelectW(wc->blockMask, blockX2, x2);
+
+		// Apply incremental impulse
+		b2FloatW d1 = b2SubW(x1, a1);
+		b2FloatW d2 = b2SubW(x2, a2);
+		b2Vec2W P1, P2;
+		P1.x = b2MulW(d1, normal.x);
+		P1.y = b2MulW(d1, normal.y);
+		P2.x = b2MulW(d2, normal.x);
+		P2.y = b2MulW(d2, normal.y);
+		b2ApplyImpulsesW(wc, &A, &B, P1, wc->rA1, wc->rB1, P2, wc->rA2, wc->rB2);
+
+		wc->normalImpulse1 = x1;
+		wc->normalImpulse2 = x2;
+
+		ScatterVelocities(wc->indexA, wc->dynamicA, A);
+		ScatterVelocities(wc->indexB, wc->dynamicB, B);
+	}
+}
+
+// The lane-parallel version of SolvePositionConstraints. Returns the minimum
+// separation. Like the scalar version, the bodies are moved after each point.
+float32 b2ContactSolver::SolvePositionConstraintsWide(int32 begin, int32 end, float32 baumgarte)
+{
+	const b2FloatW zero = b2ZeroW();
+	const b2FloatW half = b2SplatW(0.5f);
+	const b2FloatW epsilonSquared = b2SplatW(b2_epsilon * b2_epsilon);
+	const b2FloatW baumgarteW = b2SplatW(baumgarte);
+	const b2FloatW slop = b2SplatW(b2_linearSlop);
+	const b2FloatW maxCorrection = b2SplatW(-b2_maxLinearCorrection);
+
+	b2FloatW minSeparation = zero;
+
+	for (int32 i = begin; i < end; ++i)
+	{
+		const b2WideContactConstraint* wc = m_wideConstraints + i;
+
+		for (int32 j = 0; j < b2_maxManifoldPoints; ++j)
+		{
+			b2FloatW active = j == 0 ? wc->laneMask : wc->blockMask;
+
+			b2PositionW xfA = GatherPositions(wc->indexA, wc->localCenterA);
+			b2PositionW xfB = GatherPositions(wc->indexB, wc->localCenterB);
+
+			// Face manifolds, with the reference face on body A unless faceB.
+			b2PositionW xfRef = b2SelectW(wc->faceBMask, xfB, xfA);
+			b2PositionW xfInc = b2SelectW(wc->faceBMask, xfA, xfB);
+
+			b2Vec2W faceNormal = b2RotateW(xfRef, wc->localNormal);
+			b2Vec2W planePoint = b2TransformW(xfRef, wc->localPoint);
+			b2Vec2W clipPoint = b2TransformW(xfInc, j == 0 ? wc->localPoint1 : wc->localPoint2);
+
+			b2Vec2W d;
+			d.x = b2SubW(clipPoint.x, planePoint.x);
+			d.y = b2SubW(clipPoint.y, planePoint.y);
+			b2FloatW separation = b2SubW(b2DotW(d, faceNormal), wc->radius);
+
+			b2Vec2W flippedNormal;
+			flippedNormal.x = b2SubW(zero, faceNormal.x);
+			flippedNormal.y = b2SubW(zero, faceNormal.y);
+			b2Vec2W normal = b2SelectW(wc->faceBMask, flippedNormal, faceNormal);
+			b2Vec2W point = clipPoint;
+
+			// Circle manifolds, where planePoint and clipPoint are the centers.
+			b2FloatW lengthSquared = b2DotW(d, d);
+			b2FloatW invLength = b2DivW(b2SplatW(1.0f), b2SqrtW(lengthSquared));
+			b2Vec2W circleNormal;
+			circleNormal.x = b2MulW(d.x, invLength);
+			circleNormal.y = b2MulW(d.y, invLength);
+			b2FloatW separated = b2GreaterW(lengthSquared, epsilonSquared);
+			circleNormal.x = b2SelectW(separated, circleNormal.x, b2SplatW(1.0f));
+			circleNormal.y = b2SelectW(separated, circleNormal.y, zero);
+
+			b2Vec2W circlePoint;
+			circlePoint.x = b2MulW(half, b2AddW(planePoint.x, clipPoint.x));
+			circlePoint.y = b2MulW(half, b2AddW(planePoint.y, clipPoint.y));
+			b2FloatW circleSeparation = b2SubW(b2DotW(d, circleNormal), wc->radius);
+
+			normal = b2SelectW(wc->circlesMask, circleNormal, normal);
+			point = b2SelectW(wc->circlesMask, circlePoint, point);
+			separation = b2SelectW(wc->circlesMask, circleSeparation, separation);
+
+			b2Vec2W rA, rB;
+			rA.x = b2SubW(point.x, xfA.c.x);
+			rA.y = b2SubW(point.y, xfA.c.y);
+			rB.x = b2SubW(point.x, xfB.c.x);
+			rB.y = b2SubW(point.y, xfB.c.y);
+
+			// Track max constraint error.
+			minSeparation = b2SelectW(active, b2MinW(minSeparation, separation), minSeparation);
+
+			// Prevent large corrections and allow slop.
+			b2FloatW C = b2ClampW(b2MulW(baumgarteW, b2AddW(separation, slop)), maxCorrection, zero);
+
+			// Compute the effective mass.
+			b2FloatW rnA = b2CrossW(rA, normal);
+			b2FloatW rnB = b2CrossW(rB, normal);
+			b2FloatW K = b2AddW(wc->positionInvMassA, wc->positionInvMassB);
+			K = b2AddW(K, b2MulW(b2MulW(wc->positionInvIA, rnA), rnA));
+			K = b2AddW(K, b2MulW(b2MulW(wc->positionInvIB, rnB), rnB));
+
+			// Compute normal impulse
+			b2FloatW solvable = b2AndW(active, b2GreaterW(K, zero));
+			b2FloatW safeK = b2SelectW(solvable, K, b2SplatW(1.0f));
+			b2FloatW impulse = b2SelectW(solvable, b2DivW(b2SubW(zero, C), safeK), zero);
+
+			b2Vec2W P;
+			P.x = b2MulW(impulse, normal.x);
+			P.y = b2MulW(impulse, normal.y);
+
+			xfA.c.x = b2SubW(xfA.c.x, b2MulW(wc->positionInvMassA, P.x));
+			xfA.c.y = b2SubW(xfA.c.y, b2MulW(wc->positionInvMassA, P.y));
+			xfA.a = b2SubW(xfA.a, b2MulW(wc->positionInvIA, b2CrossW(rA, P)));
+
+			xfB.c.x = b2AddW(xfB.c.x, b2MulW(wc->positionInvMassB, P.x));
+			xfB.c.y = b2AddW(xfB.c.y, b2MulW(wc->positionInvMassB, P.y));
+			xfB.a = b2AddW(xfB.a, b2MulW(wc->positionInvIB, b2CrossW(rB, P)));
+
+			ScatterPositions(wc->indexA, wc->dynamicA, wc->pointCounts, j, xfA);
+			ScatterPositions(wc->indexB, wc->dynamicB, wc->pointCounts, j, xfB);
+		}
+	}
+
+	return b2ReduceMinW(minSeparation);
+}
+
+#endif
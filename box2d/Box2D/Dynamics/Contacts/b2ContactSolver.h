@@ -20,12 +20,14 @@
 #define B2_CONTACT_SOLVER_H
 
 #include <Box2D/Common/b2Math.h>
+#include <Box2D/Common/b2SIMD.h>
 #include <Box2D/Collision/b2Collision.h>
 #include <Box2D/Dynamics/b2Island.h>
 
 class b2Contact;
 class b2Body;
 class b2StackAllocator;
+class b2TaskScheduler;
 
 struct b2ContactConstraintPoint
 {
@@ -47,8 +49,14 @@ struct b2ContactConstraint
 	b2Vec2 normal;
 	b2Mat22 normalMass;
 	b2Mat22 K;
-	b2Body* bodyA;
-	b2Body* bodyB;
+	int32 indexA;
+	int32 indexB;
+	float32 invMassA, invIA;
+	float32 invMassB, invIB;
+	float32 positionInvMassA, positionInvIA;
+	float32 positionInvMassB, positionInvIB;
+	b2Vec2 localCenterA;
+	b2Vec2 localCenterB;
 	b2Manifold::Type type;
 	float32 radius;
 	float32 friction;
@@ -56,11 +64,69 @@ struct b2ContactConstraint
 	b2Manifold* manifold;
 };
 
+#ifdef B2_SIMD_WIDTH
+
+/// Contact constraints solved side by side, one per lane, in structure of
+/// arrays layout. No two constraints share a dynamic body. Unused lanes have
+/// no bodies and zero masses. Only the dynamic bodies are stored back, as
+/// static and kinematic bodies may appear in several lanes. A constraint
+/// with a single point has zero mass and impulse for the second point.
+struct b2WideContactConstraint
+{
+	// Velocity constraints
+	b2FloatW invMassA, invIA, invMassB, invIB;
+	b2Vec2W normal;
+	b2FloatW friction;
+	b2Vec2W rA1, rB1, rA2, rB2;
+	b2FloatW normalImpulse1, normalImpulse2;
+	b2FloatW tangentImpulse1, tangentImpulse2;
+	b2FloatW normalMass1, normalMass2;
+	b2FloatW tangentMass1, tangentMass2;
+	b2FloatW velocityBias1, velocityBias2;
+	b2Vec2W K1, K2, normalMassCol1, normalMassCol2; // block solver
+	b2FloatW blockMask; // two points
+
+	// Position constraints
+	b2FloatW positionInvMassA, positionInvIA, positionInvMassB, positionInvIB;
+	b2Vec2W localNormal, localPoint, localPoint1, localPoint2;
+	b2FloatW radius;
+	b2FloatW circlesMask, faceBMask;
+	b2FloatW laneMask; // used lanes
+
+	int32 indexA[B2_SIMD_WIDTH]; // into the solver arrays, or -1
+	int32 indexB[B2_SIMD_WIDTH];
+	bool dynamicA[B2_SIMD_WIDTH];
+	bool dynamicB[B2_SIMD_WIDTH];
+	b2Vec2 localCenterA[B2_SIMD_WIDTH];
+	b2Vec2 localCenterB[B2_SIMD_WIDTH];
+	int32 indices[B2_SIMD_WIDTH]; // into m_constraints, or -1
+	int32 pointCounts[B2_SIMD_WIDTH];
+};
+
+/// The velocity of a body in each lane.
+struct b2VelocityW
+{
+	b2Vec2W v;
+	b2FloatW w;
+};
+
+/// The position of a body in each lane, with the transform derived from it.
+struct b2PositionW
+{
+	b2Vec2W c;
+	b2FloatW a;
+	b2Vec2W p;
+	b2FloatW cos, sin;
+};
+
+#endif
+
 class b2ContactSolver
 {
 public:
 	b2ContactSolver(b2Contact** contacts, int32 contactCount,
-					b2StackAllocator* allocator, float32 impulseRatio);
+					b2Position* positions, b2Velocity* velocities,
+					b2StackAllocator* allocator, float32 impulseRatio, bool wide);
 
 	~b2ContactSolver();
 
@@ -71,8 +137,52 @@ public:
 	bool SolvePositionConstraints(float32 baumgarte);
 
 	b2StackAllocator* m_allocator;
+	b2TaskScheduler* m_taskScheduler;
+	b2Position* m_positions;
+	b2Velocity* m_velocities;
 	b2ContactConstraint* m_constraints;
 	int m_constraintCount;
+
+#ifdef B2_SIMD_WIDTH
+	// Graph coloring gives up beyond this many colors. The remaining
+	// constraints are solved one by one. With a task scheduler, a color is
+	// split into ranges of at least e_minParallelGroups groups.
+	enum
+	{
+		e_maxColors = 32,
+		e_minParallelGroups = 8
+	};
+
+	enum WidePass
+	{
+		e_warmStartPass,
+		e_velocityPass,
+		e_positionPass
+	};
+
+	void BuildWideConstraints(b2Contact* const* contacts);
+	float32 SolveWide(WidePass pass, float32 baumgarte);
+	void WarmStartWide(int32 begin, int32 end);
+	void SolveVelocityConstraintsWide(int32 begin, int32 end);
+	float32 SolvePositionConstraintsWide(int32 begin, int32 end, float32 baumgarte);
+
+	b2VelocityW GatherVelocities(const int32* indices) const;
+	void ScatterVelocities(const int32* indices, const bool* dynamic, const b2VelocityW& velocity);
+	b2PositionW GatherPositions(const int32* indices, const b2Vec2* localCenters) const;
+	void ScatterPositions(const int32* indices, const bool* dynamic, const int32* pointCounts, int32 index, const b2PositionW& position);
+
+	// Groups of constraints, sorted by color.
+	void* m_wideMemory;
+	b2WideContactConstraint* m_wideConstraints;
+	int32 m_wideCount;
+	int32 m_colorCount;
+	int32 m_colorStarts[e_maxColors + 1];
+#endif
+
+	// Constraints that are solved one by one, after any groups. NULL
+	// indices mean all constraints.
+	int32* m_scalarIndices;
+	int32 m_scalarCount;
 };
 
 #endif
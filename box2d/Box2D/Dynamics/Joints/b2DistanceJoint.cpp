@@ -60,15 +60,34 @@ b2DistanceJoint::b2DistanceJoint(const b2DistanceJointDef* def)
 	m_bias = 0.0f;
 }
 
-void b2DistanceJoint::InitVelocityConstraints(const b2TimeStep& step)
+void b2DistanceJoint::InitVelocityConstraints(const b2SolverData& data)
 {
 	b2Body* b1 = m_bodyA;
 	b2Body* b2 = m_bodyB;
 
+	m_localCenterA = b1->GetLocalCenter();
+	m_localCenterB = b2->GetLocalCenter();
+	m_invMassA = b1->m_invMass;
+	m_invMassB = b2->m_invMass;
+	m_invIA = b1->m_invI;
+	m_invIB = b2->m_invI;
+
+	b2Vec2 cA = data.positions[m_indexA].c;
+	float32 aA = data.positions[m_indexA].a;
+	b2Vec2 vA = data.velocities[m_indexA].v;
+	float32 wA = data.velocities[m_indexA].w;
+
+	b2Vec2 cB = data.positions[m_indexB].c;
+	float32 aB = data.positions[m_indexB].a;
+	b2Vec2 vB = data.velocities[m_indexB].v;
+	float32 wB = data.velocities[m_indexB].w;
+
+	b2Mat22 R1(aA), R2(aB);
+
 	// Compute the effective mass matrix.
-	b2Vec2 r1 = b2Mul(b1->GetTransform().R, m_localAnchor1 - b1->GetLocalCenter());
-	b2Vec2 r2 = b2Mul(b2->GetTransform().R, m_localAnchor2 - b2->GetLocalCenter());
-	m_u = b2->m_sweep.c + r2 - b1->m_sweep.c - r1;
+	b2Vec2 r1 = b2Mul(R1, m_localAnchor1 - m_localCenterA);
+	b2Vec2 r2 = b2Mul(R2, m_localAnchor2 - m_localCenterB);
+	m_u = cB + r2 - cA - r1;
 
 	// Handle singularity.
 	float32 length = m_u.Length();
@@ -83,7 +102,7 @@ void b2DistanceJoint::InitVelocityConstraints(const b2TimeStep& step)
 
 	float32 cr1u = b2Cross(r1, m_u);
 	float32 cr2u = b2Cross(r2, m_u);
-	float32 invMass = b1->m_invMass + b1->m_invI * cr1u * cr1u + b2->m_invMass + b2->m_invI * cr2u * cr2u;
+	float32 invMass = m_invMassA + m_invIA * cr1u * cr1u + m_invMassB + m_invIB * cr2u * cr2u;
 
 	m_mass = invMass != 0.0f ? 1.0f / invMass : 0.0f;
 
@@ -101,73 +120,87 @@ void b2DistanceJoint::InitVelocityConstraints(const b2TimeStep& step)
 		float32 k = m_mass * omega * omega;
 
 		// magic formulas
-		m_gamma = step.dt * (d + step.dt * k);
+		m_gamma = data.step.dt * (d + data.step.dt * k);
 		m_gamma = m_gamma != 0.0f ? 1.0f / m_gamma : 0.0f;
-		m_bias = C * step.dt * k * m_gamma;
+		m_bias = C * data.step.dt * k * m_gamma;
 
 		m_mass = invMass + m_gamma;
 		m_mass = m_mass != 0.0f ? 1.0f / m_mass : 0.0f;
 	}
 
-	if (step.warmStarting)
+	if (data.step.warmStarting)
 	{
 		// Scale the impulse to support a variable time step.
-		m_impulse *= step.dtRatio;
+		m_impulse *= data.step.dtRatio;
 
 		b2Vec2 P = m_impulse * m_u;
-		b1->m_linearVelocity -= b1->m_invMass * P;
-		b1->m_angularVelocity -= b1->m_invI * b2Cross(r1, P);
-		b2->m_linearVelocity += b2->m_invMass * P;
-		b2->m_angularVelocity += b2->m_invI * b2Cross(r2, P);
+		vA -= m_invMassA * P;
+		wA -= m_invIA * b2Cross(r1, P);
+		vB += m_invMassB * P;
+		wB += m_invIB * b2Cross(r2, P);
 	}
 	else
 	{
 		m_impulse = 0.0f;
 	}
+
+	data.velocities[m_indexA].v = vA;
+	data.velocities[m_indexA].w = wA;
+	data.velocities[m_indexB].v = vB;
+	data.velocities[m_indexB].w = wB;
 }
 
-void b2DistanceJoint::SolveVelocityConstraints(const b2TimeStep& step)
+void b2DistanceJoint::SolveVelocityConstraints(const b2SolverData& data)
 {
-	B2_NOT_USED(step);
+	b2Vec2 vA = data.velocities[m_indexA].v;
+	float32 wA = data.velocities[m_indexA].w;
+	b2Vec2 vB = data.velocities[m_indexB].v;
+	float32 wB = data.velocities[m_indexB].w;
 
-	b2Body* b1 = m_bodyA;
-	b2Body* b2 = m_bodyB;
+	b2Mat22 R1(data.positions[m_indexA].a), R2(data.positions[m_indexB].a);
 
-	b2Vec2 r1 = b2Mul(b1->GetTransform().R, m_localAnchor1 - b1->GetLocalCenter());
-	b2Vec2 r2 = b2Mul(b2->GetTransform().R, m_localAnchor2 - b2->GetLocalCenter());
+	b2Vec2 r1 = b2Mul(R1, m_localAnchor1 - m_localCenterA);
+	b2Vec2 r2 = b2Mul(R2, m_localAnchor2 - m_localCenterB);
 
 	// Cdot = dot(u, v + cross(w, r))
-	b2Vec2 v1 = b1->m_linearVelocity + b2Cross(b1->m_angularVelocity, r1);
-	b2Vec2 v2 = b2->m_linearVelocity + b2Cross(b2->m_angularVelocity, r2);
+	b2Vec2 v1 = vA + b2Cross(wA, r1);
+	b2Vec2 v2 = vB + b2Cross(wB, r2);
 	float32 Cdot = b2Dot(m_u, v2 - v1);
 
 	float32 impulse = -m_mass * (Cdot + m_bias + m_gamma * m_impulse);
 	m_impulse += impulse;
 
 	b2Vec2 P = impulse * m_u;
-	b1->m_linearVelocity -= b1->m_invMass * P;
-	b1->m_angularVelocity -= b1->m_invI * b2Cross(r1, P);
-	b2->m_linearVelocity += b2->m_invMass * P;
-	b2->m_angularVelocity += b2->m_invI * b2Cross(r2, P);
+	vA -= m_invMassA * P;
+	wA -= m_invIA * b2Cross(r1, P);
+	vB += m_invMassB * P;
+	wB += m_invIB * b2Cross(r2, P);
+
+	data.velocities[m_indexA].v = vA;
+	data.velocities[m_indexA].w = wA;
+	data.velocities[m_indexB].v = vB;
+	data.velocities[m_indexB].w = wB;
 }
 
-bool b2DistanceJoint::SolvePositionConstraints(float32 baumgarte)
+bool b2DistanceJoint::SolvePositionConstraints(const b2SolverData& data)
 {
-	B2_NOT_USED(baumgarte);
-
 	if (m_frequencyHz > 0.0f)
 	{
 		// There is no position correction for soft distance constraints.
 		return true;
 	}
 
-	b2Body* b1 = m_bodyA;
-	b2Body* b2 = m_bodyB;
+	b2Vec2 cA = data.positions[m_indexA].c;
+	float32 aA = data.positions[m_indexA].a;
+	b2Vec2 cB = data.positions[m_indexB].c;
+	float32 aB = data.positions[m_indexB].a;
+
+	b2Mat22 R1(aA), R2(aB);
 
-	b2Vec2 r1 = b2Mul(b1->GetTransform().R, m_localAnchor1 - b1->GetLocalCenter());
-	b2Vec2 r2 = b2Mul(b2->GetTransform().R, m_localAnchor2 - b2->GetLocalCenter());
+	b2Vec2 r1 = b2Mul(R1, m_localAnchor1 - m_localCenterA);
+	b2Vec2 r2 = b2Mul(R2, m_localAnchor2 - m_localCenterB);
 
-	b2Vec2 d = b2->m_sweep.c + r2 - b1->m_sweep.c - r1;
+	b2Vec2 d = cB + r2 - cA - r1;
 
 	float32 length = d.Normalize();
 	float32 C = length - m_length;
@@ -177,13 +210,15 @@ bool b2DistanceJoint::SolvePositionConstraints(float32 baumgarte)
 	m_u = d;
 	b2Vec2 P = impulse * m_u;
 
-	b1->m_sweep.c -= b1->m_invMass * P;
-	b1->m_sweep.a -= b1->m_invI * b2Cross(r1, P);
-	b2->m_sweep.c += b2->m_invMass * P;
-	b2->m_sweep.a += b2->m_invI * b2Cross(r2, P);
+	cA -= m_invMassA * P;
+	aA -= m_invIA * b2Cross(r1, P);
+	cB += m_invMassB * P;
+	aB += m_invIB * b2Cross(r2, P);
 
-	b1->SynchronizeTransform();
-	b2->SynchronizeTransform();
+	data.positions[m_indexA].c = cA;
+	data.positions[m_indexA].a = aA;
+	data.positions[m_indexB].c = cB;
+	data.positions[m_indexB].a = aB;
 
 	return b2Abs(C) < b2_linearSlop;
 }
@@ -53,14 +53,28 @@ b2FrictionJoint::b2FrictionJoint(const b2FrictionJointDef* def)
 	m_maxTorque = def->maxTorque;
 }
 
-void b2FrictionJoint::InitVelocityConstraints(const b2TimeStep& step)
+void b2FrictionJoint::InitVelocityConstraints(const b2SolverData& data)
 {
 	b2Body* bA = m_bodyA;
 	b2Body* bB = m_bodyB;
 
+	m_localCenterA = bA->GetLocalCenter();
+	m_localCenterB = bB->GetLocalCenter();
+	m_invMassA = bA->m_invMass;
+	m_invMassB = bB->m_invMass;
+	m_invIA = bA->m_invI;
+	m_invIB = bB->m_invI;
+
+	b2Vec2 vA = data.velocities[m_indexA].v;
+	float32 wA = data.velocities[m_indexA].w;
+	b2Vec2 vB = data.velocities[m_indexB].v;
+	float32 wB = data.velocities[m_indexB].w;
+
+	b2Mat22 RA(data.positions[m_indexA].a), RB(data.positions[m_indexB].a);
+
 	// Compute the effective mass matrix.
-	b2Vec2 rA = b2Mul(bA->GetTransform().R, m_localAnchorA - bA->GetLocalCenter());
-	b2Vec2 rB = b2Mul(bB->GetTransform().R, m_localAnchorB - bB->GetLocalCenter());
+	b2Vec2 rA = b2Mul(RA, m_localAnchorA - m_localCenterA);
+	b2Vec2 rB = b2Mul(RB, m_localAnchorB - m_localCenterB);
 
 	// J = [-I -r1_skew I r2_skew]
 	//     [ 0       -1 0       1]
@@ -71,8 +85,8 @@ void b2FrictionJoint::InitVelocityConstraints(const b2TimeStep& step)
 	//     [  -r1y*iA*r1x-r2y*iB*r2x, mA+r1x^2*iA+mB+r2x^2*iB,           r1x*iA+r2x*iB]
 	//     [          -r1y*iA-r2y*iB,           r1x*iA+r2x*iB,                   iA+iB]
 
-	float32 mA = bA->m_invMass, mB = bB->m_invMass;
-	float32 iA = bA->m_invI, iB = bB->m_invI;
+	float32 mA = m_invMassA, mB = m_invMassB;
+	float32 iA = m_invIA, iB = m_invIB;
 
 	b2Mat22 K1;
 	K1.col1.x = mA + mB;	K1.col2.x = 0.0f;
@@ -95,44 +109,46 @@ void b2FrictionJoint::InitVelocityConstraints(const b2TimeStep& step)
 		m_angularMass = 1.0f / m_angularMass;
 	}
 
-	if (step.warmStarting)
+	if (data.step.warmStarting)
 	{
 		// Scale impulses to support a variable time step.
-		m_linearImpulse *= step.dtRatio;
-		m_angularImpulse *= step.dtRatio;
+		m_linearImpulse *= data.step.dtRatio;
+		m_angularImpulse *= data.step.dtRatio;
 
 		b2Vec2 P(m_linearImpulse.x, m_linearImpulse.y);
 
-		bA->m_linearVelocity -= mA * P;
-		bA->m_angularVelocity -= iA * (b2Cross(rA, P) + m_angularImpulse);
+		vA -= mA * P;
+		wA -= iA * (b2Cross(rA, P) + m_angularImpulse);
 
-		bB->m_linearVelocity += mB * P;
-		bB->m_angularVelocity += iB * (b2Cross(rB, P) + m_angularImpulse);
+		vB += mB * P;
+		wB += iB * (b2Cross(rB, P) + m_angularImpulse);
 	}
 	else
 	{
 		m_linearImpulse.SetZero();
 		m_angularImpulse = 0.0f;
 	}
+
+	data.velocities[m_indexA].v = vA;
+	data.velocities[m_indexA].w = wA;
+	data.velocities[m_indexB].v = vB;
+	data.velocities[m_indexB].w = wB;
 }
 
-void b2FrictionJoint::SolveVelocityConstraints(const b2TimeStep& step)
+void b2FrictionJoint::SolveVelocityConstraints(const b2SolverData& data)
 {
-	B2_NOT_USED(step);
-
-	b2Body* bA = m_bodyA;
-	b2Body* bB = m_bodyB;
+	b2Vec2 vA = data.velocities[m_indexA].v;
+	float32 wA = data.velocities[m_indexA].w;
+	b2Vec2 vB = data.velocities[m_indexB].v;
+	float32 wB = data.velocities[m_indexB].w;
 
-	b2Vec2 vA = bA->m_linearVelocity;
-	float32 wA = bA->m_angularVelocity;
-	b2Vec2 vB = bB->m_linearVelocity;
-	float32 wB = bB->m_angularVelocity;
+	float32 mA = m_invMassA, mB = m_invMassB;
+	float32 iA = m_invIA, iB = m_invIB;
 
-	float32 mA = bA->m_invMass, mB = bB->m_invMass;
-	float32 iA = bA->m_invI, iB = bB->m_invI;
+	b2Mat22 RA(data.positions[m_indexA].a), RB(data.positions[m_indexB].a);
 
-	b2Vec2 rA = b2Mul(bA->GetTransform().R, m_localAnchorA - bA->GetLocalCenter());
-	b2Vec2 rB = b2Mul(bB->GetTransform().R, m_localAnchorB - bB->GetLocalCenter());
+	b2Vec2 rA = b2Mul(RA, m_localAnchorA - m_localCenterA);
+	b2Vec2 rB = b2Mul(RB, m_localAnchorB - m_localCenterB);
 
 	// Solve angular friction
 	{
@@ -140,7 +156,7 @@ void b2FrictionJoint::SolveVelocityConstraints(const b2TimeStep& step)
 		float32 impulse = -m_angularMass * Cdot;
 
 		float32 oldImpulse = m_angularImpulse;
-		float32 maxImpulse = step.dt * m_maxTorque;
+		float32 maxImpulse = data.step.dt * m_maxTorque;
 		m_angularImpulse = b2Clamp(m_angularImpulse + impulse, -maxImpulse, maxImpulse);
 		impulse = m_angularImpulse - oldImpulse;
 
@@ -156,7 +172,7 @@ void b2FrictionJoint::SolveVelocityConstraints(const b2TimeStep& step)
 		b2Vec2 oldImpulse = m_linearImpulse;
 		m_linearImpulse += impulse;
 
-		float32 maxImpulse = step.dt * m_maxForce;
+		float32 maxImpulse = data.step.dt * m_maxForce;
 
 		if (m_linearImpulse.LengthSquared() > maxImpulse * maxImpulse)
 		{
@@ -173,15 +189,15 @@ void b2FrictionJoint::SolveVelocityConstraints(const b2TimeStep& step)
 		wB += iB * b2Cross(rB, impulse);
 	}
 
-	bA->m_linearVelocity = vA;
-	bA->m_angularVelocity = wA;
-	bB->m_linearVelocity = vB;
-	bB->m_angularVelocity = wB;
+	data.velocities[m_indexA].v = vA;
+	data.velocities[m_indexA].w = wA;
+	data.velocities[m_indexB].v = vB;
+	data.velocities[m_indexB].w = wB;
 }
 
-bool b2FrictionJoint::SolvePositionConstraints(float32 baumgarte)
+bool b2FrictionJoint::SolvePositionConstraints(const b2SolverData& data)
 {
-	B2_NOT_USED(baumgarte);
+	B2_NOT_USED(data);
 
 	return true;
 }
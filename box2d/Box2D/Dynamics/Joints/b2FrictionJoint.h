@@ -79,9 +79,9 @@ protected:
 
 	b2FrictionJoint(const b2FrictionJointDef* def);
 
-	void InitVelocityConstraints(const b2TimeStep& step);
-	void SolveVelocityConstraints(const b2TimeStep& step);
-	bool SolvePositionConstraints(float32 baumgarte);
+	void InitVelocityConstraints(const b2SolverData& data);
+	void SolveVelocityConstraints(const b2SolverData& data);
+	bool SolvePositionConstraints(const b2SolverData& data);
 
 	b2Vec2 m_localAnchorA;
 	b2Vec2 m_localAnchorB;
@@ -101,121 +101,158 @@ b2GearJoint::b2GearJoint(const b2GearJointDef* def)
 	m_impulse = 0.0f;
 }
 
-void b2GearJoint::InitVelocityConstraints(const b2TimeStep& step)
+void b2GearJoint::InitVelocityConstraints(const b2SolverData& data)
 {
 	b2Body* g1 = m_ground1;
 	b2Body* g2 = m_ground2;
 	b2Body* b1 = m_bodyA;
 	b2Body* b2 = m_bodyB;
 
+	m_localCenterA = b1->GetLocalCenter();
+	m_localCenterB = b2->GetLocalCenter();
+	m_invMassA = b1->m_invMass;
+	m_invMassB = b2->m_invMass;
+	m_invIA = b1->m_invI;
+	m_invIB = b2->m_invI;
+
+	b2Vec2 vA = data.velocities[m_indexA].v;
+	float32 wA = data.velocities[m_indexA].w;
+	b2Vec2 vB = data.velocities[m_indexB].v;
+	float32 wB = data.velocities[m_indexB].w;
+
 	float32 K = 0.0f;
 	m_J.SetZero();
 
 	if (m_revolute1)
 	{
 		m_J.angularA = -1.0f;
-		K += b1->m_invI;
+		K += m_invIA;
 	}
 	else
 	{
+		b2Mat22 R1(data.positions[m_indexA].a);
 		b2Vec2 ug = b2Mul(g1->GetTransform().R, m_prismatic1->m_localXAxis1);
-		b2Vec2 r = b2Mul(b1->GetTransform().R, m_localAnchor1 - b1->GetLocalCenter());
+		b2Vec2 r = b2Mul(R1, m_localAnchor1 - m_localCenterA);
 		float32 crug = b2Cross(r, ug);
 		m_J.linearA = -ug;
 		m_J.angularA = -crug;
-		K += b1->m_invMass + b1->m_invI * crug * crug;
+		K += m_invMassA + m_invIA * crug * crug;
 	}
 
 	if (m_revolute2)
 	{
 		m_J.angularB = -m_ratio;
-		K += m_ratio * m_ratio * b2->m_invI;
+		K += m_ratio * m_ratio * m_invIB;
 	}
 	else
 	{
+		b2Mat22 R2(data.positions[m_indexB].a);
 		b2Vec2 ug = b2Mul(g2->GetTransform().R, m_prismatic2->m_localXAxis1);
-		b2Vec2 r = b2Mul(b2->GetTransform().R, m_localAnchor2 - b2->GetLocalCenter());
+		b2Vec2 r = b2Mul(R2, m_localAnchor2 - m_localCenterB);
 		float32 crug = b2Cross(r, ug);
 		m_J.linearB = -m_ratio * ug;
 		m_J.angularB = -m_ratio * crug;
-		K += m_ratio * m_ratio * (b2->m_invMass + b2->m_invI * crug * crug);
+		K += m_ratio * m_ratio * (m_invMassB + m_invIB * crug * crug);
 	}
 
 	// Compute effective mass.
 	m_mass = K > 0.0f ? 1.0f / K : 0.0f;
 
-	if (step.warmStarting)
+	if (data.step.warmStarting)
 	{
 		// Warm starting.
-		b1->m_linearVelocity += b1->m_invMass * m_impulse * m_J.linearA;
-		b1->m_angularVelocity += b1->m_invI * m_impulse * m_J.angularA;
-		b2->m_linearVelocity += b2->m_invMass * m_impulse * m_J.linearB;
-		b2->m_angularVelocity += b2->m_invI * m_impulse * m_J.angularB;
+		vA += m_invMassA * m_impulse * m_J.linearA;
+		wA += m_invIA * m_impulse * m_J.angularA;
+		vB += m_invMassB * m_impulse * m_J.linearB;
+		wB += m_invIB * m_impulse * m_J.angularB;
 	}
 	else
 	{
 		m_impulse = 0.0f;
 	}
+
+	data.velocities[m_indexA].v = vA;
+	data.velocities[m_indexA].w = wA;
+	data.velocities[m_indexB].v = vB;
+	data.velocities[m_indexB].w = wB;
 }
 
-void b2GearJoint::SolveVelocityConstraints(const b2TimeStep& step)
+void b2GearJoint::SolveVelocityConstraints(const b2SolverData& data)
 {
-	B2_NOT_USED(step);
-
-	b2Body* b1 = m_bodyA;
-	b2Body* b2 = m_bodyB;
+	b2Vec2 vA = data.velocities[m_indexA].v;
+	float32 wA = data.velocities[m_indexA].w;
+	b2Vec2 vB = data.velocities[m_indexB].v;
+	float32 wB = data.velocities[m_indexB].w;
 
-	float32 Cdot = m_J.Compute(	b1->m_linearVelocity, b1->m_angularVelocity,
-								b2->m_linearVelocity, b2->m_angularVelocity);
+	float32 Cdot = m_J.Compute(vA, wA, vB, wB);
 
 	float32 impulse = m_mass * (-Cdot);
 	m_impulse += impulse;
 
-	b1->m_linearVelocity += b1->m_invMass * impulse * m_J.linearA;
-	b1->m_angularVelocity += b1->m_invI * impulse * m_J.angularA;
-	b2->m_linearVelocity += b2->m_invMass * impulse * m_J.linearB;
-	b2->m_angularVelocity += b2->m_invI * impulse * m_J.angularB;
+	vA += m_invMassA * impulse * m_J.linearA;
+	wA += m_invIA * impulse * m_J.angularA;
+	vB += m_invMassB * impulse * m_J.linearB;
+	wB += m_invIB * impulse * m_J.angularB;
+
+	data.velocities[m_indexA].v = vA;
+	data.velocities[m_indexA].w = wA;
+	data.velocities[m_indexB].v = vB;
+	data.velocities[m_indexB].w = wB;
 }
 
-bool b2GearJoint::SolvePositionConstraints(float32 baumgarte)
+bool b2GearJoint::SolvePositionConstraints(const b2SolverData& data)
 {
-	B2_NOT_USED(baumgarte);
-	
 	float32 linearError = 0.0f;
 
-	b2Body* b1 = m_bodyA;
-	b2Body* b2 = m_bodyB;
+	b2Vec2 cA = data.positions[m_indexA].c;
+	float32 aA = data.positions[m_indexA].a;
+	b2Vec2 cB = data.positions[m_indexB].c;
+	float32 aB = data.positions[m_indexB].a;
 
+	// Same as GetJointAngle() and GetJointTranslation() of the two joints.
+	// The grounds are static, so they can be used directly.
 	float32 coordinate1, coordinate2;
 	if (m_revolute1)
 	{
-		coordinate1 = m_revolute1->GetJointAngle();
+		coordinate1 = aA - m_ground1->GetAngle() - m_revolute1->m_referenceAngle;
 	}
 	else
 	{
-		coordinate1 = m_prismatic1->GetJointTranslation();
+		b2Transform xf1;
+		xf1.R.Set(aA);
+		xf1.position = cA - b2Mul(xf1.R, m_localCenterA);
+
+		b2Vec2 d = b2Mul(xf1, m_localAnchor1) - m_ground1->GetWorldPoint(m_groundAnchor1);
+		coordinate1 = b2Dot(d, m_ground1->GetWorldVector(m_prismatic1->m_localXAxis1));
 	}
 
 	if (m_revolute2)
 	{
-		coordinate2 = m_revolute2->GetJointAngle();
+		coordinate2 = aB - m_ground2->GetAngle() - m_revolute2->m_referenceAngle;
 	}
 	else
 	{
-		coordinate2 = m_prismatic2->GetJointTranslation();
+		b2Transform xf2;
+		xf2.R.Set(aB);
+		xf2.position = cB - b2Mul(xf2.R, m_localCenterB);
+
+		b2Vec2 d = b2Mul(xf2, m_localAnchor2) - m_ground2->GetWorldPoint(m_groundAnchor2);
+		coordinate2 = b2Dot(d, m_ground2->GetWorldVector(m_prismatic2->m_localXAxis1));
 	}
 
 	float32 C = m_constant - (coordinate1 + m_ratio * coordinate2);
 
 	float32 impulse = m_mass * (-C);
 
-	b1->m_sweep.c += b1->m_invMass * impulse * m_J.linearA;
-	b1->m_sweep.a += b1->m_invI * impulse * m_J.angularA;
-	b2->m_sweep.c += b2->m_invMass * impulse * m_J.linearB;
-	b2->m_sweep.a += b2->m_invI * impulse * m_J.angularB;
+	cA += m_invMassA * impulse * m_J.linearA;
+	aA += m_invIA * impulse * m_J.angularA;
+	cB += m_invMassB * impulse * m_J.linearB;
+	aB += m_invIB * impulse * m_J.angularB;
 
-	b1->SynchronizeTransform();
-	b2->SynchronizeTransform();
+	data.positions[m_indexA].c = cA;
+	data.positions[m_indexA].a = aA;
+	data.positions[m_indexB].c = cB;
+	data.positions[m_indexB].a = aB;
 
 	// TODO_ERIN not implemented
 	return linearError < b2_linearSlop;
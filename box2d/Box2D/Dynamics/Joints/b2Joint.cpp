@@ -167,6 +167,8 @@ b2Joint::b2Joint(const b2JointDef* def)
 	m_bodyB = def->bodyB;
 	m_collideConnected = def->collideConnected;
 	m_islandFlag = false;
+	m_islandPrev = NULL;
+	m_islandNext = NULL;
 	m_userData = def->userData;
 
 	m_edgeA.joint = NULL;
@@ -23,7 +23,7 @@
 
 class b2Body;
 class b2Joint;
-struct b2TimeStep;
+struct b2SolverData;
 class b2BlockAllocator;
 
 enum b2JointType
@@ -140,10 +140,15 @@ public:
 	/// Short-cut function to determine if either body is inactive.
 	bool IsActive() const;
 
+	/// Shift the points the joint keeps in world coordinates. This is
+	/// called by b2World::ShiftOrigin.
+	virtual void ShiftOrigin(const b2Vec2& newOrigin) { B2_NOT_USED(newOrigin); }
+
 protected:
 	friend class b2World;
 	friend class b2Body;
 	friend class b2Island;
+	friend struct b2PersistentIsland;
 
 	static b2Joint* Create(const b2JointDef* def, b2BlockAllocator* allocator);
 	static void Destroy(b2Joint* joint, b2BlockAllocator* allocator);
@@ -151,11 +156,11 @@ protected:
 	b2Joint(const b2JointDef* def);
 	virtual ~b2Joint() {}
 
-	virtual void InitVelocityConstraints(const b2TimeStep& step) = 0;
-	virtual void SolveVelocityConstraints(const b2TimeStep& step) = 0;
+	virtual void InitVelocityConstraints(const b2SolverData& data) = 0;
+	virtual void SolveVelocityConstraints(const b2SolverData& data) = 0;
 
 	// This returns true if the position errors are within tolerance.
-	virtual bool SolvePositionConstraints(float32 baumgarte) = 0;
+	virtual bool SolvePositionConstraints(const b2SolverData& data) = 0;
 
 	b2JointType m_type;
 	b2Joint* m_prev;
@@ -165,12 +170,18 @@ protected:
 	b2Body* m_bodyA;
 	b2Body* m_bodyB;
 
+	// Set while the joint is linked into the island of its bodies.
 	bool m_islandFlag;
 	bool m_collideConnected;
 
+	// Persistent island list pointers.
+	b2Joint* m_islandPrev;
+	b2Joint* m_islandNext;
+
 	void* m_userData;
 
 	// Cache here per time step to reduce cache misses.
+	int32 m_indexA, m_indexB;
 	b2Vec2 m_localCenterA, m_localCenterB;
 	float32 m_invMassA, m_invIA;
 	float32 m_invMassB, m_invIB;
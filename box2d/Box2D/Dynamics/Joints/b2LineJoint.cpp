@@ -113,7 +113,7 @@ b2LineJoint::b2LineJoint(const b2LineJointDef* def)
 	m_perp.SetZero();
 }
 
-void b2LineJoint::InitVelocityConstraints(const b2TimeStep& step)
+void b2LineJoint::InitVelocityConstraints(const b2SolverData& data)
 {
 	b2Body* b1 = m_bodyA;
 	b2Body* b2 = m_bodyB;
@@ -121,13 +121,20 @@ void b2LineJoint::InitVelocityConstraints(const b2TimeStep& step)
 	m_localCenterA = b1->GetLocalCenter();
 	m_localCenterB = b2->GetLocalCenter();
 
-	b2Transform xf1 = b1->GetTransform();
-	b2Transform xf2 = b2->GetTransform();
+	b2Vec2 c1 = data.positions[m_indexA].c;
+	b2Vec2 v1 = data.velocities[m_indexA].v;
+	float32 w1 = data.velocities[m_indexA].w;
+
+	b2Vec2 c2 = data.positions[m_indexB].c;
+	b2Vec2 v2 = data.velocities[m_indexB].v;
+	float32 w2 = data.velocities[m_indexB].w;
+
+	b2Mat22 R1(data.positions[m_indexA].a), R2(data.positions[m_indexB].a);
 
 	// Compute the effective masses.
-	b2Vec2 r1 = b2Mul(xf1.R, m_localAnchor1 - m_localCenterA);
-	b2Vec2 r2 = b2Mul(xf2.R, m_localAnchor2 - m_localCenterB);
-	b2Vec2 d = b2->m_sweep.c + r2 - b1->m_sweep.c - r1;
+	b2Vec2 r1 = b2Mul(R1, m_localAnchor1 - m_localCenterA);
+	b2Vec2 r2 = b2Mul(R2, m_localAnchor2 - m_localCenterB);
+	b2Vec2 d = c2 + r2 - c1 - r1;
 
 	m_invMassA = b1->m_invMass;
 	m_invIA = b1->m_invI;
@@ -136,7 +143,7 @@ void b2LineJoint::InitVelocityConstraints(const b2TimeStep& step)
 
 	// Compute motor Jacobian and effective mass.
 	{
-		m_axis = b2Mul(xf1.R, m_localXAxis1);
+		m_axis = b2Mul(R1, m_localXAxis1);
 		m_a1 = b2Cross(d + r1, m_axis);
 		m_a2 = b2Cross(r2, m_axis);
 
@@ -153,7 +160,7 @@ void b2LineJoint::InitVelocityConstraints(const b2TimeStep& step)
 
 	// Prismatic constraint.
 	{
-		m_perp = b2Mul(xf1.R, m_localYAxis1);
+		m_perp = b2Mul(R1, m_localYAxis1);
 
 		m_s1 = b2Cross(d + r1, m_perp);
 		m_s2 = b2Cross(r2, m_perp);
@@ -209,38 +216,40 @@ void b2LineJoint::InitVelocityConstraints(const b2TimeStep& step)
 		m_motorImpulse = 0.0f;
 	}
 
-	if (step.warmStarting)
+	if (data.step.warmStarting)
 	{
 		// Account for variable time step.
-		m_impulse *= step.dtRatio;
-		m_motorImpulse *= step.dtRatio;
+		m_impulse *= data.step.dtRatio;
+		m_motorImpulse *= data.step.dtRatio;
 
 		b2Vec2 P = m_impulse.x * m_perp + (m_motorImpulse + m_impulse.y) * m_axis;
 		float32 L1 = m_impulse.x * m_s1 + (m_motorImpulse + m_impulse.y) * m_a1;
 		float32 L2 = m_impulse.x * m_s2 + (m_motorImpulse + m_impulse.y) * m_a2;
 
-		b1->m_linearVelocity -= m_invMassA * P;
-		b1->m_angularVelocity -= m_invIA * L1;
+		v1 -= m_invMassA * P;
+		w1 -= m_invIA * L1;
 
-		b2->m_linearVelocity += m_invMassB * P;
-		b2->m_angularVelocity += m_invIB * L2;
+		v2 += m_invMassB * P;
+		w2 += m_invIB * L2;
 	}
 	else
 	{
 		m_impulse.SetZero();
 		m_motorImpulse = 0.0f;
 	}
+
+	data.velocities[m_indexA].v = v1;
+	data.velocities[m_indexA].w = w1;
+	data.velocities[m_indexB].v = v2;
+	data.velocities[m_indexB].w = w2;
 }
 
-void b2LineJoint::SolveVelocityConstraints(const b2TimeStep& step)
+void b2LineJoint::SolveVelocityConstraints(const b2SolverData& data)
 {
-	b2Body* b1 = m_bodyA;
-	b2Body* b2 = m_bodyB;
-
-	b2Vec2 v1 = b1->m_linearVelocity;
-	float32 w1 = b1->m_angularVelocity;
-	b2Vec2 v2 = b2->m_linearVelocity;
-	float32 w2 = b2->m_angularVelocity;
+	b2Vec2 v1 = data.velocities[m_indexA].v;
+	float32 w1 = data.velocities[m_indexA].w;
+	b2Vec2 v2 = data.velocities[m_indexB].v;
+	float32 w2 = data.velocities[m_indexB].w;
 
 	// Solve linear motor constraint.
 	if (m_enableMotor && m_limitState != e_equalLimits)
@@ -248,7 +257,7 @@ void b2LineJoint::SolveVelocityConstraints(const b2TimeStep& step)
 		float32 Cdot = b2Dot(m_axis, v2 - v1) + m_a2 * w2 - m_a1 * w1;
 		float32 impulse = m_motorMass * (m_motorSpeed - Cdot);
 		float32 oldImpulse = m_motorImpulse;
-		float32 maxImpulse = step.dt * m_maxMotorForce;
+		float32 maxImpulse = data.step.dt * m_maxMotorForce;
 		m_motorImpulse = b2Clamp(m_motorImpulse + impulse, -maxImpulse, maxImpulse);
 		impulse = m_motorImpulse - oldImpulse;
 
@@ -335,24 +344,19 @@ void b2LineJoint::SolveVelocityConstraints(const b2TimeStep& step)
 		w2 += m_invIB * L2;
 	}
 
-	b1->m_linearVelocity = v1;
-	b1->m_angularVelocity = w1;
-	b2->m_linearVelocity = v2;
-	b2->m_angularVelocity = w2;
+	data.velocities[m_indexA].v = v1;
+	data.velocities[m_indexA].w = w1;
+	data.velocities[m_indexB].v = v2;
+	data.velocities[m_indexB].w = w2;
 }
 
-bool b2LineJoint::SolvePositionConstraints(float32 baumgarte)
+bool b2LineJoint::SolvePositionConstraints(const b2SolverData& data)
 {
-	B2_NOT_USED(baumgarte);
-
-	b2Body* b1 = m_bodyA;
-	b2Body* b2 = m_bodyB;
-
-	b2Vec2 c1 = b1->m_sweep.c;
-	float32 a1 = b1->m_sweep.a;
+	b2Vec2 c1 = data.positions[m_indexA].c;
+	float32 a1 = data.positions[m_indexA].a;
 
-	b2Vec2 c2 = b2->m_sweep.c;
-	float32 a2 = b2->m_sweep.a;
+	b2Vec2 c2 = data.positions[m_indexB].c;
+	float32 a2 = data.positions[m_indexB].a;
 
 	// Solve linear limit constraint.
 	float32 linearError = 0.0f, angularError = 0.0f;
@@ -456,13 +460,10 @@ bool b2LineJoint::SolvePositionConstraints(float32 baumgarte)
 	c2 += m_invMassB * P;
 	a2 += m_invIB * L2;
 
-	// TODO_ERIN remove need for this.
-	b1->m_sweep.c = c1;
-	b1->m_sweep.a = a1;
-	b2->m_sweep.c = c2;
-	b2->m_sweep.a = a2;
-	b1->SynchronizeTransform();
-	b2->SynchronizeTransform();
+	data.positions[m_indexA].c = c1;
+	data.positions[m_indexA].a = a1;
+	data.positions[m_indexB].c = c2;
+	data.positions[m_indexB].a = a2;
 
 	return linearError <= b2_linearSlop && angularError <= b2_angularSlop;
 }
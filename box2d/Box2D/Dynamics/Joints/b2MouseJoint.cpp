@@ -93,10 +93,24 @@ float32 b2MouseJoint::GetDampingRatio() const
 	return m_dampingRatio;
 }
 
-void b2MouseJoint::InitVelocityConstraints(const b2TimeStep& step)
+void b2MouseJoint::ShiftOrigin(const b2Vec2& newOrigin)
+{
+	m_target -= newOrigin;
+}
+
+void b2MouseJoint::InitVelocityConstraints(const b2SolverData& data)
 {
 	b2Body* b = m_bodyB;
 
+	m_localCenterB = b->GetLocalCenter();
+	m_invMassB = b->m_invMass;
+	m_invIB = b->m_invI;
+
+	b2Vec2 c = data.positions[m_indexB].c;
+	float32 a = data.positions[m_indexB].a;
+	b2Vec2 v = data.velocities[m_indexB].v;
+	float32 w = data.velocities[m_indexB].w;
+
 	float32 mass = b->GetMass();
 
 	// Frequency
@@ -111,22 +125,23 @@ void b2MouseJoint::InitVelocityConstraints(const b2TimeStep& step)
 	// magic formulas
 	// gamma has units of inverse mass.
 	// beta has units of inverse time.
-	b2Assert(d + step.dt * k > b2_epsilon);
-	m_gamma = step.dt * (d + step.dt * k);
+	b2Assert(d + data.step.dt * k > b2_epsilon);
+	m_gamma = data.step.dt * (d + data.step.dt * k);
 	if (m_gamma != 0.0f)
 	{
 		m_gamma = 1.0f / m_gamma;
 	}
-	m_beta = step.dt * k * m_gamma;
+	m_beta = data.step.dt * k * m_gamma;
 
 	// Compute the effective mass matrix.
-	b2Vec2 r = b2Mul(b->GetTransform().R, m_localAnchor - b->GetLocalCenter());
+	b2Mat22 R(a);
+	b2Vec2 r = b2Mul(R, m_localAnchor - m_localCenterB);
 
 	// K    = [(1/m1 + 1/m2) * eye(2) - skew(r1) * invI1 * skew(r1) - skew(r2) * invI2 * skew(r2)]
 	//      = [1/m1+1/m2     0    ] + invI1 * [r1.y*r1.y -r1.x*r1.y] + invI2 * [r1.y*r1.y -r1.x*r1.y]
 	//        [    0     1/m1+1/m2]           [-r1.x*r1.y r1.x*r1.x]           [-r1.x*r1.y r1.x*r1.x]
-	float32 invMass = b->m_invMass;
-	float32 invI = b->m_invI;
+	float32 invMass = m_invMassB;
+	float32 invI = m_invIB;
 
 	b2Mat22 K1;
 	K1.col1.x = invMass;	K1.col2.x = 0.0f;
@@ -142,38 +157,46 @@ void b2MouseJoint::InitVelocityConstraints(const b2TimeStep& step)
 
 	m_mass = K.GetInverse();
 
-	m_C = b->m_sweep.c + r - m_target;
+	m_C = c + r - m_target;
 
 	// Cheat with some damping
-	b->m_angularVelocity *= 0.98f;
+	w *= 0.98f;
 
 	// Warm starting.
-	m_impulse *= step.dtRatio;
-	b->m_linearVelocity += invMass * m_impulse;
-	b->m_angularVelocity += invI * b2Cross(r, m_impulse);
+	m_impulse *= data.step.dtRatio;
+	v += invMass * m_impulse;
+	w += invI * b2Cross(r, m_impulse);
+
+	data.velocities[m_indexB].v = v;
+	data.velocities[m_indexB].w = w;
 }
 
-void b2MouseJoint::SolveVelocityConstraints(const b2TimeStep& step)
+void b2MouseJoint::SolveVelocityConstraints(const b2SolverData& data)
 {
-	b2Body* b = m_bodyB;
+	b2Vec2 v = data.velocities[m_indexB].v;
+	float32 w = data.velocities[m_indexB].w;
 
-	b2Vec2 r = b2Mul(b->GetTransform().R, m_localAnchor - b->GetLocalCenter());
+	b2Mat22 R(data.positions[m_indexB].a);
+	b2Vec2 r = b2Mul(R, m_localAnchor - m_localCenterB);
 
 	// Cdot = v + cross(w, r)
-	b2Vec2 Cdot = b->m_linearVelocity + b2Cross(b->m_angularVelocity, r);
+	b2Vec2 Cdot = v + b2Cross(w, r);
 	b2Vec2 impulse = b2Mul(m_mass, -(Cdot + m_beta * m_C + m_gamma * m_impulse));
 
 	b2Vec2 oldImpulse = m_impulse;
 	m_impulse += impulse;
-	float32 maxImpulse = step.dt * m_maxForce;
+	float32 maxImpulse = data.step.dt * m_maxForce;
 	if (m_impulse.LengthSquared() > maxImpulse * maxImpulse)
 	{
 		m_impulse *= maxImpulse / m_impulse.Length();
 	}
 	impulse = m_impulse - oldImpulse;
 
-	b->m_linearVelocity += b->m_invMass * impulse;
-	b->m_angularVelocity += b->m_invI * b2Cross(r, impulse);
+	v += m_invMassB * impulse;
+	w += m_invIB * b2Cross(r, impulse);
+
+	data.velocities[m_indexB].v = v;
+	data.velocities[m_indexB].w = w;
 }
 
 b2Vec2 b2MouseJoint::GetAnchorA() const
@@ -82,16 +82,33 @@ b2PulleyJoint::b2PulleyJoint(const b2PulleyJointDef* def)
 	m_limitImpulse2 = 0.0f;
 }
 
-void b2PulleyJoint::InitVelocityConstraints(const b2TimeStep& step)
+void b2PulleyJoint::InitVelocityConstraints(const b2SolverData& data)
 {
 	b2Body* b1 = m_bodyA;
 	b2Body* b2 = m_bodyB;
 
-	b2Vec2 r1 = b2Mul(b1->GetTransform().R, m_localAnchor1 - b1->GetLocalCenter());
-	b2Vec2 r2 = b2Mul(b2->GetTransform().R, m_localAnchor2 - b2->GetLocalCenter());
+	m_localCenterA = b1->GetLocalCenter();
+	m_localCenterB = b2->GetLocalCenter();
+	m_invMassA = b1->m_invMass;
+	m_invMassB = b2->m_invMass;
+	m_invIA = b1->m_invI;
+	m_invIB = b2->m_invI;
 
-	b2Vec2 p1 = b1->m_sweep.c + r1;
-	b2Vec2 p2 = b2->m_sweep.c + r2;
+	b2Vec2 cA = data.positions[m_indexA].c;
+	b2Vec2 vA = data.velocities[m_indexA].v;
+	float32 wA = data.velocities[m_indexA].w;
+
+	b2Vec2 cB = data.positions[m_indexB].c;
+	b2Vec2 vB = data.velocities[m_indexB].v;
+	float32 wB = data.velocities[m_indexB].w;
+
+	b2Mat22 R1(data.positions[m_indexA].a), R2(data.positions[m_indexB].a);
+
+	b2Vec2 r1 = b2Mul(R1, m_localAnchor1 - m_localCenterA);
+	b2Vec2 r2 = b2Mul(R2, m_localAnchor2 - m_localCenterB);
+
+	b2Vec2 p1 = cA + r1;
+	b2Vec2 p2 = cB + r2;
 
 	b2Vec2 s1 = m_groundAnchor1;
 	b2Vec2 s2 = m_groundAnchor2;
@@ -156,8 +173,8 @@ void b2PulleyJoint::InitVelocityConstraints(const b2TimeStep& step)
 	float32 cr1u1 = b2Cross(r1, m_u1);
 	float32 cr2u2 = b2Cross(r2, m_u2);
 
-	m_limitMass1 = b1->m_invMass + b1->m_invI * cr1u1 * cr1u1;
-	m_limitMass2 = b2->m_invMass + b2->m_invI * cr2u2 * cr2u2;
+	m_limitMass1 = m_invMassA + m_invIA * cr1u1 * cr1u1;
+	m_limitMass2 = m_invMassB + m_invIB * cr2u2 * cr2u2;
 	m_pulleyMass = m_limitMass1 + m_ratio * m_ratio * m_limitMass2;
 	b2Assert(m_limitMass1 > b2_epsilon);
 	b2Assert(m_limitMass2 > b2_epsilon);
@@ -166,20 +183,20 @@ void b2PulleyJoint::InitVelocityConstraints(const b2TimeStep& step)
 	m_limitMass2 = 1.0f / m_limitMass2;
 	m_pulleyMass = 1.0f / m_pulleyMass;
 
-	if (step.warmStarting)
+	if (data.step.warmStarting)
 	{
 		// Scale impulses to support variable time steps.
-		m_impulse *= step.dtRatio;
-		m_limitImpulse1 *= step.dtRatio;
-		m_limitImpulse2 *= step.dtRatio;
+		m_impulse *= data.step.dtRatio;
+		m_limitImpulse1 *= data.step.dtRatio;
+		m_limitImpulse2 *= data.step.dtRatio;
 
 		// Warm starting.
 		b2Vec2 P1 = -(m_impulse + m_limitImpulse1) * m_u1;
 		b2Vec2 P2 = (-m_ratio * m_impulse - m_limitImpulse2) * m_u2;
-		b1->m_linearVelocity += b1->m_invMass * P1;
-		b1->m_angularVelocity += b1->m_invI * b2Cross(r1, P1);
-		b2->m_linearVelocity += b2->m_invMass * P2;
-		b2->m_angularVelocity += b2->m_invI * b2Cross(r2, P2);
+		vA += m_invMassA * P1;
+		wA += m_invIA * b2Cross(r1, P1);
+		vB += m_invMassB * P2;
+		wB += m_invIB * b2Cross(r2, P2);
 	}
 	else
 	{
@@ -187,22 +204,29 @@ void b2PulleyJoint::InitVelocityConstraints(const b2TimeStep& step)
 		m_limitImpulse1 = 0.0f;
 		m_limitImpulse2 = 0.0f;
 	}
+
+	data.velocities[m_indexA].v = vA;
+	data.velocities[m_indexA].w = wA;
+	data.velocities[m_indexB].v = vB;
+	data.velocities[m_indexB].w = wB;
 }
 
-void b2PulleyJoint::SolveVelocityConstraints(const b2TimeStep& step)
+void b2PulleyJoint::SolveVelocityConstraints(const b2SolverData& data)
 {
-	B2_NOT_USED(step);
+	b2Vec2 vA = data.velocities[m_indexA].v;
+	float32 wA = data.velocities[m_indexA].w;
+	b2Vec2 vB = data.velocities[m_indexB].v;
+	float32 wB = data.velocities[m_indexB].w;
 
-	b2Body* b1 = m_bodyA;
-	b2Body* b2 = m_bodyB;
+	b2Mat22 R1(data.positions[m_indexA].a), R2(data.positions[m_indexB].a);
 
-	b2Vec2 r1 = b2Mul(b1->GetTransform().R, m_localAnchor1 - b1->GetLocalCenter());
-	b2Vec2 r2 = b2Mul(b2->GetTransform().R, m_localAnchor2 - b2->GetLocalCenter());
+	b2Vec2 r1 = b2Mul(R1, m_localAnchor1 - m_localCenterA);
+	b2Vec2 r2 = b2Mul(R2, m_localAnchor2 - m_localCenterB);
 
 	if (m_state == e_atUpperLimit)
 	{
-		b2Vec2 v1 = b1->m_linearVelocity + b2Cross(b1->m_angularVelocity, r1);
-		b2Vec2 v2 = b2->m_linearVelocity + b2Cross(b2->m_angularVelocity, r2);
+		b2Vec2 v1 = vA + b2Cross(wA, r1);
+		b2Vec2 v2 = vB + b2Cross(wB, r2);
 
 		float32 Cdot = -b2Dot(m_u1, v1) - m_ratio * b2Dot(m_u2, v2);
 		float32 impulse = m_pulleyMass * (-Cdot);
@@ -212,15 +236,15 @@ void b2PulleyJoint::SolveVelocityConstraints(const b2TimeStep& step)
 
 		b2Vec2 P1 = -impulse * m_u1;
 		b2Vec2 P2 = -m_ratio * impulse * m_u2;
-		b1->m_linearVelocity += b1->m_invMass * P1;
-		b1->m_angularVelocity += b1->m_invI * b2Cross(r1, P1);
-		b2->m_linearVelocity += b2->m_invMass * P2;
-		b2->m_angularVelocity += b2->m_invI * b2Cross(r2, P2);
+		vA += m_invMassA * P1;
+		wA += m_invIA * b2Cross(r1, P1);
+		vB += m_invMassB * P2;
+		wB += m_invIB * b2Cross(r2, P2);
 	}
 
 	if (m_limitState1 == e_atUpperLimit)
 	{
-		b2Vec2 v1 = b1->m_linearVelocity + b2Cross(b1->m_angularVelocity, r1);
+		b2Vec2 v1 = vA + b2Cross(wA, r1);
 
 		float32 Cdot = -b2Dot(m_u1, v1);
 		float32 impulse = -m_limitMass1 * Cdot;
@@ -229,13 +253,13 @@ void b2PulleyJoint::SolveVelocityConstraints(const b2TimeStep& step)
 		impulse = m_limitImpulse1 - oldImpulse;
 
 		b2Vec2 P1 = -impulse * m_u1;
-		b1->m_linearVelocity += b1->m_invMass * P1;
-		b1->m_angularVelocity += b1->m_invI * b2Cross(r1, P1);
+		vA += m_invMassA * P1;
+		wA += m_invIA * b2Cross(r1, P1);
 	}
 
 	if (m_limitState2 == e_atUpperLimit)
 	{
-		b2Vec2 v2 = b2->m_linearVelocity + b2Cross(b2->m_angularVelocity, r2);
+		b2Vec2 v2 = vB + b2Cross(wB, r2);
 
 		float32 Cdot = -b2Dot(m_u2, v2);
 		float32 impulse = -m_limitMass2 * Cdot;
@@ -244,17 +268,22 @@ void b2PulleyJoint::SolveVelocityConstraints(const b2TimeStep& step)
 		impulse = m_limitImpulse2 - oldImpulse;
 
 		b2Vec2 P2 = -impulse * m_u2;
-		b2->m_linearVelocity += b2->m_invMass * P2;
-		b2->m_angularVelocity += b2->m_invI * b2Cross(r2, P2);
+		vB += m_invMassB * P2;
+		wB += m_invIB * b2Cross(r2, P2);
 	}
+
+	data.velocities[m_indexA].v = vA;
+	data.velocities[m_indexA].w = wA;
+	data.velocities[m_indexB].v = vB;
+	data.velocities[m_indexB].w = wB;
 }
 
-bool b2PulleyJoint::SolvePositionConstraints(float32 baumgarte)
+bool b2PulleyJoint::SolvePositionConstraints(const b2SolverData& data)
 {
-	B2_NOT_USED(baumgarte);
-
-	b2Body* b1 = m_bodyA;
-	b2Body* b2 = m_bodyB;
+	b2Vec2 cA = data.positions[m_indexA].c;
+	float32 aA = data.positions[m_indexA].a;
+	b2Vec2 cB = data.positions[m_indexB].c;
+	float32 aB = data.positions[m_indexB].a;
 
 	b2Vec2 s1 = m_groundAnchor1;
 	b2Vec2 s2 = m_groundAnchor2;
@@ -263,11 +292,13 @@ bool b2PulleyJoint::SolvePositionConstraints(float32 baumgarte)
 
 	if (m_state == e_atUpperLimit)
 	{
-		b2Vec2 r1 = b2Mul(b1->GetTransform().R, m_localAnchor1 - b1->GetLocalCenter());
-		b2Vec2 r2 = b2Mul(b2->GetTransform().R, m_localAnchor2 - b2->GetLocalCenter());
+		b2Mat22 R1(aA), R2(aB);
+
+		b2Vec2 r1 = b2Mul(R1, m_localAnchor1 - m_localCenterA);
+		b2Vec2 r2 = b2Mul(R2, m_localAnchor2 - m_localCenterB);
 
-		b2Vec2 p1 = b1->m_sweep.c + r1;
-		b2Vec2 p2 = b2->m_sweep.c + r2;
+		b2Vec2 p1 = cA + r1;
+		b2Vec2 p2 = cB + r2;
 
 		// Get the pulley axes.
 		m_u1 = p1 - s1;
@@ -303,19 +334,17 @@ bool b2PulleyJoint::SolvePositionConstraints(float32 baumgarte)
 		b2Vec2 P1 = -impulse * m_u1;
 		b2Vec2 P2 = -m_ratio * impulse * m_u2;
 
-		b1->m_sweep.c += b1->m_invMass * P1;
-		b1->m_sweep.a += b1->m_invI * b2Cross(r1, P1);
-		b2->m_sweep.c += b2->m_invMass * P2;
-		b2->m_sweep.a += b2->m_invI * b2Cross(r2, P2);
-
-		b1->SynchronizeTransform();
-		b2->SynchronizeTransform();
+		cA += m_invMassA * P1;
+		aA += m_invIA * b2Cross(r1, P1);
+		cB += m_invMassB * P2;
+		aB += m_invIB * b2Cross(r2, P2);
 	}
 
 	if (m_limitState1 == e_atUpperLimit)
 	{
-		b2Vec2 r1 = b2Mul(b1->GetTransform().R, m_localAnchor1 - b1->GetLocalCenter());
-		b2Vec2 p1 = b1->m_sweep.c + r1;
+		b2Mat22 R1(aA);
+		b2Vec2 r1 = b2Mul(R1, m_localAnchor1 - m_localCenterA);
+		b2Vec2 p1 = cA + r1;
 
 		m_u1 = p1 - s1;
 		float32 length1 = m_u1.Length();
@@ -335,16 +364,15 @@ bool b2PulleyJoint::SolvePositionConstraints(float32 baumgarte)
 		float32 impulse = -m_limitMass1 * C;
 
 		b2Vec2 P1 = -impulse * m_u1;
-		b1->m_sweep.c += b1->m_invMass * P1;
-		b1->m_sweep.a += b1->m_invI * b2Cross(r1, P1);
-
-		b1->SynchronizeTransform();
+		cA += m_invMassA * P1;
+		aA += m_invIA * b2Cross(r1, P1);
 	}
 
 	if (m_limitState2 == e_atUpperLimit)
 	{
-		b2Vec2 r2 = b2Mul(b2->GetTransform().R, m_localAnchor2 - b2->GetLocalCenter());
-		b2Vec2 p2 = b2->m_sweep.c + r2;
+		b2Mat22 R2(aB);
+		b2Vec2 r2 = b2Mul(R2, m_localAnchor2 - m_localCenterB);
+		b2Vec2 p2 = cB + r2;
 
 		m_u2 = p2 - s2;
 		float32 length2 = m_u2.Length();
@@ -364,12 +392,15 @@ bool b2PulleyJoint::SolvePositionConstraints(float32 baumgarte)
 		float32 impulse = -m_limitMass2 * C;
 
 		b2Vec2 P2 = -impulse * m_u2;
-		b2->m_sweep.c += b2->m_invMass * P2;
-		b2->m_sweep.a += b2->m_invI * b2Cross(r2, P2);
-
-		b2->SynchronizeTransform();
+		cB += m_invMassB * P2;
+		aB += m_invIB * b2Cross(r2, P2);
 	}
 
+	data.positions[m_indexA].c = cA;
+	data.positions[m_indexA].a = aA;
+	data.positions[m_indexB].c = cB;
+	data.positions[m_indexB].a = aB;
+
 	return linearError < b2_linearSlop;
 }
 
@@ -425,3 +456,9 @@ float32 b2PulleyJoint::GetRatio() const
 {
 	return m_ratio;
 }
+
+void b2PulleyJoint::ShiftOrigin(const b2Vec2& newOrigin)
+{
+	m_groundAnchor1 -= newOrigin;
+	m_groundAnchor2 -= newOrigin;
+}
@@ -107,14 +107,17 @@ public:
 	/// Get the pulley ratio.
 	float32 GetRatio() const;
 
+	/// Implements b2Joint.
+	void ShiftOrigin(const b2Vec2& newOrigin);
+
 protected:
 
 	friend class b2Joint;
 	b2PulleyJoint(const b2PulleyJointDef* data);
 
-	void InitVelocityConstraints(const b2TimeStep& step);
-	void SolveVelocityConstraints(const b2TimeStep& step);
-	bool SolvePositionConstraints(float32 baumgarte);
+	void InitVelocityConstraints(const b2SolverData& data);
+	void SolveVelocityConstraints(const b2SolverData& data);
+	bool SolvePositionConstraints(const b2SolverData& data);
 
 	b2Vec2 m_groundAnchor1;
 	b2Vec2 m_groundAnchor2;
@@ -61,21 +61,38 @@ b2RevoluteJoint::b2RevoluteJoint(const b2RevoluteJointDef* def)
 	m_limitState = e_inactiveLimit;
 }
 
-void b2RevoluteJoint::InitVelocityConstraints(const b2TimeStep& step)
+void b2RevoluteJoint::InitVelocityConstraints(const b2SolverData& data)
 {
 	b2Body* b1 = m_bodyA;
 	b2Body* b2 = m_bodyB;
 
+	m_localCenterA = b1->GetLocalCenter();
+	m_localCenterB = b2->GetLocalCenter();
+	m_invMassA = b1->m_invMass;
+	m_invMassB = b2->m_invMass;
+	m_invIA = b1->m_invI;
+	m_invIB = b2->m_invI;
+
+	float32 a1 = data.positions[m_indexA].a;
+	b2Vec2 v1 = data.velocities[m_indexA].v;
+	float32 w1 = data.velocities[m_indexA].w;
+
+	float32 a2 = data.positions[m_indexB].a;
+	b2Vec2 v2 = data.velocities[m_indexB].v;
+	float32 w2 = data.velocities[m_indexB].w;
+
 	if (m_enableMotor || m_enableLimit)
 	{
 		// You cannot create a rotation limit between bodies that
 		// both have fixed rotation.
-		b2Assert(b1->m_invI > 0.0f || b2->m_invI > 0.0f);
+		b2Assert(m_invIA > 0.0f || m_invIB > 0.0f);
 	}
 
+	b2Mat22 R1(a1), R2(a2);
+
 	// Compute the effective mass matrix.
-	b2Vec2 r1 = b2Mul(b1->GetTransform().R, m_localAnchor1 - b1->GetLocalCenter());
-	b2Vec2 r2 = b2Mul(b2->GetTransform().R, m_localAnchor2 - b2->GetLocalCenter());
+	b2Vec2 r1 = b2Mul(R1, m_localAnchor1 - m_localCenterA);
+	b2Vec2 r2 = b2Mul(R2, m_localAnchor2 - m_localCenterB);
 
 	// J = [-I -r1_skew I r2_skew]
 	//     [ 0       -1 0       1]
@@ -86,8 +103,8 @@ void b2RevoluteJoint::InitVelocityConstraints(const b2TimeStep& step)
 	//     [  -r1y*i1*r1x-r2y*i2*r2x, m1+r1x^2*i1+m2+r2x^2*i2,           r1x*i1+r2x*i2]
 	//     [          -r1y*i1-r2y*i2,           r1x*i1+r2x*i2,                   i1+i2]
 
-	float32 m1 = b1->m_invMass, m2 = b2->m_invMass;
-	float32 i1 = b1->m_invI, i2 = b2->m_invI;
+	float32 m1 = m_invMassA, m2 = m_invMassB;
+	float32 i1 = m_invIA, i2 = m_invIB;
 
 	m_mass.col1.x = m1 + m2 + r1.y * r1.y * i1 + r2.y * r2.y * i2;
 	m_mass.col2.x = -r1.y * r1.x * i1 - r2.y * r2.x * i2;
@@ -112,7 +129,7 @@ void b2RevoluteJoint::InitVelocityConstraints(const b2TimeStep& step)
 
 	if (m_enableLimit)
 	{
-		float32 jointAngle = b2->m_sweep.a - b1->m_sweep.a - m_referenceAngle;
+		float32 jointAngle = a2 - a1 - m_referenceAngle;
 		if (b2Abs(m_upperAngle - m_lowerAngle) < 2.0f * b2_angularSlop)
 		{
 			m_limitState = e_equalLimits;
@@ -144,39 +161,43 @@ void b2RevoluteJoint::InitVelocityConstraints(const b2TimeStep& step)
 		m_limitState = e_inactiveLimit;
 	}
 
-	if (step.warmStarting)
+	if (data.step.warmStarting)
 	{
 		// Scale impulses to support a variable time step.
-		m_impulse *= step.dtRatio;
-		m_motorImpulse *= step.dtRatio;
+		m_impulse *= data.step.dtRatio;
+		m_motorImpulse *= data.step.dtRatio;
 
 		b2Vec2 P(m_impulse.x, m_impulse.y);
 
-		b1->m_linearVelocity -= m1 * P;
-		b1->m_angularVelocity -= i1 * (b2Cross(r1, P) + m_motorImpulse + m_impulse.z);
+		v1 -= m1 * P;
+		w1 -= i1 * (b2Cross(r1, P) + m_motorImpulse + m_impulse.z);
 
-		b2->m_linearVelocity += m2 * P;
-		b2->m_angularVelocity += i2 * (b2Cross(r2, P) + m_motorImpulse + m_impulse.z);
+		v2 += m2 * P;
+		w2 += i2 * (b2Cross(r2, P) + m_motorImpulse + m_impulse.z);
 	}
 	else
 	{
 		m_impulse.SetZero();
 		m_motorImpulse = 0.0f;
 	}
+
+	data.velocities[m_indexA].v = v1;
+	data.velocities[m_indexA].w = w1;
+	data.velocities[m_indexB].v = v2;
+	data.velocities[m_indexB].w = w2;
 }
 
-void b2RevoluteJoint::SolveVelocityConstraints(const b2TimeStep& step)
+void b2RevoluteJoint::SolveVelocityConstraints(const b2SolverData& data)
 {
-	b2Body* b1 = m_bodyA;
-	b2Body* b2 = m_bodyB;
+	b2Vec2 v1 = data.velocities[m_indexA].v;
+	float32 w1 = data.velocities[m_indexA].w;
+	b2Vec2 v2 = data.velocities[m_indexB].v;
+	float32 w2 = data.velocities[m_indexB].w;
 
-	b2Vec2 v1 = b1->m_linearVelocity;
-	float32 w1 = b1->m_angularVelocity;
-	b2Vec2 v2 = b2->m_linearVelocity;
-	float32 w2 = b2->m_angularVelocity;
+	float32 m1 = m_invMassA, m2 = m_invMassB;
+	float32 i1 = m_invIA, i2 = m_invIB;
 
-	float32 m1 = b1->m_invMass, m2 = b2->m_invMass;
-	float32 i1 = b1->m_invI, i2 = b2->m_invI;
+	b2Mat22 R1(data.positions[m_indexA].a), R2(data.positions[m_indexB].a);
 
 	// Solve motor constraint.
 	if (m_enableMotor && m_limitState != e_equalLimits)
@@ -184,7 +205,7 @@ void b2RevoluteJoint::SolveVelocityConstraints(const b2TimeStep& step)
 		float32 Cdot = w2 - w1 - m_motorSpeed;
 		float32 impulse = m_motorMass * (-Cdot);
 		float32 oldImpulse = m_motorImpulse;
-		float32 maxImpulse = step.dt * m_maxMotorTorque;
+		float32 maxImpulse = data.step.dt * m_maxMotorTorque;
 		m_motorImpulse = b2Clamp(m_motorImpulse + impulse, -maxImpulse, maxImpulse);
 		impulse = m_motorImpulse - oldImpulse;
 
@@ -195,8 +216,8 @@ void b2RevoluteJoint::SolveVelocityConstraints(const b2TimeStep& step)
 	// Solve limit constraint.
 	if (m_enableLimit && m_limitState != e_inactiveLimit)
 	{
-		b2Vec2 r1 = b2Mul(b1->GetTransform().R, m_localAnchor1 - b1->GetLocalCenter());
-		b2Vec2 r2 = b2Mul(b2->GetTransform().R, m_localAnchor2 - b2->GetLocalCenter());
+		b2Vec2 r1 = b2Mul(R1, m_localAnchor1 - m_localCenterA);
+		b2Vec2 r2 = b2Mul(R2, m_localAnchor2 - m_localCenterB);
 
 		// Solve point-to-point constraint
 		b2Vec2 Cdot1 = v2 + b2Cross(w2, r2) - v1 - b2Cross(w1, r1);
@@ -248,8 +269,8 @@ void b2RevoluteJoint::SolveVelocityConstraints(const b2TimeStep& step)
 	}
 	else
 	{
-		b2Vec2 r1 = b2Mul(b1->GetTransform().R, m_localAnchor1 - b1->GetLocalCenter());
-		b2Vec2 r2 = b2Mul(b2->GetTransform().R, m_localAnchor2 - b2->GetLocalCenter());
+		b2Vec2 r1 = b2Mul(R1, m_localAnchor1 - m_localCenterA);
+		b2Vec2 r2 = b2Mul(R2, m_localAnchor2 - m_localCenterB);
 
 		// Solve point-to-point constraint
 		b2Vec2 Cdot = v2 + b2Cross(w2, r2) - v1 - b2Cross(w1, r1);
@@ -265,20 +286,20 @@ void b2RevoluteJoint::SolveVelocityConstraints(const b2TimeStep& step)
 		w2 += i2 * b2Cross(r2, impulse);
 	}
 
-	b1->m_linearVelocity = v1;
-	b1->m_angularVelocity = w1;
-	b2->m_linearVelocity = v2;
-	b2->m_angularVelocity = w2;
+	data.velocities[m_indexA].v = v1;
+	data.velocities[m_indexA].w = w1;
+	data.velocities[m_indexB].v = v2;
+	data.velocities[m_indexB].w = w2;
 }
 
-bool b2RevoluteJoint::SolvePositionConstraints(float32 baumgarte)
+bool b2RevoluteJoint::SolvePositionConstraints(const b2SolverData& data)
 {
 	// TODO_ERIN block solve with limit.
 
-	B2_NOT_USED(baumgarte);
-
-	b2Body* b1 = m_bodyA;
-	b2Body* b2 = m_bodyB;
+	b2Vec2 c1 = data.positions[m_indexA].c;
+	float32 a1 = data.positions[m_indexA].a;
+	b2Vec2 c2 = data.positions[m_indexB].c;
+	float32 a2 = data.positions[m_indexB].a;
 
 	float32 angularError = 0.0f;
 	float32 positionError = 0.0f;
@@ -286,7 +307,7 @@ bool b2RevoluteJoint::SolvePositionConstraints(float32 baumgarte)
 	// Solve angular limit constraint.
 	if (m_enableLimit && m_limitState != e_inactiveLimit)
 	{
-		float32 angle = b2->m_sweep.a - b1->m_sweep.a - m_referenceAngle;
+		float32 angle = a2 - a1 - m_referenceAngle;
 		float32 limitImpulse = 0.0f;
 
 		if (m_limitState == e_equalLimits)
@@ -315,23 +336,22 @@ bool b2RevoluteJoint::SolvePositionConstraints(float32 baumgarte)
 			limitImpulse = -m_motorMass * C;
 		}
 
-		b1->m_sweep.a -= b1->m_invI * limitImpulse;
-		b2->m_sweep.a += b2->m_invI * limitImpulse;
-
-		b1->SynchronizeTransform();
-		b2->SynchronizeTransform();
+		a1 -= m_invIA * limitImpulse;
+		a2 += m_invIB * limitImpulse;
 	}
 
 	// Solve point-to-point constraint.
 	{
-		b2Vec2 r1 = b2Mul(b1->GetTransform().R, m_localAnchor1 - b1->GetLocalCenter());
-		b2Vec2 r2 = b2Mul(b2->GetTransform().R, m_localAnchor2 - b2->GetLocalCenter());
+		b2Mat22 R1(a1), R2(a2);
+
+		b2Vec2 r1 = b2Mul(R1, m_localAnchor1 - m_localCenterA);
+		b2Vec2 r2 = b2Mul(R2, m_localAnchor2 - m_localCenterB);
 
-		b2Vec2 C = b2->m_sweep.c + r2 - b1->m_sweep.c - r1;
+		b2Vec2 C = c2 + r2 - c1 - r1;
 		positionError = C.Length();
 
-		float32 invMass1 = b1->m_invMass, invMass2 = b2->m_invMass;
-		float32 invI1 = b1->m_invI, invI2 = b2->m_invI;
+		float32 invMass1 = m_invMassA, invMass2 = m_invMassB;
+		float32 invI1 = m_invIA, invI2 = m_invIB;
 
 		// Handle large detachment.
 		const float32 k_allowedStretch = 10.0f * b2_linearSlop;
@@ -346,10 +366,10 @@ bool b2RevoluteJoint::SolvePositionConstraints(float32 baumgarte)
 			}
 			b2Vec2 impulse = m * (-C);
 			const float32 k_beta = 0.5f;
-			b1->m_sweep.c -= k_beta * invMass1 * impulse;
-			b2->m_sweep.c += k_beta * invMass2 * impulse;
+			c1 -= k_beta * invMass1 * impulse;
+			c2 += k_beta * invMass2 * impulse;
 
-			C = b2->m_sweep.c + r2 - b1->m_sweep.c - r1;
+			C = c2 + r2 - c1 - r1;
 		}
 
 		b2Mat22 K1;
@@ -367,15 +387,17 @@ bool b2RevoluteJoint::SolvePositionConstraints(float32 baumgarte)
 		b2Mat22 K = K1 + K2 + K3;
 		b2Vec2 impulse = K.Solve(-C);
 
-		b1->m_sweep.c -= b1->m_invMass * impulse;
-		b1->m_sweep.a -= b1->m_invI * b2Cross(r1, impulse);
+		c1 -= m_invMassA * impulse;
+		a1 -= m_invIA * b2Cross(r1, impulse);
 
-		b2->m_sweep.c += b2->m_invMass * impulse;
-		b2->m_sweep.a += b2->m_invI * b2Cross(r2, impulse);
-
-		b1->SynchronizeTransform();
-		b2->SynchronizeTransform();
+		c2 += m_invMassB * impulse;
+		a2 += m_invIB * b2Cross(r2, impulse);
 	}
+
+	data.positions[m_indexA].c = c1;
+	data.positions[m_indexA].a = a1;
+	data.positions[m_indexB].c = c2;
+	data.positions[m_indexB].a = a2;
 	
 	return positionError <= b2_linearSlop && angularError <= b2_angularSlop;
 }
@@ -53,14 +53,31 @@ b2WeldJoint::b2WeldJoint(const b2WeldJointDef* def)
 	m_impulse.SetZero();
 }
 
-void b2WeldJoint::InitVelocityConstraints(const b2TimeStep& step)
+void b2WeldJoint::InitVelocityConstraints(const b2SolverData& data)
 {
 	b2Body* bA = m_bodyA;
 	b2Body* bB = m_bodyB;
 
+	m_localCenterA = bA->GetLocalCenter();
+	m_localCenterB = bB->GetLocalCenter();
+	m_invMassA = bA->m_invMass;
+	m_invMassB = bB->m_invMass;
+	m_invIA = bA->m_invI;
+	m_invIB = bB->m_invI;
+
+	float32 aA = data.positions[m_indexA].a;
+	b2Vec2 vA = data.velocities[m_indexA].v;
+	float32 wA = data.velocities[m_indexA].w;
+
+	float32 aB = data.positions[m_indexB].a;
+	b2Vec2 vB = data.velocities[m_indexB].v;
+	float32 wB = data.velocities[m_indexB].w;
+
+	b2Mat22 RA(aA), RB(aB);
+
 	// Compute the effective mass matrix.
-	b2Vec2 rA = b2Mul(bA->GetTransform().R, m_localAnchorA - bA->GetLocalCenter());
-	b2Vec2 rB = b2Mul(bB->GetTransform().R, m_localAnchorB - bB->GetLocalCenter());
+	b2Vec2 rA = b2Mul(RA, m_localAnchorA - m_localCenterA);
+	b2Vec2 rB = b2Mul(RB, m_localAnchorB - m_localCenterB);
 
 	// J = [-I -r1_skew I r2_skew]
 	//     [ 0       -1 0       1]
@@ -71,8 +88,8 @@ void b2WeldJoint::InitVelocityConstraints(const b2TimeStep& step)
 	//     [  -r1y*iA*r1x-r2y*iB*r2x, mA+r1x^2*iA+mB+r2x^2*iB,           r1x*iA+r2x*iB]
 	//     [          -r1y*iA-r2y*iB,           r1x*iA+r2x*iB,                   iA+iB]
 
-	float32 mA = bA->m_invMass, mB = bB->m_invMass;
-	float32 iA = bA->m_invI, iB = bB->m_invI;
+	float32 mA = m_invMassA, mB = m_invMassB;
+	float32 iA = m_invIA, iB = m_invIB;
 
 	m_mass.col1.x = mA + mB + rA.y * rA.y * iA + rB.y * rB.y * iB;
 	m_mass.col2.x = -rA.y * rA.x * iA - rB.y * rB.x * iB;
@@ -84,42 +101,44 @@ void b2WeldJoint::InitVelocityConstraints(const b2TimeStep& step)
 	m_mass.col2.z = m_mass.col3.y;
 	m_mass.col3.z = iA + iB;
 
-	if (step.warmStarting)
+	if (data.step.warmStarting)
 	{
 		// Scale impulses to support a variable time step.
-		m_impulse *= step.dtRatio;
+		m_impulse *= data.step.dtRatio;
 
 		b2Vec2 P(m_impulse.x, m_impulse.y);
 
-		bA->m_linearVelocity -= mA * P;
-		bA->m_angularVelocity -= iA * (b2Cross(rA, P) + m_impulse.z);
+		vA -= mA * P;
+		wA -= iA * (b2Cross(rA, P) + m_impulse.z);
 
-		bB->m_linearVelocity += mB * P;
-		bB->m_angularVelocity += iB * (b2Cross(rB, P) + m_impulse.z);
+		vB += mB * P;
+		wB += iB * (b2Cross(rB, P) + m_impulse.z);
 	}
 	else
 	{
 		m_impulse.SetZero();
 	}
+
+	data.velocities[m_indexA].v = vA;
+	data.velocities[m_indexA].w = wA;
+	data.velocities[m_indexB].v = vB;
+	data.velocities[m_indexB].w = wB;
 }
 
-void b2WeldJoint::SolveVelocityConstraints(const b2TimeStep& step)
+void b2WeldJoint::SolveVelocityConstraints(const b2SolverData& data)
 {
-	B2_NOT_USED(step);
+	b2Vec2 vA = data.velocities[m_indexA].v;
+	float32 wA = data.velocities[m_indexA].w;
+	b2Vec2 vB = data.velocities[m_indexB].v;
+	float32 wB = data.velocities[m_indexB].w;
 
-	b2Body* bA = m_bodyA;
-	b2Body* bB = m_bodyB;
-
-	b2Vec2 vA = bA->m_linearVelocity;
-	float32 wA = bA->m_angularVelocity;
-	b2Vec2 vB = bB->m_linearVelocity;
-	float32 wB = bB->m_angularVelocity;
+	float32 mA = m_invMassA, mB = m_invMassB;
+	float32 iA = m_invIA, iB = m_invIB;
 
-	float32 mA = bA->m_invMass, mB = bB->m_invMass;
-	float32 iA = bA->m_invI, iB = bB->m_invI;
+	b2Mat22 RA(data.positions[m_indexA].a), RB(data.positions[m_indexB].a);
 
-	b2Vec2 rA = b2Mul(bA->GetTransform().R, m_localAnchorA - bA->GetLocalCenter());
-	b2Vec2 rB = b2Mul(bB->GetTransform().R, m_localAnchorB - bB->GetLocalCenter());
+	b2Vec2 rA = b2Mul(RA, m_localAnchorA - m_localCenterA);
+	b2Vec2 rB = b2Mul(RB, m_localAnchorB - m_localCenterB);
 
 	// Solve point-to-point constraint
 	b2Vec2 Cdot1 = vB + b2Cross(wB, rB) - vA - b2Cross(wA, rA);
@@ -137,27 +156,29 @@ void b2WeldJoint::SolveVelocityConstraints(const b2TimeStep& step)
 	vB += mB * P;
 	wB += iB * (b2Cross(rB, P) + impulse.z);
 
-	bA->m_linearVelocity = vA;
-	bA->m_angularVelocity = wA;
-	bB->m_linearVelocity = vB;
-	bB->m_angularVelocity = wB;
+	data.velocities[m_indexA].v = vA;
+	data.velocities[m_indexA].w = wA;
+	data.velocities[m_indexB].v = vB;
+	data.velocities[m_indexB].w = wB;
 }
 
-bool b2WeldJoint::SolvePositionConstraints(float32 baumgarte)
+bool b2WeldJoint::SolvePositionConstraints(const b2SolverData& data)
 {
-	B2_NOT_USED(baumgarte);
+	b2Vec2 cA = data.positions[m_indexA].c;
+	float32 aA = data.positions[m_indexA].a;
+	b2Vec2 cB = data.positions[m_indexB].c;
+	float32 aB = data.positions[m_indexB].a;
 
-	b2Body* bA = m_bodyA;
-	b2Body* bB = m_bodyB;
+	float32 mA = m_invMassA, mB = m_invMassB;
+	float32 iA = m_invIA, iB = m_invIB;
 
-	float32 mA = bA->m_invMass, mB = bB->m_invMass;
-	float32 iA = bA->m_invI, iB = bB->m_invI;
+	b2Mat22 RA(aA), RB(aB);
 
-	b2Vec2 rA = b2Mul(bA->GetTransform().R, m_localAnchorA - bA->GetLocalCenter());
-	b2Vec2 rB = b2Mul(bB->GetTransform().R, m_localAnchorB - bB->GetLocalCenter());
+	b2Vec2 rA = b2Mul(RA, m_localAnchorA - m_localCenterA);
+	b2Vec2 rB = b2Mul(RB, m_localAnchorB - m_localCenterB);
 
-	b2Vec2 C1 =  bB->m_sweep.c + rB - bA->m_sweep.c - rA;
-	float32 C2 = bB->m_sweep.a - bA->m_sweep.a - m_referenceAngle;
+	b2Vec2 C1 =  cB + rB - cA - rA;
+	float32 C2 = aB - aA - m_referenceAngle;
 
 	// Handle large detachment.
 	const float32 k_allowedStretch = 10.0f * b2_linearSlop;
@@ -185,14 +206,16 @@ bool b2WeldJoint::SolvePositionConstraints(float32 baumgarte)
 
 	b2Vec2 P(impulse.x, impulse.y);
 
-	bA->m_sweep.c -= mA * P;
-	bA->m_sweep.a -= iA * (b2Cross(rA, P) + impulse.z);
+	cA -= mA * P;
+	aA -= iA * (b2Cross(rA, P) + impulse.z);
 
-	bB->m_sweep.c += mB * P;
-	bB->m_sweep.a += iB * (b2Cross(rB, P) + impulse.z);
+	cB += mB * P;
+	aB += iB * (b2Cross(rB, P) + impulse.z);
 
-	bA->SynchronizeTransform();
-	bB->SynchronizeTransform();
+	data.positions[m_indexA].c = cA;
+	data.positions[m_indexA].a = aA;
+	data.positions[m_indexB].c = cB;
+	data.positions[m_indexB].a = aB;
 
 	return positionError <= b2_linearSlop && angularError <= b2_angularSlop;
 }
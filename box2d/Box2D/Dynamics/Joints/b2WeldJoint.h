@@ -65,10 +65,10 @@ protected:
 
 	b2WeldJoint(const b2WeldJointDef* def);
 
-	void InitVelocityConstraints(const b2TimeStep& step);
-	void SolveVelocityConstraints(const b2TimeStep& step);
+	void InitVelocityConstraints(const b2SolverData& data);
+	void SolveVelocityConstraints(const b2SolverData& data);
 
-	bool SolvePositionConstraints(float32 baumgarte);
+	bool SolvePositionConstraints(const b2SolverData& data);
 
 	b2Vec2 m_localAnchorA;
 	b2Vec2 m_localAnchorB;
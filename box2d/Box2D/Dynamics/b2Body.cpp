@@ -32,7 +32,8 @@ b2Body::b2Body(const b2BodyDef* bd, b2World* world)
 	b2Assert(b2IsValid(bd->angularDamping) && bd->angularDamping >= 0.0f);
 	b2Assert(b2IsValid(bd->linearDamping) && bd->linearDamping >= 0.0f);
 
-	m_flags = 0;
+	// The time of impact is only unresolved while b2World::SolveTOI runs.
+	m_flags = e_toiFlag;
 
 	if (bd->bullet)
 	{
@@ -69,6 +70,10 @@ b2Body::b2Body(const b2BodyDef* bd, b2World* world)
 	m_prev = NULL;
 	m_next = NULL;
 
+	m_island = NULL;
+	m_islandPrev = NULL;
+	m_islandNext = NULL;
+
 	m_linearVelocity = bd->linearVelocity;
 	m_angularVelocity = bd->angularVelocity;
 
@@ -114,8 +119,32 @@ void b2Body::SetType(b2BodyType type)
 		return;
 	}
 
+	// Static bodies are not part of islands.
+	bool wasStatic = m_type == b2_staticBody;
 	m_type = type;
 
+	if (IsActive() && wasStatic != (m_type == b2_staticBody))
+	{
+		if (wasStatic)
+		{
+			m_world->LinkBody(this);
+		}
+		else
+		{
+			m_world->UnlinkBody(this);
+		}
+
+		// Static proxies are kept apart in the broad-phase. The new proxies
+		// find their pairs at the start of the next time step.
+		b2BroadPhase* broadPhase = m_world->m_contactManager.m_broadPhase;
+		for (b2Fixture* f = m_fixtureList; f; f = f->m_next)
+		{
+			f->DestroyProxy(broadPhase);
+			f->CreateProxy(broadPhase, m_xf);
+		}
+		m_world->m_flags |= b2World::e_newFixture;
+	}
+
 	ResetMassData();
 
 	if (m_type == b2_staticBody)
@@ -152,7 +181,7 @@ b2Fixture* b2Body::CreateFixture(const b2FixtureDef* def)
 
 	if (m_flags & e_activeFlag)
 	{
-		b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
+		b2BroadPhase* broadPhase = m_world->m_contactManager.m_broadPhase;
 		fixture->CreateProxy(broadPhase, m_xf);
 	}
 
@@ -236,7 +265,7 @@ void b2Body::DestroyFixture(b2Fixture* fixture)
 	if (m_flags & e_activeFlag)
 	{
 		b2Assert(fixture->m_proxyId != b2BroadPhase::e_nullProxy);
-		b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
+		b2BroadPhase* broadPhase = m_world->m_contactManager.m_broadPhase;
 		fixture->DestroyProxy(broadPhase);
 	}
 	else
@@ -256,6 +285,32 @@ void b2Body::DestroyFixture(b2Fixture* fixture)
 	ResetMassData();
 }
 
+void b2Body::RefreshFixture(b2Fixture* fixture)
+{
+	b2Assert(m_world->IsLocked() == false);
+	if (m_world->IsLocked() == true)
+	{
+		return;
+	}
+
+	b2Assert(fixture->m_body == this);
+
+	if (m_flags & e_activeFlag)
+	{
+		// The proxy is only moved if the shape outgrew its fat AABB.
+		b2BroadPhase* broadPhase = m_world->m_contactManager.m_broadPhase;
+		fixture->Synchronize(broadPhase, m_xf, m_xf);
+	}
+
+	ResetMassData();
+
+	// Let the world query for new contacts next time step.
+	m_world->m_flags |= b2World::e_newFixture;
+
+	// Contacts resting on the old geometry need to be solved again.
+	SetAwake(true);
+}
+
 void b2Body::ResetMassData()
 {
 	// Compute mass data from shapes. Each shape has its own density.
@@ -390,6 +445,14 @@ bool b2Body::ShouldCollide(const b2Body* other) const
 	return true;
 }
 
+void b2Body::WakeIsland()
+{
+	if (m_island)
+	{
+		m_world->WakeIsland(m_island);
+	}
+}
+
 void b2Body::SetTransform(const b2Vec2& position, float32 angle)
 {
 	b2Assert(m_world->IsLocked() == false);
@@ -404,7 +467,7 @@ void b2Body::SetTransform(const b2Vec2& position, float32 angle)
 	m_sweep.c0 = m_sweep.c = b2Mul(m_xf, m_sweep.localCenter);
 	m_sweep.a0 = m_sweep.a = angle;
 
-	b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
+	b2BroadPhase* broadPhase = m_world->m_contactManager.m_broadPhase;
 	for (b2Fixture* f = m_fixtureList; f; f = f->m_next)
 	{
 		f->Synchronize(broadPhase, m_xf, m_xf);
@@ -419,7 +482,7 @@ void b2Body::SynchronizeFixtures()
 	xf1.R.Set(m_sweep.a0);
 	xf1.position = m_sweep.c0 - b2Mul(xf1.R, m_sweep.localCenter);
 
-	b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
+	b2BroadPhase* broadPhase = m_world->m_contactManager.m_broadPhase;
 	for (b2Fixture* f = m_fixtureList; f; f = f->m_next)
 	{
 		f->Synchronize(broadPhase, xf1, m_xf);
@@ -438,12 +501,17 @@ void b2Body::SetActive(bool flag)
 		m_flags |= e_activeFlag;
 
 		// Create all proxies.
-		b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
+		b2BroadPhase* broadPhase = m_world->m_contactManager.m_broadPhase;
 		for (b2Fixture* f = m_fixtureList; f; f = f->m_next)
 		{
 			f->CreateProxy(broadPhase, m_xf);
 		}
 
+		if (m_type != b2_staticBody)
+		{
+			m_world->LinkBody(this);
+		}
+
 		// Contacts are created the next time step.
 	}
 	else
@@ -451,7 +519,7 @@ void b2Body::SetActive(bool flag)
 		m_flags &= ~e_activeFlag;
 
 		// Destroy all proxies.
-		b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
+		b2BroadPhase* broadPhase = m_world->m_contactManager.m_broadPhase;
 		for (b2Fixture* f = m_fixtureList; f; f = f->m_next)
 		{
 			f->DestroyProxy(broadPhase);
@@ -466,5 +534,7 @@ void b2Body::SetActive(bool flag)
 			m_world->m_contactManager.Destroy(ce0->contact);
 		}
 		m_contactList = NULL;
+
+		m_world->UnlinkBody(this);
 	}
 }
\ No newline at end of file
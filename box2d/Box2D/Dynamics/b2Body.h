@@ -31,6 +31,7 @@ class b2World;
 struct b2FixtureDef;
 struct b2JointEdge;
 struct b2ContactEdge;
+struct b2PersistentIsland;
 
 /// The body type.
 /// static: zero mass, zero velocity, may be manually moved
@@ -150,6 +151,15 @@ public:
 	/// @warning This function is locked during callbacks.
 	void DestroyFixture(b2Fixture* fixture);
 
+	/// Update a fixture after its shape was modified in place, for example
+	/// to resize it. This refreshes the fixture's broad-phase proxy and the
+	/// mass of the body, but unlike destroying and re-creating the fixture it
+	/// keeps the existing contacts and their accumulated impulses.
+	/// The type of the shape and the number of vertices must not be changed.
+	/// @param fixture the fixture whose shape or density was modified.
+	/// @warning This function is locked during callbacks.
+	void RefreshFixture(b2Fixture* fixture);
+
 	/// Set the position of the body's origin and rotation.
 	/// This breaks any contacts and wakes the other bodies.
 	/// Manipulating a body's transform may cause non-physical behavior.
@@ -366,6 +376,7 @@ private:
 
 	friend class b2World;
 	friend class b2Island;
+	friend struct b2PersistentIsland;
 	friend class b2ContactManager;
 	friend class b2ContactSolver;
 	friend class b2TOISolver;
@@ -404,6 +415,9 @@ private:
 
 	void Advance(float32 t);
 
+	// Put the island of this body on the world's awake island list.
+	void WakeIsland();
+
 	b2BodyType m_type;
 
 	uint16 m_flags;
@@ -423,6 +437,11 @@ private:
 	b2Body* m_prev;
 	b2Body* m_next;
 
+	// The persistent island of an active non-static body, NULL otherwise.
+	b2PersistentIsland* m_island;
+	b2Body* m_islandPrev;
+	b2Body* m_islandNext;
+
 	b2Fixture* m_fixtureList;
 	int32 m_fixtureCount;
 
@@ -604,6 +623,7 @@ inline void b2Body::SetAwake(bool flag)
 		{
 			m_flags |= e_awakeFlag;
 			m_sleepTime = 0.0f;
+			WakeIsland();
 		}
 	}
 	else
@@ -19,19 +19,102 @@
 #include <Box2D/Dynamics/b2ContactManager.h>
 #include <Box2D/Dynamics/b2Body.h>
 #include <Box2D/Dynamics/b2Fixture.h>
+#include <Box2D/Dynamics/b2Island.h>
+#include <Box2D/Dynamics/b2World.h>
 #include <Box2D/Dynamics/b2WorldCallbacks.h>
 #include <Box2D/Dynamics/Contacts/b2Contact.h>
+#include <Box2D/Common/b2TaskScheduler.h>
+
+#include <cstring>
 
 b2ContactFilter b2_defaultFilter;
 b2ContactListener b2_defaultListener;
 
+// An awake contact and the result of updating its manifold.
+struct b2ContactUpdate
+{
+	b2Contact* contact;
+	b2Manifold oldManifold;
+	bool touching;
+};
+
+// Updates the manifolds of a range of gathered contacts.
+class b2CollideTask : public b2Task
+{
+public:
+	b2CollideTask(b2ContactUpdate* updates) : m_updates(updates) {}
+
+	void Execute(int32 begin, int32 end, int32 threadIndex)
+	{
+		B2_NOT_USED(threadIndex);
+
+		for (int32 i = begin; i < end; ++i)
+		{
+			b2ContactUpdate* update = m_updates + i;
+			update->touching = update->contact->UpdateManifold(&update->oldManifold);
+		}
+	}
+
+private:
+	b2ContactUpdate* m_updates;
+};
+
 b2ContactManager::b2ContactManager()
 {
+	m_broadPhase = b2BroadPhase::Create(b2_treeBroadPhase, 0.0f);
 	m_contactList = NULL;
 	m_contactCount = 0;
 	m_contactFilter = &b2_defaultFilter;
 	m_contactListener = &b2_defaultListener;
 	m_allocator = NULL;
+	m_taskScheduler = NULL;
+	m_awakeContactCapacity = 64;
+	m_awakeContactCount = 0;
+	m_awakeContacts = (b2Contact**)b2Alloc(m_awakeContactCapacity * sizeof(b2Contact*));
+	m_updates = NULL;
+	m_updateCapacity = 0;
+}
+
+b2ContactManager::~b2ContactManager()
+{
+	b2BroadPhase::Destroy(m_broadPhase);
+	b2Free(m_awakeContacts);
+	b2Free(m_updates);
+}
+
+void b2ContactManager::SynchronizeAwake(b2Contact* c)
+{
+	const b2PersistentIsland* islandA = c->m_fixtureA->m_body->m_island;
+	const b2PersistentIsland* islandB = c->m_fixtureB->m_body->m_island;
+	bool awake = (islandA && islandA->awake) || (islandB && islandB->awake);
+
+	if (awake && c->m_awakeIndex == -1)
+	{
+		if (m_awakeContactCount == m_awakeContactCapacity)
+		{
+			b2Contact** oldContacts = m_awakeContacts;
+			m_awakeContactCapacity *= 2;
+			m_awakeContacts = (b2Contact**)b2Alloc(m_awakeContactCapacity * sizeof(b2Contact*));
+			memcpy(m_awakeContacts, oldContacts, m_awakeContactCount * sizeof(b2Contact*));
+			b2Free(oldContacts);
+		}
+
+		c->m_awakeIndex = m_awakeContactCount;
+		m_awakeContacts[m_awakeContactCount++] = c;
+	}
+	else if (awake == false && c->m_awakeIndex != -1)
+	{
+		RemoveAwake(c);
+	}
+}
+
+void b2ContactManager::RemoveAwake(b2Contact* c)
+{
+	// Move the last awake contact into the hole.
+	b2Contact* last = m_awakeContacts[--m_awakeContactCount];
+	m_awakeContacts[c->m_awakeIndex] = last;
+	last->m_awakeIndex = c->m_awakeIndex;
+	c->m_awakeIndex = -1;
 }
 
 void b2ContactManager::Destroy(b2Contact* c)
@@ -46,6 +129,11 @@ void b2ContactManager::Destroy(b2Contact* c)
 		m_contactListener->EndContact(c);
 	}
 
+	if (c->m_flags & b2Contact::e_islandFlag)
+	{
+		bodyA->m_world->UnlinkContact(c);
+	}
+
 	// Remove from the world.
 	if (c->m_prev)
 	{
@@ -62,6 +150,13 @@ void b2ContactManager::Destroy(b2Contact* c)
 		m_contactList = c->m_next;
 	}
 
+	if (c->m_awakeIndex != -1)
+	{
+		RemoveAwake(c);
+	}
+
+	m_pairSet.Remove(fixtureA, fixtureB);
+
 	// Remove from body 1
 	if (c->m_nodeA.prev)
 	{
@@ -100,43 +195,49 @@ void b2ContactManager::Destroy(b2Contact* c)
 }
 
 // This is the top level collision call for the time step. Here
-// all the narrow phase collision is processed for the world
-// contact list.
+// all the narrow phase collision is processed for the awake
+// contacts. The contacts are gathered first, their manifolds are
+// then computed in parallel if there is a task scheduler, and
+// finally the state changes are applied in the same order.
 void b2ContactManager::Collide()
 {
-	// Update awake contacts.
-	b2Contact* c = m_contactList;
-	while (c)
+	// Destroying a contact can wake up an island and add more awake contacts,
+	// but never more than there are contacts.
+	if (m_updateCapacity < m_contactCount)
+	{
+		b2Free(m_updates);
+		m_updateCapacity = b2Max(m_contactCount, 2 * m_updateCapacity);
+		m_updates = (b2ContactUpdate*)b2Alloc(m_updateCapacity * sizeof(b2ContactUpdate));
+	}
+
+	// Gather awake contacts. A destroyed contact is replaced by the last one,
+	// so the index only moves on for contacts that persist.
+	int32 updateCount = 0;
+	int32 index = 0;
+	while (index < m_awakeContactCount)
 	{
+		b2Contact* c = m_awakeContacts[index];
 		b2Fixture* fixtureA = c->GetFixtureA();
 		b2Fixture* fixtureB = c->GetFixtureB();
 		b2Body* bodyA = fixtureA->GetBody();
 		b2Body* bodyB = fixtureB->GetBody();
 
-		if (bodyA->IsAwake() == false && bodyB->IsAwake() == false)
-		{
-			c = c->GetNext();
-			continue;
-		}
-
-		// Is this contact flagged for filtering?
+		// Is this contact flagged for filtering? This is checked first, because
+		// the contact could still be solved with an awake island even if the
+		// user put both bodies to sleep.
 		if (c->m_flags & b2Contact::e_filterFlag)
 		{
 			// Should these bodies collide?
 			if (bodyB->ShouldCollide(bodyA) == false)
 			{
-				b2Contact* cNuke = c;
-				c = cNuke->GetNext();
-				Destroy(cNuke);
+				Destroy(c);
 				continue;
 			}
 
 			// Check user filtering.
 			if (m_contactFilter && m_contactFilter->ShouldCollide(fixtureA, fixtureB) == false)
 			{
-				b2Contact* cNuke = c;
-				c = cNuke->GetNext();
-				Destroy(cNuke);
+				Destroy(c);
 				continue;
 			}
 
@@ -144,28 +245,50 @@ void b2ContactManager::Collide()
 			c->m_flags &= ~b2Contact::e_filterFlag;
 		}
 
+		if (bodyA->IsAwake() == false && bodyB->IsAwake() == false)
+		{
+			++index;
+			continue;
+		}
+
 		int32 proxyIdA = fixtureA->m_proxyId;
 		int32 proxyIdB = fixtureB->m_proxyId;
-		bool overlap = m_broadPhase.TestOverlap(proxyIdA, proxyIdB);
+		bool overlap = m_broadPhase->TestOverlap(proxyIdA, proxyIdB);
 
 		// Here we destroy contacts that cease to overlap in the broad-phase.
 		if (overlap == false)
 		{
-			b2Contact* cNuke = c;
-			c = cNuke->GetNext();
-			Destroy(cNuke);
+			Destroy(c);
 			continue;
 		}
 
 		// The contact persists.
-		c->Update(m_contactListener);
-		c = c->GetNext();
+		m_updates[updateCount++].contact = c;
+		++index;
+	}
+
+	// Update the manifolds. This only touches the contacts themselves.
+	b2CollideTask task(m_updates);
+	if (m_taskScheduler)
+	{
+		m_taskScheduler->ParallelFor(&task, updateCount, 32);
+	}
+	else
+	{
+		task.Execute(0, updateCount, 0);
+	}
+
+	// Wake bodies and report begin and end of contact.
+	for (int32 i = 0; i < updateCount; ++i)
+	{
+		b2ContactUpdate* update = m_updates + i;
+		update->contact->UpdateState(update->oldManifold, update->touching, m_contactListener);
 	}
 }
 
 void b2ContactManager::FindNewContacts()
 {
-	m_broadPhase.UpdatePairs(this);
+	m_broadPhase->UpdatePairs(this);
 }
 
 void b2ContactManager::AddPair(void* proxyUserDataA, void* proxyUserDataB)
@@ -183,27 +306,9 @@ void b2ContactManager::AddPair(void* proxyUserDataA, void* proxyUserDataB)
 	}
 
 	// Does a contact already exist?
-	b2ContactEdge* edge = bodyB->GetContactList();
-	while (edge)
+	if (m_pairSet.Contains(fixtureA, fixtureB))
 	{
-		if (edge->other == bodyA)
-		{
-			b2Fixture* fA = edge->contact->GetFixtureA();
-			b2Fixture* fB = edge->contact->GetFixtureB();
-			if (fA == fixtureA && fB == fixtureB)
-			{
-				// A contact already exists.
-				return;
-			}
-
-			if (fA == fixtureB && fB == fixtureA)
-			{
-				// A contact already exists.
-				return;
-			}
-		}
-
-		edge = edge->next;
+		return;
 	}
 
 	// Does a joint override collision? Is at least one body dynamic?
@@ -262,5 +367,9 @@ void b2ContactManager::AddPair(void* proxyUserDataA, void* proxyUserDataB)
 	}
 	bodyB->m_contactList = &c->m_nodeB;
 
+	m_pairSet.Add(fixtureA, fixtureB);
+
+	SynchronizeAwake(c);
+
 	++m_contactCount;
 }
@@ -20,17 +20,21 @@
 #define B2_CONTACT_MANAGER_H
 
 #include <Box2D/Collision/b2BroadPhase.h>
+#include <Box2D/Common/b2PairSet.h>
 
 class b2Contact;
 class b2ContactFilter;
 class b2ContactListener;
 class b2BlockAllocator;
+class b2TaskScheduler;
+struct b2ContactUpdate;
 
 // Delegate of b2World.
-class b2ContactManager
+class b2ContactManager : public b2PairCallback
 {
 public:
 	b2ContactManager();
+	~b2ContactManager();
 
 	// Broad-phase callback.
 	void AddPair(void* proxyUserDataA, void* proxyUserDataB);
@@ -40,13 +44,33 @@ public:
 	void Destroy(b2Contact* c);
 
 	void Collide();
+
+	// Add a contact to the awake contacts or remove it. A contact is awake
+	// while the island of one of its bodies is awake.
+	void SynchronizeAwake(b2Contact* c);
+	void RemoveAwake(b2Contact* c);
             
-	b2BroadPhase m_broadPhase;
+	b2BroadPhase* m_broadPhase;
 	b2Contact* m_contactList;
 	int32 m_contactCount;
 	b2ContactFilter* m_contactFilter;
 	b2ContactListener* m_contactListener;
 	b2BlockAllocator* m_allocator;
+	b2TaskScheduler* m_taskScheduler;
+
+	// The fixture pairs that have a contact, so that AddPair does not have to
+	// search the contact lists of the bodies.
+	b2PairSet m_pairSet;
+
+	// The contacts that Collide updates, in no particular order. Sleeping
+	// contacts are only reachable through the contact list.
+	b2Contact** m_awakeContacts;
+	int32 m_awakeContactCount;
+	int32 m_awakeContactCapacity;
+
+	// Awake contacts gathered by Collide, kept between steps.
+	b2ContactUpdate* m_updates;
+	int32 m_updateCapacity;
 };
 
 #endif
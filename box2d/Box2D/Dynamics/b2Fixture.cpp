@@ -33,6 +33,7 @@ b2Fixture::b2Fixture()
 	m_proxyId = b2BroadPhase::e_nullProxy;
 	m_shape = NULL;
 	m_density = 0.0f;
+	m_sharedShape = false;
 }
 
 b2Fixture::~b2Fixture()
@@ -54,7 +55,15 @@ void b2Fixture::Create(b2BlockAllocator* allocator, b2Body* body, const b2Fixtur
 
 	m_isSensor = def->isSensor;
 
-	m_shape = def->shape->Clone(allocator);
+	m_sharedShape = def->shareShape;
+	if (m_sharedShape)
+	{
+		m_shape = const_cast<b2Shape*>(def->shape);
+	}
+	else
+	{
+		m_shape = def->shape->Clone(allocator);
+	}
 
 	m_density = def->density;
 }
@@ -64,6 +73,13 @@ void b2Fixture::Destroy(b2BlockAllocator* allocator)
 	// The proxy must be destroyed before calling this.
 	b2Assert(m_proxyId == b2BroadPhase::e_nullProxy);
 
+	// Shared shapes are owned by the application.
+	if (m_sharedShape)
+	{
+		m_shape = NULL;
+		return;
+	}
+
 	// Free the child shape.
 	switch (m_shape->m_type)
 	{
@@ -97,7 +113,7 @@ void b2Fixture::CreateProxy(b2BroadPhase* broadPhase, const b2Transform& xf)
 
 	// Create proxy in the broad-phase.
 	m_shape->ComputeAABB(&m_aabb, xf);
-	m_proxyId = broadPhase->CreateProxy(m_aabb, this);
+	m_proxyId = broadPhase->CreateProxy(m_aabb, this, m_body->GetType() == b2_staticBody);
 }
 
 void b2Fixture::DestroyProxy(b2BroadPhase* broadPhase)
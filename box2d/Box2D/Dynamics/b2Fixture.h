@@ -59,12 +59,13 @@ struct b2FixtureDef
 		filter.maskBits = 0xFFFF;
 		filter.groupIndex = 0;
 		isSensor = false;
+		shareShape = false;
 	}
 
 	virtual ~b2FixtureDef() {}
 
 	/// The shape, this must be set. The shape will be cloned, so you
-	/// can create the shape on the stack.
+	/// can create the shape on the stack, unless shareShape is set.
 	const b2Shape* shape;
 
 	/// Use this to store application specific fixture data.
@@ -85,6 +86,12 @@ struct b2FixtureDef
 
 	/// Contact filtering data.
 	b2Filter filter;
+
+	/// Use the shape directly instead of cloning it, so that it can be shared
+	/// by many fixtures. The shape must then outlive the fixture, and the
+	/// fixture must be refreshed with b2Body::RefreshFixture when the shape
+	/// is modified.
+	bool shareShape;
 };
 
 
@@ -214,6 +221,8 @@ protected:
 
 	bool m_isSensor;
 
+	bool m_sharedShape;
+
 	void* m_userData;
 };
 
@@ -24,6 +24,9 @@
 #include <Box2D/Dynamics/Contacts/b2ContactSolver.h>
 #include <Box2D/Dynamics/Joints/b2Joint.h>
 #include <Box2D/Common/b2StackAllocator.h>
+#include <Box2D/Common/b2TaskScheduler.h>
+
+#include <cstring>
 
 /*
 Position Correction Notes
@@ -143,6 +146,205 @@ This might be faster than computing sin+cos.
 However, we can compute sin+cos of the same angle fast.
 */
 
+void b2PersistentIsland::Clear()
+{
+	bodyList = NULL;
+	bodyTail = NULL;
+	contactList = NULL;
+	contactTail = NULL;
+	jointList = NULL;
+	jointTail = NULL;
+	bodyCount = 0;
+	constraintRemoveCount = 0;
+}
+
+void b2PersistentIsland::Add(b2Body* body)
+{
+	body->m_island = this;
+	body->m_islandPrev = bodyTail;
+	body->m_islandNext = NULL;
+	if (bodyTail)
+	{
+		bodyTail->m_islandNext = body;
+	}
+	else
+	{
+		bodyList = body;
+	}
+	bodyTail = body;
+	++bodyCount;
+}
+
+void b2PersistentIsland::Add(b2Contact* contact)
+{
+	contact->m_flags |= b2Contact::e_islandFlag;
+	contact->m_islandPrev = contactTail;
+	contact->m_islandNext = NULL;
+	if (contactTail)
+	{
+		contactTail->m_islandNext = contact;
+	}
+	else
+	{
+		contactList = contact;
+	}
+	contactTail = contact;
+}
+
+void b2PersistentIsland::Add(b2Joint* joint)
+{
+	joint->m_islandFlag = true;
+	joint->m_islandPrev = jointTail;
+	joint->m_islandNext = NULL;
+	if (jointTail)
+	{
+		jointTail->m_islandNext = joint;
+	}
+	else
+	{
+		jointList = joint;
+	}
+	jointTail = joint;
+}
+
+void b2PersistentIsland::Remove(b2Body* body)
+{
+	b2Assert(body->m_island == this);
+
+	if (body->m_islandPrev)
+	{
+		body->m_islandPrev->m_islandNext = body->m_islandNext;
+	}
+	else
+	{
+		bodyList = body->m_islandNext;
+	}
+
+	if (body->m_islandNext)
+	{
+		body->m_islandNext->m_islandPrev = body->m_islandPrev;
+	}
+	else
+	{
+		bodyTail = body->m_islandPrev;
+	}
+
+	body->m_island = NULL;
+	body->m_islandPrev = NULL;
+	body->m_islandNext = NULL;
+	--bodyCount;
+}
+
+void b2PersistentIsland::Remove(b2Contact* contact)
+{
+	b2Assert(contact->m_flags & b2Contact::e_islandFlag);
+
+	if (contact->m_islandPrev)
+	{
+		contact->m_islandPrev->m_islandNext = contact->m_islandNext;
+	}
+	else
+	{
+		contactList = contact->m_islandNext;
+	}
+
+	if (contact->m_islandNext)
+	{
+		contact->m_islandNext->m_islandPrev = contact->m_islandPrev;
+	}
+	else
+	{
+		contactTail = contact->m_islandPrev;
+	}
+
+	contact->m_flags &= ~b2Contact::e_islandFlag;
+	contact->m_islandPrev = NULL;
+	contact->m_islandNext = NULL;
+}
+
+void b2PersistentIsland::Remove(b2Joint* joint)
+{
+	b2Assert(joint->m_islandFlag);
+
+	if (joint->m_islandPrev)
+	{
+		joint->m_islandPrev->m_islandNext = joint->m_islandNext;
+	}
+	else
+	{
+		jointList = joint->m_islandNext;
+	}
+
+	if (joint->m_islandNext)
+	{
+		joint->m_islandNext->m_islandPrev = joint->m_islandPrev;
+	}
+	else
+	{
+		jointTail = joint->m_islandPrev;
+	}
+
+	joint->m_islandFlag = false;
+	joint->m_islandPrev = NULL;
+	joint->m_islandNext = NULL;
+}
+
+void b2PersistentIsland::Merge(b2PersistentIsland* other)
+{
+	for (b2Body* b = other->bodyList; b; b = b->m_islandNext)
+	{
+		b->m_island = this;
+	}
+
+	// Splice the lists.
+	if (other->bodyList)
+	{
+		if (bodyTail)
+		{
+			bodyTail->m_islandNext = other->bodyList;
+			other->bodyList->m_islandPrev = bodyTail;
+		}
+		else
+		{
+			bodyList = other->bodyList;
+		}
+		bodyTail = other->bodyTail;
+	}
+
+	if (other->contactList)
+	{
+		if (contactTail)
+		{
+			contactTail->m_islandNext = other->contactList;
+			other->contactList->m_islandPrev = contactTail;
+		}
+		else
+		{
+			contactList = other->contactList;
+		}
+		contactTail = other->contactTail;
+	}
+
+	if (other->jointList)
+	{
+		if (jointTail)
+		{
+			jointTail->m_islandNext = other->jointList;
+			other->jointList->m_islandPrev = jointTail;
+		}
+		else
+		{
+			jointList = other->jointList;
+		}
+		jointTail = other->jointTail;
+	}
+
+	bodyCount += other->bodyCount;
+	constraintRemoveCount += other->constraintRemoveCount;
+
+	other->Clear();
+}
+
 b2Island::b2Island(
 	int32 bodyCapacity,
 	int32 contactCapacity,
@@ -160,6 +362,14 @@ b2Island::b2Island(
 	m_allocator = allocator;
 	m_listener = listener;
 
+	m_collected = false;
+	m_impulses = NULL;
+	m_sleep = false;
+
+	m_taskScheduler = NULL;
+	m_jointColorCount = 0;
+	m_jointColorStarts[0] = 0;
+
 	m_bodies = (b2Body**)m_allocator->Allocate(bodyCapacity * sizeof(b2Body*));
 	m_contacts = (b2Contact**)m_allocator->Allocate(contactCapacity	 * sizeof(b2Contact*));
 	m_joints = (b2Joint**)m_allocator->Allocate(jointCapacity * sizeof(b2Joint*));
@@ -168,41 +378,106 @@ b2Island::b2Island(
 	m_positions = (b2Position*)m_allocator->Allocate(m_bodyCapacity * sizeof(b2Position));
 }
 
+b2Island::b2Island(
+	b2Body** bodies, int32 bodyCount,
+	b2Contact** contacts, int32 contactCount,
+	b2Joint** joints, int32 jointCount,
+	b2ContactImpulse* impulses, b2StackAllocator* allocator)
+{
+	m_bodyCapacity = bodyCount;
+	m_contactCapacity = contactCount;
+	m_jointCapacity = jointCount;
+	m_bodyCount = bodyCount;
+	m_contactCount = contactCount;
+	m_jointCount = jointCount;
+
+	m_allocator = allocator;
+	m_listener = NULL;
+
+	m_collected = true;
+	m_impulses = impulses;
+	m_sleep = false;
+
+	m_taskScheduler = NULL;
+	m_jointColorCount = 0;
+	m_jointColorStarts[0] = 0;
+
+	m_bodies = bodies;
+	m_contacts = contacts;
+	m_joints = joints;
+
+	m_velocities = (b2Velocity*)m_allocator->Allocate(m_bodyCapacity * sizeof(b2Velocity));
+	m_positions = (b2Position*)m_allocator->Allocate(m_bodyCapacity * sizeof(b2Position));
+}
+
 b2Island::~b2Island()
 {
 	// Warning: the order should reverse the constructor order.
 	m_allocator->Free(m_positions);
 	m_allocator->Free(m_velocities);
-	m_allocator->Free(m_joints);
-	m_allocator->Free(m_contacts);
-	m_allocator->Free(m_bodies);
+
+	if (m_collected == false)
+	{
+		m_allocator->Free(m_joints);
+		m_allocator->Free(m_contacts);
+		m_allocator->Free(m_bodies);
+	}
+}
+
+void b2Island::AssignIndices(int32 bodyStart, int32 contactStart, int32 jointStart)
+{
+	for (int32 i = contactStart; i < m_contactCount; ++i)
+	{
+		b2Contact* c = m_contacts[i];
+		c->m_indexA = c->GetFixtureA()->GetBody()->m_islandIndex - bodyStart;
+		c->m_indexB = c->GetFixtureB()->GetBody()->m_islandIndex - bodyStart;
+	}
+
+	for (int32 i = jointStart; i < m_jointCount; ++i)
+	{
+		b2Joint* j = m_joints[i];
+		j->m_indexA = j->m_bodyA->m_islandIndex - bodyStart;
+		j->m_indexB = j->m_bodyB->m_islandIndex - bodyStart;
+	}
 }
 
 void b2Island::Solve(const b2TimeStep& step, const b2Vec2& gravity, bool allowSleep)
 {
-	// Integrate velocities and apply damping.
+	m_sleep = false;
+
+	// Copy the body state into the solver arrays. Static bodies are copied
+	// too, so constraints never have to check the body type. The bodies are
+	// only written again once the island is solved.
 	for (int32 i = 0; i < m_bodyCount; ++i)
 	{
 		b2Body* b = m_bodies[i];
 
-		if (b->GetType() != b2_dynamicBody)
+		b2Vec2 c = b->m_sweep.c;
+		float32 a = b->m_sweep.a;
+		b2Vec2 v = b->m_linearVelocity;
+		float32 w = b->m_angularVelocity;
+
+		if (b->GetType() == b2_dynamicBody)
 		{
-			continue;
+			// Integrate velocities.
+			v += step.dt * (gravity + b->m_invMass * b->m_force);
+			w += step.dt * b->m_invI * b->m_torque;
+
+			// Apply damping.
+			// ODE: dv/dt + c * v = 0
+			// Solution: v(t) = v0 * exp(-c * t)
+			// Time step: v(t + dt) = v0 * exp(-c * (t + dt)) = v0 * exp(-c * t) * exp(-c * dt) = v * exp(-c * dt)
+			// v2 = exp(-c * dt) * v1
+			// Taylor expansion:
+			// v2 = (1.0f - c * dt) * v1
+			v *= b2Clamp(1.0f - step.dt * b->m_linearDamping, 0.0f, 1.0f);
+			w *= b2Clamp(1.0f - step.dt * b->m_angularDamping, 0.0f, 1.0f);
 		}
 
-		// Integrate velocities.
-		b->m_linearVelocity += step.dt * (gravity + b->m_invMass * b->m_force);
-		b->m_angularVelocity += step.dt * b->m_invI * b->m_torque;
-
-		// Apply damping.
-		// ODE: dv/dt + c * v = 0
-		// Solution: v(t) = v0 * exp(-c * t)
-		// Time step: v(t + dt) = v0 * exp(-c * (t + dt)) = v0 * exp(-c * t) * exp(-c * dt) = v * exp(-c * dt)
-		// v2 = exp(-c * dt) * v1
-		// Taylor expansion:
-		// v2 = (1.0f - c * dt) * v1
-		b->m_linearVelocity *= b2Clamp(1.0f - step.dt * b->m_linearDamping, 0.0f, 1.0f);
-		b->m_angularVelocity *= b2Clamp(1.0f - step.dt * b->m_angularDamping, 0.0f, 1.0f);
+		m_positions[i].c = c;
+		m_positions[i].a = a;
+		m_velocities[i].v = v;
+		m_velocities[i].w = w;
 	}
 
 	// Partition contacts so that contacts with static bodies are solved last.
@@ -221,22 +496,24 @@ void b2Island::Solve(const b2TimeStep& step, const b2Vec2& gravity, bool allowSl
 		}
 	}
 
+	ColorJoints();
+
+	b2SolverData solverData;
+	solverData.step = step;
+	solverData.positions = m_positions;
+	solverData.velocities = m_velocities;
+
 	// Initialize velocity constraints.
-	b2ContactSolver contactSolver(m_contacts, m_contactCount, m_allocator, step.dtRatio);
+	b2ContactSolver contactSolver(m_contacts, m_contactCount, m_positions, m_velocities,
+								  m_allocator, step.dtRatio, step.wideContactSolving);
+	contactSolver.m_taskScheduler = m_taskScheduler;
 	contactSolver.WarmStart();
-	for (int32 i = 0; i < m_jointCount; ++i)
-	{
-		m_joints[i]->InitVelocityConstraints(step);
-	}
+	SolveJoints(e_initVelocityPass, solverData);
 
 	// Solve velocity constraints.
 	for (int32 i = 0; i < step.velocityIterations; ++i)
 	{
-		for (int32 j = 0; j < m_jointCount; ++j)
-		{
-			m_joints[j]->SolveVelocityConstraints(step);
-		}
-
+		SolveJoints(e_velocityPass, solverData);
 		contactSolver.SolveVelocityConstraints();
 	}
 
@@ -246,40 +523,39 @@ void b2Island::Solve(const b2TimeStep& step, const b2Vec2& gravity, bool allowSl
 	// Integrate positions.
 	for (int32 i = 0; i < m_bodyCount; ++i)
 	{
-		b2Body* b = m_bodies[i];
-
-		if (b->GetType() == b2_staticBody)
+		if (m_bodies[i]->GetType() == b2_staticBody)
 		{
 			continue;
 		}
 
+		b2Vec2 c = m_positions[i].c;
+		float32 a = m_positions[i].a;
+		b2Vec2 v = m_velocities[i].v;
+		float32 w = m_velocities[i].w;
+
 		// Check for large velocities.
-		b2Vec2 translation = step.dt * b->m_linearVelocity;
+		b2Vec2 translation = step.dt * v;
 		if (b2Dot(translation, translation) > b2_maxTranslationSquared)
 		{
 			float32 ratio = b2_maxTranslation / translation.Length();
-			b->m_linearVelocity *= ratio;
+			v *= ratio;
 		}
 
-		float32 rotation = step.dt * b->m_angularVelocity;
+		float32 rotation = step.dt * w;
 		if (rotation * rotation > b2_maxRotationSquared)
 		{
 			float32 ratio = b2_maxRotation / b2Abs(rotation);
-			b->m_angularVelocity *= ratio;
+			w *= ratio;
 		}
 
-		// Store positions for continuous collision.
-		b->m_sweep.c0 = b->m_sweep.c;
-		b->m_sweep.a0 = b->m_sweep.a;
-
 		// Integrate
-		b->m_sweep.c += step.dt * b->m_linearVelocity;
-		b->m_sweep.a += step.dt * b->m_angularVelocity;
+		c += step.dt * v;
+		a += step.dt * w;
 
-		// Compute new transform
-		b->SynchronizeTransform();
-
-		// Note: shapes are synchronized later.
+		m_positions[i].c = c;
+		m_positions[i].a = a;
+		m_velocities[i].v = v;
+		m_velocities[i].w = w;
 	}
 
 	// Iterate over constraints.
@@ -287,12 +563,7 @@ void b2Island::Solve(const b2TimeStep& step, const b2Vec2& gravity, bool allowSl
 	{
 		bool contactsOkay = contactSolver.SolvePositionConstraints(b2_contactBaumgarte);
 
-		bool jointsOkay = true;
-		for (int32 i = 0; i < m_jointCount; ++i)
-		{
-			bool jointOkay = m_joints[i]->SolvePositionConstraints(b2_contactBaumgarte);
-			jointsOkay = jointsOkay && jointOkay;
-		}
+		bool jointsOkay = SolveJoints(e_positionPass, solverData);
 
 		if (contactsOkay && jointsOkay)
 		{
@@ -301,6 +572,31 @@ void b2Island::Solve(const b2TimeStep& step, const b2Vec2& gravity, bool allowSl
 		}
 	}
 
+	// Copy the state back to the bodies.
+	for (int32 i = 0; i < m_bodyCount; ++i)
+	{
+		b2Body* b = m_bodies[i];
+
+		if (b->GetType() == b2_staticBody)
+		{
+			continue;
+		}
+
+		// Store positions for continuous collision.
+		b->m_sweep.c0 = b->m_sweep.c;
+		b->m_sweep.a0 = b->m_sweep.a;
+
+		b->m_sweep.c = m_positions[i].c;
+		b->m_sweep.a = m_positions[i].a;
+		b->m_linearVelocity = m_velocities[i].v;
+		b->m_angularVelocity = m_velocities[i].w;
+
+		// Compute new transform
+		b->SynchronizeTransform();
+
+		// Note: shapes are synchronized later.
+	}
+
 	Report(contactSolver.m_constraints);
 
 	if (allowSleep)
@@ -340,18 +636,177 @@ void b2Island::Solve(const b2TimeStep& step, const b2Vec2& gravity, bool allowSl
 
 		if (minSleepTime >= b2_timeToSleep)
 		{
-			for (int32 i = 0; i < m_bodyCount; ++i)
+			m_sleep = true;
+		}
+	}
+}
+
+// Sort the joints of a large island into colors using greedy graph coloring:
+// a joint gets the first color that neither of its bodies has yet. Unlike the
+// contact solver, static and kinematic bodies take part, because joints store
+// back the state of both bodies. The order within a color is the island order.
+void b2Island::ColorJoints()
+{
+	m_jointColorCount = 0;
+	m_jointColorStarts[0] = 0;
+
+	if (IsLarge(m_contactCount, m_jointCount) == false)
+	{
+		return;
+	}
+
+	// The pointers go first, the stack allocator doesn't align.
+	b2Joint** sorted = (b2Joint**)m_allocator->Allocate(m_jointCount * sizeof(b2Joint*));
+	int32* colors = (int32*)m_allocator->Allocate(m_jointCount * sizeof(int32));
+	uint32* bodyColors = (uint32*)m_allocator->Allocate(m_bodyCount * sizeof(uint32));
+	memset(bodyColors, 0, m_bodyCount * sizeof(uint32));
+
+	// The last count is for the joints without a color.
+	int32 colorCounts[e_maxJointColors + 1];
+	memset(colorCounts, 0, sizeof(colorCounts));
+
+	for (int32 i = 0; i < m_jointCount; ++i)
+	{
+		b2Joint* joint = m_joints[i];
+		uint32 used = bodyColors[joint->m_indexA] | bodyColors[joint->m_indexB];
+
+		int32 color = 0;
+		while (color < e_maxJointColors && (used & (1u << color)))
+		{
+			++color;
+		}
+
+		colors[i] = color;
+		++colorCounts[color];
+
+		if (color < e_maxJointColors)
+		{
+			m_jointColorCount = b2Max(m_jointColorCount, color + 1);
+			bodyColors[joint->m_indexA] |= 1u << color;
+			bodyColors[joint->m_indexB] |= 1u << color;
+		}
+	}
+
+	int32 starts[e_maxJointColors + 1];
+	starts[0] = 0;
+	for (int32 i = 0; i < e_maxJointColors; ++i)
+	{
+		starts[i + 1] = starts[i] + colorCounts[i];
+	}
+
+	for (int32 i = 0; i <= m_jointColorCount; ++i)
+	{
+		m_jointColorStarts[i] = starts[i];
+	}
+
+	for (int32 i = 0; i < m_jointCount; ++i)
+	{
+		sorted[starts[colors[i]]++] = m_joints[i];
+	}
+	memcpy(m_joints, sorted, m_jointCount * sizeof(b2Joint*));
+
+	m_allocator->Free(bodyColors);
+	m_allocator->Free(colors);
+	m_allocator->Free(sorted);
+}
+
+// Runs a joint pass over some of the joints of one color.
+class b2SolveJointsTask : public b2Task
+{
+public:
+	void Execute(int32 begin, int32 end, int32 threadIndex)
+	{
+		bool okay = m_island->SolveJoints(m_pass, *m_data, m_start + begin, m_start + end);
+		if (okay == false)
+		{
+			m_okay[threadIndex] = 0;
+		}
+	}
+
+	b2Island* m_island;
+	b2Island::JointPass m_pass;
+	const b2SolverData* m_data;
+	int32 m_start;
+	int32* m_okay;
+};
+
+// Solve the joint colors one after another, then the joints without a color.
+// The joints of a color share no body, so they can be solved on several
+// threads at the same time without changing the result. Returns false if the
+// position pass left a large error.
+bool b2Island::SolveJoints(JointPass pass, const b2SolverData& data)
+{
+	int32 threadCount = m_taskScheduler ? b2Max(m_taskScheduler->GetThreadCount(), 1) : 1;
+	int32* okay = (int32*)m_allocator->Allocate(threadCount * sizeof(int32));
+	for (int32 i = 0; i < threadCount; ++i)
+	{
+		okay[i] = 1;
+	}
+
+	b2SolveJointsTask task;
+	task.m_island = this;
+	task.m_pass = pass;
+	task.m_data = &data;
+	task.m_okay = okay;
+
+	for (int32 i = 0; i < m_jointColorCount; ++i)
+	{
+		task.m_start = m_jointColorStarts[i];
+		int32 count = m_jointColorStarts[i + 1] - m_jointColorStarts[i];
+		if (m_taskScheduler && count > e_minParallelJoints)
+		{
+			m_taskScheduler->ParallelFor(&task, count, e_minParallelJoints);
+		}
+		else
+		{
+			task.Execute(0, count, 0);
+		}
+	}
+
+	task.m_start = m_jointColorStarts[m_jointColorCount];
+	task.Execute(0, m_jointCount - task.m_start, 0);
+
+	bool allOkay = true;
+	for (int32 i = 0; i < threadCount; ++i)
+	{
+		allOkay = allOkay && okay[i] != 0;
+	}
+
+	m_allocator->Free(okay);
+	return allOkay;
+}
+
+bool b2Island::SolveJoints(JointPass pass, const b2SolverData& data, int32 begin, int32 end)
+{
+	bool okay = true;
+	for (int32 i = begin; i < end; ++i)
+	{
+		b2Joint* joint = m_joints[i];
+		switch (pass)
+		{
+		case e_initVelocityPass:
+			joint->InitVelocityConstraints(data);
+			break;
+
+		case e_velocityPass:
+			joint->SolveVelocityConstraints(data);
+			break;
+
+		case e_positionPass:
 			{
-				b2Body* b = m_bodies[i];
-				b->SetAwake(false);
+				bool jointOkay = joint->SolvePositionConstraints(data);
+				okay = okay && jointOkay;
 			}
+			break;
 		}
 	}
+
+	return okay;
 }
 
 void b2Island::Report(const b2ContactConstraint* constraints)
 {
-	if (m_listener == NULL)
+	if (m_listener == NULL && m_collected == false)
 	{
 		return;
 	}
@@ -362,13 +817,19 @@ void b2Island::Report(const b2ContactConstraint* constraints)
 
 		const b2ContactConstraint* cc = constraints + i;
 		
-		b2ContactImpulse impulse;
-		for (int32 j = 0; j < cc->pointCount; ++j)
+		b2ContactImpulse local;
+		b2ContactImpulse& impulse = m_collected ? m_impulses[i] : local;
+		for (int32 j = 0; j < b2_maxManifoldPoints; ++j)
 		{
-			impulse.normalImpulses[j] = cc->points[j].normalImpulse;
-			impulse.tangentImpulses[j] = cc->points[j].tangentImpulse;
+			// The block solver may have dropped a manifold point.
+			bool solved = j < cc->pointCount;
+			impulse.normalImpulses[j] = solved ? cc->points[j].normalImpulse : 0.0f;
+			impulse.tangentImpulses[j] = solved ? cc->points[j].tangentImpulse : 0.0f;
 		}
 
-		m_listener->PostSolve(c, &impulse);
+		if (m_collected == false)
+		{
+			m_listener->PostSolve(c, &impulse);
+		}
 	}
 }
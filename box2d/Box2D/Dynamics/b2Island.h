@@ -27,28 +27,92 @@ class b2Contact;
 class b2Joint;
 class b2StackAllocator;
 class b2ContactListener;
+class b2TaskScheduler;
 struct b2ContactConstraint;
+struct b2ContactImpulse;
 
+/// An island that lasts from one time step to the next, owned by the world.
+/// It holds the non-static bodies that can affect each other and the touching
+/// contacts and joints between them. Islands are merged as soon as a contact
+/// or joint connects them, but they are only split again when the world gets
+/// to it, so an island may hold bodies that are no longer connected.
 /// This is an internal structure.
-struct b2Position
+struct b2PersistentIsland
 {
-	b2Vec2 x;
-	float32 a;
-};
-
-/// This is an internal structure.
-struct b2Velocity
-{
-	b2Vec2 v;
-	float32 w;
+	void Clear();
+
+	// Append to the lists. This sets the island of a body and the island flag
+	// of a contact or joint.
+	void Add(b2Body* body);
+	void Add(b2Contact* contact);
+	void Add(b2Joint* joint);
+
+	void Remove(b2Body* body);
+	void Remove(b2Contact* contact);
+	void Remove(b2Joint* joint);
+
+	// Move the bodies, contacts and joints of another island to the end of
+	// this one. The other island is left empty.
+	void Merge(b2PersistentIsland* other);
+
+	// The world's list of awake islands.
+	b2PersistentIsland* prev;
+	b2PersistentIsland* next;
+	bool awake;
+
+	b2Body* bodyList;
+	b2Body* bodyTail;
+	b2Contact* contactList;
+	b2Contact* contactTail;
+	b2Joint* jointList;
+	b2Joint* jointTail;
+
+	int32 bodyCount;
+
+	// The number of contacts and joints removed since the island was last
+	// split.
+	int32 constraintRemoveCount;
 };
 
 /// This is an internal class.
 class b2Island
 {
 public:
+	enum
+	{
+		// Islands with at least this many constraints are large. Their joints
+		// are solved color by color, like the contacts, so that each color can
+		// be spread over the threads of a task scheduler.
+		e_minLargeConstraints = 256,
+
+		// Joint coloring gives up beyond this many colors. The remaining
+		// joints are solved one by one.
+		e_maxJointColors = 32,
+
+		// With a task scheduler, a color is split into ranges of at least this
+		// many joints.
+		e_minParallelJoints = 16
+	};
+
+	enum JointPass
+	{
+		e_initVelocityPass,
+		e_velocityPass,
+		e_positionPass
+	};
+
 	b2Island(int32 bodyCapacity, int32 contactCapacity, int32 jointCapacity,
 			b2StackAllocator* allocator, b2ContactListener* listener);
+
+	/// Wrap an island that was collected in advance, for solving it on a worker
+	/// thread. The arrays are used in place. Instead of reporting to the
+	/// contact listener, the island stores the contact impulses in the given
+	/// array, so that this can be done later on the calling thread.
+	b2Island(b2Body** bodies, int32 bodyCount,
+			b2Contact** contacts, int32 contactCount,
+			b2Joint** joints, int32 jointCount,
+			b2ContactImpulse* impulses, b2StackAllocator* allocator);
+
 	~b2Island();
 
 	void Clear()
@@ -60,6 +124,12 @@ public:
 
 	void Solve(const b2TimeStep& step, const b2Vec2& gravity, bool allowSleep);
 
+	/// Store the island indices of the bodies in the contacts and joints added
+	/// since the given starts. This must be called while the body island
+	/// indices are still valid, because static bodies can be added to several
+	/// islands. The indices are relative to bodyStart.
+	void AssignIndices(int32 bodyStart, int32 contactStart, int32 jointStart);
+
 	void Add(b2Body* body)
 	{
 		b2Assert(m_bodyCount < m_bodyCapacity);
@@ -81,9 +151,33 @@ public:
 
 	void Report(const b2ContactConstraint* constraints);
 
+	static bool IsLarge(int32 contactCount, int32 jointCount)
+	{
+		return contactCount + jointCount >= e_minLargeConstraints;
+	}
+
+	void ColorJoints();
+	bool SolveJoints(JointPass pass, const b2SolverData& data);
+	bool SolveJoints(JointPass pass, const b2SolverData& data, int32 begin, int32 end);
+
 	b2StackAllocator* m_allocator;
 	b2ContactListener* m_listener;
 
+	// Set to solve the colors of a large island on several threads.
+	b2TaskScheduler* m_taskScheduler;
+
+	// Joints sorted by color, followed by the ones that are solved one by one.
+	int32 m_jointColorCount;
+	int32 m_jointColorStarts[e_maxJointColors + 1];
+
+	// Only used by islands collected in advance.
+	bool m_collected;
+	b2ContactImpulse* m_impulses;
+
+	// Set by Solve when the bodies can fall asleep. The world puts them to
+	// sleep, because static bodies are shared with other islands.
+	bool m_sleep;
+
 	b2Body** m_bodies;
 	b2Contact** m_contacts;
 	b2Joint** m_joints;
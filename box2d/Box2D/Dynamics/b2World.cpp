@@ -36,14 +36,25 @@ b2World::b2World(const b2Vec2& gravity, bool doSleep)
 	m_destructionListener = NULL;
 	m_debugDraw = NULL;
 
+	m_taskScheduler = NULL;
+	m_threadCount = 0;
+	m_threadAllocators = NULL;
+
 	m_bodyList = NULL;
 	m_jointList = NULL;
 
 	m_bodyCount = 0;
 	m_jointCount = 0;
 
+	m_awakeIslandList = NULL;
+
+	m_solvedBodies = NULL;
+	m_solvedBodyCount = 0;
+	m_solvedBodyCapacity = 0;
+
 	m_warmStarting = true;
 	m_continuousPhysics = true;
+	m_wideContactSolving = true;
 
 	m_allowSleep = doSleep;
 	m_gravity = gravity;
@@ -57,6 +68,129 @@ b2World::b2World(const b2Vec2& gravity, bool doSleep)
 
 b2World::~b2World()
 {
+	SetTaskScheduler(NULL);
+	b2Free(m_solvedBodies);
+}
+
+void b2World::SetTaskScheduler(b2TaskScheduler* scheduler)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return;
+	}
+
+	for (int32 i = 0; i < m_threadCount; ++i)
+	{
+		m_threadAllocators[i].~b2StackAllocator();
+	}
+	b2Free(m_threadAllocators);
+
+	m_taskScheduler = scheduler;
+	m_contactManager.m_taskScheduler = scheduler;
+	m_contactManager.m_broadPhase->SetTaskScheduler(scheduler);
+	m_threadCount = 0;
+	m_threadAllocators = NULL;
+
+	if (scheduler == NULL)
+	{
+		return;
+	}
+
+	// Each thread gets its own scratch memory for solving islands.
+	m_threadCount = b2Max(scheduler->GetThreadCount(), 1);
+	m_threadAllocators = (b2StackAllocator*)b2Alloc(m_threadCount * sizeof(b2StackAllocator));
+	for (int32 i = 0; i < m_threadCount; ++i)
+	{
+		new (m_threadAllocators + i) b2StackAllocator;
+	}
+}
+
+void b2World::SetBroadPhase(b2BroadPhaseType type, float32 cellSize)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return;
+	}
+
+	b2BroadPhase* oldBroadPhase = m_contactManager.m_broadPhase;
+	b2BroadPhase* broadPhase = b2BroadPhase::Create(type, cellSize);
+	broadPhase->SetTaskScheduler(m_taskScheduler);
+
+	// Contacts refer to fixtures, so they survive the new proxy ids.
+	broadPhase->BeginBatch();
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		if ((b->m_flags & b2Body::e_activeFlag) == 0)
+		{
+			continue;
+		}
+
+		for (b2Fixture* f = b->m_fixtureList; f; f = f->m_next)
+		{
+			f->DestroyProxy(oldBroadPhase);
+			f->CreateProxy(broadPhase, b->m_xf);
+		}
+	}
+	broadPhase->EndBatch();
+
+	m_contactManager.m_broadPhase = broadPhase;
+	b2BroadPhase::Destroy(oldBroadPhase);
+
+	// The new proxies find their pairs at the start of the next time step.
+	m_flags |= e_newFixture;
+}
+
+void b2World::BeginFixtureBatch()
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return;
+	}
+
+	m_contactManager.m_broadPhase->BeginBatch();
+}
+
+void b2World::EndFixtureBatch()
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return;
+	}
+
+	m_contactManager.m_broadPhase->EndBatch();
+}
+
+void b2World::ShiftOrigin(const b2Vec2& newOrigin)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return;
+	}
+
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		b->m_xf.position -= newOrigin;
+		b->m_sweep.c0 -= newOrigin;
+		b->m_sweep.c -= newOrigin;
+
+		for (b2Fixture* f = b->m_fixtureList; f; f = f->m_next)
+		{
+			f->m_aabb.lowerBound -= newOrigin;
+			f->m_aabb.upperBound -= newOrigin;
+		}
+	}
+
+	for (b2Joint* j = m_jointList; j; j = j->m_next)
+	{
+		j->ShiftOrigin(newOrigin);
+	}
+
+	m_contactManager.m_broadPhase->ShiftOrigin(newOrigin);
 }
 
 void b2World::SetDestructionListener(b2DestructionListener* listener)
@@ -100,6 +234,11 @@ b2Body* b2World::CreateBody(const b2BodyDef* def)
 	m_bodyList = b;
 	++m_bodyCount;
 
+	if (b->m_type != b2_staticBody && b->IsActive())
+	{
+		LinkBody(b);
+	}
+
 	return b;
 }
 
@@ -138,6 +277,8 @@ void b2World::DestroyBody(b2Body* b)
 	}
 	b->m_contactList = NULL;
 
+	UnlinkBody(b);
+
 	// Delete the attached fixtures. This destroys broad-phase proxies.
 	b2Fixture* f = b->m_fixtureList;
 	while (f)
@@ -150,7 +291,7 @@ void b2World::DestroyBody(b2Body* b)
 			m_destructionListener->SayGoodbye(f0);
 		}
 
-		f0->DestroyProxy(&m_contactManager.m_broadPhase);
+		f0->DestroyProxy(m_contactManager.m_broadPhase);
 		f0->Destroy(&m_blockAllocator);
 		f0->~b2Fixture();
 		m_blockAllocator.Free(f0, sizeof(b2Fixture));
@@ -214,6 +355,8 @@ b2Joint* b2World::CreateJoint(const b2JointDef* def)
 	if (j->m_bodyB->m_jointList) j->m_bodyB->m_jointList->prev = &j->m_edgeB;
 	j->m_bodyB->m_jointList = &j->m_edgeB;
 
+	LinkJoint(j);
+
 	b2Body* bodyA = def->bodyA;
 	b2Body* bodyB = def->bodyB;
 
@@ -269,6 +412,11 @@ void b2World::DestroyJoint(b2Joint* j)
 	b2Body* bodyA = j->m_bodyA;
 	b2Body* bodyB = j->m_bodyB;
 
+	if (j->m_islandFlag)
+	{
+		UnlinkJoint(j);
+	}
+
 	// Wake up connected bodies.
 	bodyA->SetAwake(true);
 	bodyB->SetAwake(true);
@@ -334,82 +482,555 @@ void b2World::DestroyJoint(b2Joint* j)
 	}
 }
 
-// Find islands, integrate and solve constraints, solve position constraints
-void b2World::Solve(const b2TimeStep& step)
+void b2World::LinkBody(b2Body* body)
 {
-	// Size the island for the worst case.
-	b2Island island(m_bodyCount,
-					m_contactManager.m_contactCount,
-					m_jointCount,
-					&m_stackAllocator,
-					m_contactManager.m_contactListener);
+	b2Assert(body->m_island == NULL);
 
-	// Clear all the island flags.
-	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	b2PersistentIsland* island = CreateIsland();
+	island->Add(body);
+	if (body->IsAwake())
 	{
-		b->m_flags &= ~b2Body::e_islandFlag;
+		WakeIsland(island);
 	}
-	for (b2Contact* c = m_contactManager.m_contactList; c; c = c->m_next)
+
+	// Contacts are linked when they are updated.
+	for (b2JointEdge* je = body->m_jointList; je; je = je->next)
 	{
-		c->m_flags &= ~b2Contact::e_islandFlag;
+		LinkJoint(je->joint);
 	}
-	for (b2Joint* j = m_jointList; j; j = j->m_next)
+}
+
+void b2World::UnlinkBody(b2Body* body)
+{
+	b2PersistentIsland* island = body->m_island;
+	if (island == NULL)
 	{
-		j->m_islandFlag = false;
+		return;
 	}
 
-	// Build and simulate all awake islands.
-	int32 stackSize = m_bodyCount;
-	b2Body** stack = (b2Body**)m_stackAllocator.Allocate(stackSize * sizeof(b2Body*));
-	for (b2Body* seed = m_bodyList; seed; seed = seed->m_next)
+	for (b2ContactEdge* ce = body->m_contactList; ce; ce = ce->next)
 	{
-		if (seed->m_flags & b2Body::e_islandFlag)
+		if (ce->contact->m_flags & b2Contact::e_islandFlag)
 		{
-			continue;
+			UnlinkContact(ce->contact);
 		}
+	}
 
-		if (seed->IsAwake() == false || seed->IsActive() == false)
+	for (b2JointEdge* je = body->m_jointList; je; je = je->next)
+	{
+		if (je->joint->m_islandFlag)
 		{
-			continue;
+			UnlinkJoint(je->joint);
 		}
+	}
+
+	island->Remove(body);
+	if (island->bodyCount == 0)
+	{
+		DestroyIsland(island);
+	}
+
+	for (b2ContactEdge* ce = body->m_contactList; ce; ce = ce->next)
+	{
+		m_contactManager.SynchronizeAwake(ce->contact);
+	}
+}
+
+void b2World::LinkContact(b2Contact* contact)
+{
+	b2Assert((contact->m_flags & b2Contact::e_islandFlag) == 0);
 
-		// The seed can be dynamic or kinematic.
-		if (seed->GetType() == b2_staticBody)
+	// Static bodies don't connect islands.
+	b2PersistentIsland* islandA = contact->m_fixtureA->m_body->m_island;
+	b2PersistentIsland* islandB = contact->m_fixtureB->m_body->m_island;
+	if (islandA == NULL || islandB == NULL)
+	{
+		return;
+	}
+
+	b2PersistentIsland* island = MergeIslands(islandA, islandB);
+	island->Add(contact);
+}
+
+void b2World::UnlinkContact(b2Contact* contact)
+{
+	b2PersistentIsland* island = contact->m_fixtureA->m_body->m_island;
+	island->Remove(contact);
+
+	// The island may have come apart.
+	++island->constraintRemoveCount;
+}
+
+void b2World::LinkJoint(b2Joint* joint)
+{
+	b2Assert(joint->m_islandFlag == false);
+
+	// Static and inactive bodies don't connect islands.
+	b2PersistentIsland* islandA = joint->m_bodyA->m_island;
+	b2PersistentIsland* islandB = joint->m_bodyB->m_island;
+	if (islandA == NULL || islandB == NULL)
+	{
+		return;
+	}
+
+	b2PersistentIsland* island = MergeIslands(islandA, islandB);
+	island->Add(joint);
+}
+
+void b2World::UnlinkJoint(b2Joint* joint)
+{
+	b2PersistentIsland* island = joint->m_bodyA->m_island;
+	island->Remove(joint);
+
+	// The island may have come apart.
+	++island->constraintRemoveCount;
+}
+
+b2PersistentIsland* b2World::CreateIsland()
+{
+	void* mem = m_blockAllocator.Allocate(sizeof(b2PersistentIsland));
+	b2PersistentIsland* island = (b2PersistentIsland*)mem;
+	island->prev = NULL;
+	island->next = NULL;
+	island->awake = false;
+	island->Clear();
+	return island;
+}
+
+void b2World::DestroyIsland(b2PersistentIsland* island)
+{
+	b2Assert(island->bodyCount == 0);
+	SleepIsland(island);
+	m_blockAllocator.Free(island, sizeof(b2PersistentIsland));
+}
+
+void b2World::WakeIsland(b2PersistentIsland* island)
+{
+	if (island->awake)
+	{
+		return;
+	}
+
+	island->awake = true;
+	island->prev = NULL;
+	island->next = m_awakeIslandList;
+	if (m_awakeIslandList)
+	{
+		m_awakeIslandList->prev = island;
+	}
+	m_awakeIslandList = island;
+
+	SynchronizeContacts(island->bodyList);
+}
+
+void b2World::SleepIsland(b2PersistentIsland* island)
+{
+	if (island->awake == false)
+	{
+		return;
+	}
+
+	if (island->prev)
+	{
+		island->prev->next = island->next;
+	}
+
+	if (island->next)
+	{
+		island->next->prev = island->prev;
+	}
+
+	if (island == m_awakeIslandList)
+	{
+		m_awakeIslandList = island->next;
+	}
+
+	island->awake = false;
+	island->prev = NULL;
+	island->next = NULL;
+
+	SynchronizeContacts(island->bodyList);
+}
+
+// Update the awake contacts after the island of some bodies fell asleep or
+// woke up. The bodies are given from the first one in an island body list.
+void b2World::SynchronizeContacts(b2Body* bodyList)
+{
+	for (b2Body* b = bodyList; b; b = b->m_islandNext)
+	{
+		for (b2ContactEdge* ce = b->m_contactList; ce; ce = ce->next)
+		{
+			m_contactManager.SynchronizeAwake(ce->contact);
+		}
+	}
+}
+
+b2PersistentIsland* b2World::MergeIslands(b2PersistentIsland* islandA, b2PersistentIsland* islandB)
+{
+	if (islandA == islandB)
+	{
+		return islandA;
+	}
+
+	// Move the smaller island into the larger one.
+	if (islandA->bodyCount < islandB->bodyCount)
+	{
+		b2Swap(islandA, islandB);
+	}
+
+	bool awakeA = islandA->awake;
+	bool awakeB = islandB->awake;
+	b2Body* bodyListB = islandB->bodyList;
+	islandA->Merge(islandB);
+	DestroyIsland(islandB);
+
+	// The bodies of a sleeping island are woken up when the island is solved.
+	if (awakeB && awakeA == false)
+	{
+		WakeIsland(islandA);
+	}
+	else if (awakeA && awakeB == false)
+	{
+		SynchronizeContacts(bodyListB);
+	}
+
+	return islandA;
+}
+
+// Rebuild the island from the connected groups of its bodies. The first group
+// stays in the island, the others get new islands. All the groups are awake.
+void b2World::SplitIsland(b2PersistentIsland* island)
+{
+	int32 bodyCount = island->bodyCount;
+	b2Body** bodies = (b2Body**)m_stackAllocator.Allocate(bodyCount * sizeof(b2Body*));
+	b2Body** stack = (b2Body**)m_stackAllocator.Allocate(bodyCount * sizeof(b2Body*));
+
+	int32 index = 0;
+	for (b2Body* b = island->bodyList; b; b = b->m_islandNext)
+	{
+		bodies[index++] = b;
+	}
+	b2Assert(index == bodyCount);
+
+	island->Clear();
+
+	b2PersistentIsland* target = island;
+	for (int32 i = 0; i < bodyCount; ++i)
+	{
+		b2Body* seed = bodies[i];
+		if (seed->m_flags & b2Body::e_islandFlag)
 		{
 			continue;
 		}
 
-		// Reset island and stack.
-		island.Clear();
+		if (target == NULL)
+		{
+			target = CreateIsland();
+			WakeIsland(target);
+		}
+
 		int32 stackCount = 0;
 		stack[stackCount++] = seed;
 		seed->m_flags |= b2Body::e_islandFlag;
 
-		// Perform a depth first search (DFS) on the constraint graph.
+		// Perform a depth first search (DFS) on the linked constraints.
 		while (stackCount > 0)
 		{
-			// Grab the next body off the stack and add it to the island.
 			b2Body* b = stack[--stackCount];
-			b2Assert(b->IsActive() == true);
-			island.Add(b);
+			target->Add(b);
 
-			// Make sure the body is awake.
+			for (b2ContactEdge* ce = b->m_contactList; ce; ce = ce->next)
+			{
+				b2Contact* contact = ce->contact;
+				if ((contact->m_flags & b2Contact::e_islandFlag) == 0)
+				{
+					continue;
+				}
+
+				// Both bodies are visited, add the contact only once.
+				if (contact->m_fixtureA->m_body == b)
+				{
+					target->Add(contact);
+				}
+
+				b2Body* other = ce->other;
+				if (other->m_flags & b2Body::e_islandFlag)
+				{
+					continue;
+				}
+
+				b2Assert(stackCount < bodyCount);
+				stack[stackCount++] = other;
+				other->m_flags |= b2Body::e_islandFlag;
+			}
+
+			for (b2JointEdge* je = b->m_jointList; je; je = je->next)
+			{
+				b2Joint* joint = je->joint;
+				if (joint->m_islandFlag == false)
+				{
+					continue;
+				}
+
+				if (joint->m_bodyA == b)
+				{
+					target->Add(joint);
+				}
+
+				b2Body* other = je->other;
+				if (other->m_flags & b2Body::e_islandFlag)
+				{
+					continue;
+				}
+
+				b2Assert(stackCount < bodyCount);
+				stack[stackCount++] = other;
+				other->m_flags |= b2Body::e_islandFlag;
+			}
+		}
+
+		target = NULL;
+	}
+
+	for (int32 i = 0; i < bodyCount; ++i)
+	{
+		bodies[i]->m_flags &= ~b2Body::e_islandFlag;
+	}
+
+	m_stackAllocator.Free(stack);
+	m_stackAllocator.Free(bodies);
+}
+
+// Put the bodies of a solved island to sleep, in the order the islands were
+// solved. An island that has lost constraints is split instead, the parts can
+// fall asleep on the next step.
+void b2World::FinishIsland(b2PersistentIsland* island, b2Body** bodies, int32 bodyCount, bool sleep)
+{
+	if (sleep && island->constraintRemoveCount > 0)
+	{
+		SplitIsland(island);
+		sleep = false;
+	}
+
+	for (int32 i = 0; i < bodyCount; ++i)
+	{
+		b2Body* b = bodies[i];
+		if (sleep)
+		{
+			b->SetAwake(false);
+		}
+		else if (b->GetType() == b2_staticBody)
+		{
+			// An earlier island may have put this to sleep.
 			b->SetAwake(true);
+		}
+	}
 
-			// To keep islands as small as possible, we don't
-			// propagate islands across static bodies.
-			if (b->GetType() == b2_staticBody)
+	if (sleep)
+	{
+		SleepIsland(island);
+	}
+}
+
+// Find islands, integrate and solve constraints, solve position constraints
+// An island within the island collected by b2World::Solve.
+struct b2IslandRange
+{
+	b2PersistentIsland* island;
+	int32 bodyStart, bodyCount;
+	int32 contactStart, contactCount;
+	int32 jointStart, jointCount;
+	bool sleep;
+};
+
+// Solves collected islands, each worker thread uses its own stack allocator.
+class b2SolveIslandsTask : public b2Task
+{
+public:
+	void Execute(int32 begin, int32 end, int32 threadIndex)
+	{
+		for (int32 i = begin; i < end; ++i)
+		{
+			b2IslandRange* range = m_ranges + i;
+			if (b2Island::IsLarge(range->contactCount, range->jointCount))
 			{
 				continue;
 			}
 
-			// Search all contacts connected to this body.
+			b2Island island(m_island->m_bodies + range->bodyStart, range->bodyCount,
+							m_island->m_contacts + range->contactStart, range->contactCount,
+							m_island->m_joints + range->jointStart, range->jointCount,
+							m_impulses + range->contactStart, m_allocators + threadIndex);
+			island.Solve(*m_step, m_gravity, m_allowSleep);
+			range->sleep = island.m_sleep;
+		}
+	}
+
+	const b2TimeStep* m_step;
+	b2Vec2 m_gravity;
+	bool m_allowSleep;
+	const b2Island* m_island;
+	b2IslandRange* m_ranges;
+	b2ContactImpulse* m_impulses;
+	b2StackAllocator* m_allocators;
+};
+
+void b2World::SolveIslands(const b2TimeStep& step, const b2Island* island,
+						   b2IslandRange* ranges, int32 count)
+{
+	b2ContactImpulse* impulses = (b2ContactImpulse*)m_stackAllocator.Allocate(
+		island->m_contactCount * sizeof(b2ContactImpulse));
+
+	b2SolveIslandsTask task;
+	task.m_step = &step;
+	task.m_gravity = m_gravity;
+	task.m_allowSleep = m_allowSleep;
+	task.m_island = island;
+	task.m_ranges = ranges;
+	task.m_impulses = impulses;
+	task.m_allocators = m_threadAllocators;
+	m_taskScheduler->ParallelFor(&task, count, 1);
+
+	// Large islands are solved one at a time, spreading the constraints of
+	// each island over the threads instead.
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2IslandRange* range = ranges + i;
+		if (b2Island::IsLarge(range->contactCount, range->jointCount) == false)
+		{
+			continue;
+		}
+
+		b2Island large(island->m_bodies + range->bodyStart, range->bodyCount,
+					   island->m_contacts + range->contactStart, range->contactCount,
+					   island->m_joints + range->jointStart, range->jointCount,
+					   impulses + range->contactStart, &m_stackAllocator);
+		large.m_taskScheduler = m_taskScheduler;
+		large.Solve(step, m_gravity, m_allowSleep);
+		range->sleep = large.m_sleep;
+	}
+
+	// Report and put islands to sleep in the order they would have been
+	// solved on a single thread.
+	b2ContactListener* listener = m_contactManager.m_contactListener;
+	for (int32 i = 0; i < count; ++i)
+	{
+		const b2IslandRange* range = ranges + i;
+
+		if (listener)
+		{
+			for (int32 j = range->contactStart; j < range->contactStart + range->contactCount; ++j)
+			{
+				listener->PostSolve(island->m_contacts[j], impulses + j);
+			}
+		}
+
+		FinishIsland(range->island, island->m_bodies + range->bodyStart, range->bodyCount, range->sleep);
+	}
+
+	m_stackAllocator.Free(impulses);
+}
+
+void b2World::Solve(const b2TimeStep& step)
+{
+	// With several threads, all the islands are collected into one big island
+	// first and then solved at the same time. Static bodies may appear in more
+	// than one island.
+	bool parallel = m_taskScheduler != NULL && m_threadCount > 1;
+	int32 bodyCapacity = m_bodyCount;
+	if (parallel)
+	{
+		bodyCapacity += m_contactManager.m_contactCount + m_jointCount;
+	}
+
+	// Size the island for the worst case.
+	b2Island island(bodyCapacity,
+					m_contactManager.m_contactCount,
+					m_jointCount,
+					&m_stackAllocator,
+					m_contactManager.m_contactListener);
+
+	if (m_solvedBodyCapacity < m_bodyCount)
+	{
+		b2Free(m_solvedBodies);
+		m_solvedBodyCapacity = m_bodyCount;
+		m_solvedBodies = (b2Body**)b2Alloc(m_solvedBodyCapacity * sizeof(b2Body*));
+	}
+	m_solvedBodyCount = 0;
+
+	// Islands are only split when they are about to fall asleep, so islands
+	// that never do keep growing. Split the one that lost the most constraints
+	// at the end of every step.
+	b2PersistentIsland* splitIsland = NULL;
+	int32 splitCount = 0;
+
+	// Simulate all awake islands.
+	int32 islandCount = 0;
+	b2IslandRange* islands = NULL;
+	if (parallel)
+	{
+		islands = (b2IslandRange*)m_stackAllocator.Allocate(m_bodyCount * sizeof(b2IslandRange));
+	}
+	b2PersistentIsland* awakeIsland = m_awakeIslandList;
+	while (awakeIsland)
+	{
+		b2PersistentIsland* next = awakeIsland->next;
+
+		// The user may have put all the bodies to sleep.
+		bool awake = false;
+		for (b2Body* b = awakeIsland->bodyList; b; b = b->m_islandNext)
+		{
+			if (b->IsAwake())
+			{
+				awake = true;
+				break;
+			}
+		}
+
+		if (awake == false)
+		{
+			SleepIsland(awakeIsland);
+			awakeIsland = next;
+			continue;
+		}
+
+		if (awakeIsland->constraintRemoveCount > splitCount)
+		{
+			splitIsland = awakeIsland;
+			splitCount = awakeIsland->constraintRemoveCount;
+		}
+
+		// Reset island.
+		if (parallel == false)
+		{
+			island.Clear();
+		}
+		b2IslandRange range;
+		range.island = awakeIsland;
+		range.bodyStart = island.m_bodyCount;
+		range.contactStart = island.m_contactCount;
+		range.jointStart = island.m_jointCount;
+
+		for (b2Body* b = awakeIsland->bodyList; b; b = b->m_islandNext)
+		{
+			b2Assert(b->IsActive() == true);
+			island.Add(b);
+
+			// Make sure the body is awake.
+			b->SetAwake(true);
+
+			m_solvedBodies[m_solvedBodyCount++] = b;
+		}
+
+		// Add the contacts and joints to static bodies. Static bodies are
+		// added to every island they touch.
+		for (b2Body* b = awakeIsland->bodyList; b; b = b->m_islandNext)
+		{
 			for (b2ContactEdge* ce = b->m_contactList; ce; ce = ce->next)
 			{
 				b2Contact* contact = ce->contact;
-
-				// Has this contact already been added to an island?
-				if (contact->m_flags & b2Contact::e_islandFlag)
+				b2Body* other = ce->other;
+				if (other->GetType() != b2_staticBody)
 				{
 					continue;
 				}
@@ -429,32 +1050,31 @@ void b2World::Solve(const b2TimeStep& step)
 					continue;
 				}
 
-				island.Add(contact);
-				contact->m_flags |= b2Contact::e_islandFlag;
-
-				b2Body* other = ce->other;
-
-				// Was the other body already added to this island?
-				if (other->m_flags & b2Body::e_islandFlag)
+				// Contacts that are still flagged for filtering were asleep
+				// when Collide ran. They may be destroyed on the next step.
+				if (contact->m_flags & b2Contact::e_filterFlag)
 				{
 					continue;
 				}
 
-				b2Assert(stackCount < stackSize);
-				stack[stackCount++] = other;
-				other->m_flags |= b2Body::e_islandFlag;
+				island.Add(contact);
+
+				if ((other->m_flags & b2Body::e_islandFlag) == 0)
+				{
+					island.Add(other);
+					other->SetAwake(true);
+					other->m_flags |= b2Body::e_islandFlag;
+				}
 			}
 
-			// Search all joints connect to this body.
 			for (b2JointEdge* je = b->m_jointList; je; je = je->next)
 			{
-				if (je->joint->m_islandFlag == true)
+				b2Body* other = je->other;
+				if (other->GetType() != b2_staticBody)
 				{
 					continue;
 				}
 
-				b2Body* other = je->other;
-
 				// Don't simulate joints connected to inactive bodies.
 				if (other->IsActive() == false)
 				{
@@ -462,23 +1082,43 @@ void b2World::Solve(const b2TimeStep& step)
 				}
 
 				island.Add(je->joint);
-				je->joint->m_islandFlag = true;
 
-				if (other->m_flags & b2Body::e_islandFlag)
+				if ((other->m_flags & b2Body::e_islandFlag) == 0)
 				{
-					continue;
+					island.Add(other);
+					other->SetAwake(true);
+					other->m_flags |= b2Body::e_islandFlag;
 				}
+			}
+		}
 
-				b2Assert(stackCount < stackSize);
-				stack[stackCount++] = other;
-				other->m_flags |= b2Body::e_islandFlag;
+		// Add the contacts and joints between the bodies of the island.
+		for (b2Contact* contact = awakeIsland->contactList; contact; contact = contact->m_islandNext)
+		{
+			// The user may have disabled the contact or made it a sensor.
+			if (contact->IsEnabled() == false ||
+				contact->m_fixtureA->m_isSensor || contact->m_fixtureB->m_isSensor)
+			{
+				continue;
+			}
+
+			if (contact->m_flags & b2Contact::e_filterFlag)
+			{
+				continue;
 			}
+
+			island.Add(contact);
+		}
+
+		for (b2Joint* joint = awakeIsland->jointList; joint; joint = joint->m_islandNext)
+		{
+			island.Add(joint);
 		}
 
-		island.Solve(step, m_gravity, m_allowSleep);
+		// The island indices of static bodies change with every island.
+		island.AssignIndices(range.bodyStart, range.contactStart, range.jointStart);
 
-		// Post solve cleanup.
-		for (int32 i = 0; i < island.m_bodyCount; ++i)
+		for (int32 i = range.bodyStart; i < island.m_bodyCount; ++i)
 		{
 			// Allow static bodies to participate in other islands.
 			b2Body* b = island.m_bodies[i];
@@ -487,26 +1127,40 @@ void b2World::Solve(const b2TimeStep& step)
 				b->m_flags &= ~b2Body::e_islandFlag;
 			}
 		}
-	}
 
-	m_stackAllocator.Free(stack);
-
-	// Synchronize fixtures, check for out of range bodies.
-	for (b2Body* b = m_bodyList; b; b = b->GetNext())
-	{
-		// If a body was not in an island then it did not move.
-		if ((b->m_flags & b2Body::e_islandFlag) == 0)
+		if (parallel)
 		{
-			continue;
+			range.bodyCount = island.m_bodyCount - range.bodyStart;
+			range.contactCount = island.m_contactCount - range.contactStart;
+			range.jointCount = island.m_jointCount - range.jointStart;
+			islands[islandCount++] = range;
 		}
-
-		if (b->GetType() == b2_staticBody)
+		else
 		{
-			continue;
+			island.Solve(step, m_gravity, m_allowSleep);
+			FinishIsland(awakeIsland, island.m_bodies, island.m_bodyCount, island.m_sleep);
 		}
 
+		awakeIsland = next;
+	}
+
+	if (parallel)
+	{
+		SolveIslands(step, &island, islands, islandCount);
+		m_stackAllocator.Free(islands);
+	}
+
+	// The island may have been split or put to sleep since it was picked.
+	if (splitIsland != NULL && splitIsland->constraintRemoveCount > 0)
+	{
+		SplitIsland(splitIsland);
+	}
+
+	// Synchronize fixtures, check for out of range bodies.
+	for (int32 i = 0; i < m_solvedBodyCount; ++i)
+	{
 		// Update fixtures (for broad-phase).
-		b->SynchronizeFixtures();
+		m_solvedBodies[i]->SynchronizeFixtures();
 	}
 
 	// Look for new contacts.
@@ -713,34 +1367,38 @@ void b2World::SolveTOI(b2Body* body)
 // Time is not conserved.
 void b2World::SolveTOI()
 {
-	// Prepare all contacts.
-	for (b2Contact* c = m_contactManager.m_contactList; c; c = c->m_next)
+	// Prepare the contacts of the bodies that moved, no other contacts take
+	// part in TOI events.
+	for (int32 i = 0; i < m_solvedBodyCount; ++i)
 	{
-		// Enable the contact
-		c->m_flags |= b2Contact::e_enabledFlag;
+		for (b2ContactEdge* ce = m_solvedBodies[i]->m_contactList; ce; ce = ce->next)
+		{
+			b2Contact* c = ce->contact;
+
+			// Enable the contact
+			c->m_flags |= b2Contact::e_enabledFlag;
 
-		// Set the number of TOI events for this contact to zero.
-		c->m_toiCount = 0;
+			// Set the number of TOI events for this contact to zero.
+			c->m_toiCount = 0;
+		}
 	}
 
-	// Initialize the TOI flag.
-	for (b2Body* body = m_bodyList; body; body = body->m_next)
+	// Initialize the TOI flag. It is set on all the other bodies.
+	for (int32 i = 0; i < m_solvedBodyCount; ++i)
 	{
-		// Kinematic, and static bodies will not be affected by the TOI event.
+		// Kinematic bodies will not be affected by the TOI event.
 		// If a body was not in an island then it did not move.
-		if ((body->m_flags & b2Body::e_islandFlag) == 0 || body->GetType() == b2_kinematicBody || body->GetType() == b2_staticBody)
-		{
-			body->m_flags |= b2Body::e_toiFlag;
-		}
-		else
+		b2Body* body = m_solvedBodies[i];
+		if (body->GetType() == b2_dynamicBody)
 		{
 			body->m_flags &= ~b2Body::e_toiFlag;
 		}
 	}
 
 	// Collide non-bullets.
-	for (b2Body* body = m_bodyList; body; body = body->m_next)
+	for (int32 i = 0; i < m_solvedBodyCount; ++i)
 	{
+		b2Body* body = m_solvedBodies[i];
 		if (body->m_flags & b2Body::e_toiFlag)
 		{
 			continue;
@@ -757,8 +1415,9 @@ void b2World::SolveTOI()
 	}
 
 	// Collide bullets.
-	for (b2Body* body = m_bodyList; body; body = body->m_next)
+	for (int32 i = 0; i < m_solvedBodyCount; ++i)
 	{
+		b2Body* body = m_solvedBodies[i];
 		if (body->m_flags & b2Body::e_toiFlag)
 		{
 			continue;
@@ -802,11 +1461,14 @@ void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIteration
 	step.dtRatio = m_inv_dt0 * dt;
 
 	step.warmStarting = m_warmStarting;
+	step.wideContactSolving = m_wideContactSolving;
 
 	// Update contacts. This is where some contacts are destroyed.
 	m_contactManager.Collide();
 
 	// Integrate velocities, solve velocity constraints, and integrate positions.
+	// Bodies only move if they are solved.
+	m_solvedBodyCount = 0;
 	if (step.dt > 0.0f)
 	{
 		Solve(step);
@@ -855,9 +1517,9 @@ struct b2WorldQueryWrapper
 void b2World::QueryAABB(b2QueryCallback* callback, const b2AABB& aabb) const
 {
 	b2WorldQueryWrapper wrapper;
-	wrapper.broadPhase = &m_contactManager.m_broadPhase;
+	wrapper.broadPhase = m_contactManager.m_broadPhase;
 	wrapper.callback = callback;
-	m_contactManager.m_broadPhase.Query(&wrapper, aabb);
+	m_contactManager.m_broadPhase->Query(&wrapper, aabb);
 }
 
 struct b2WorldRayCastWrapper
@@ -886,13 +1548,13 @@ struct b2WorldRayCastWrapper
 void b2World::RayCast(b2RayCastCallback* callback, const b2Vec2& point1, const b2Vec2& point2) const
 {
 	b2WorldRayCastWrapper wrapper;
-	wrapper.broadPhase = &m_contactManager.m_broadPhase;
+	wrapper.broadPhase = m_contactManager.m_broadPhase;
 	wrapper.callback = callback;
 	b2RayCastInput input;
 	input.maxFraction = 1.0f;
 	input.p1 = point1;
 	input.p2 = point2;
-	m_contactManager.m_broadPhase.RayCast(&wrapper, input);
+	m_contactManager.m_broadPhase->RayCast(&wrapper, input);
 }
 
 void b2World::DrawShape(b2Fixture* fixture, const b2Transform& xf, const b2Color& color)
@@ -1036,7 +1698,7 @@ void b2World::DrawDebugData()
 	if (flags & b2DebugDraw::e_aabbBit)
 	{
 		b2Color color(0.9f, 0.3f, 0.9f);
-		b2BroadPhase* bp = &m_contactManager.m_broadPhase;
+		b2BroadPhase* bp = m_contactManager.m_broadPhase;
 
 		for (b2Body* b = m_bodyList; b; b = b->GetNext())
 		{
@@ -1072,5 +1734,5 @@ void b2World::DrawDebugData()
 
 int32 b2World::GetProxyCount() const
 {
-	return m_contactManager.m_broadPhase.GetProxyCount();
+	return m_contactManager.m_broadPhase->GetProxyCount();
 }
@@ -22,6 +22,7 @@
 #include <Box2D/Common/b2Math.h>
 #include <Box2D/Common/b2BlockAllocator.h>
 #include <Box2D/Common/b2StackAllocator.h>
+#include <Box2D/Common/b2TaskScheduler.h>
 #include <Box2D/Dynamics/b2ContactManager.h>
 #include <Box2D/Dynamics/b2WorldCallbacks.h>
 
@@ -29,7 +30,11 @@ struct b2AABB;
 struct b2BodyDef;
 struct b2JointDef;
 struct b2TimeStep;
+struct b2IslandRange;
+struct b2PersistentIsland;
 class b2Body;
+class b2Contact;
+class b2Island;
 class b2Fixture;
 class b2Joint;
 
@@ -65,6 +70,44 @@ public:
 	/// by you and must remain in scope.
 	void SetDebugDraw(b2DebugDraw* debugDraw);
 
+	/// Register a task scheduler to solve independent islands on several
+	/// threads. The scheduler is owned by you and must remain in scope. Pass
+	/// NULL to do all the work on the calling thread.
+	/// @warning This function is locked during callbacks.
+	void SetTaskScheduler(b2TaskScheduler* scheduler);
+
+	/// Get the task scheduler, if any.
+	b2TaskScheduler* GetTaskScheduler() const;
+
+	/// Switch to another broad-phase. The proxies of all fixtures are moved
+	/// over and existing contacts are kept. The tree suits most worlds, the
+	/// sweep-and-prune suits worlds spread out along the x-axis and the grid
+	/// suits many proxies of about the cell size.
+	/// @param cellSize the width and height of a grid cell, only used by the grid.
+	/// @warning This function is locked during callbacks.
+	void SetBroadPhase(b2BroadPhaseType type, float32 cellSize);
+
+	/// Get the type of the broad-phase.
+	b2BroadPhaseType GetBroadPhaseType() const;
+
+	/// Start a batch of new fixtures, for instance while loading a scene. The
+	/// broad-phase may then organize their proxies together, which is much
+	/// quicker for many fixtures. Until the batch ends, QueryAABB and RayCast
+	/// may miss the new fixtures. A time step ends the batch.
+	/// @warning This function is locked during callbacks.
+	void BeginFixtureBatch();
+
+	/// End a batch of new fixtures.
+	/// @warning This function is locked during callbacks.
+	void EndFixtureBatch();
+
+	/// Shift the world origin, for instance to scroll a large world. Every
+	/// position moves by -newOrigin. This takes time in proportion to the
+	/// number of bodies and proxies, but bodies are not woken up, proxies
+	/// are not moved in the broad-phase and no contacts are created.
+	/// @warning This function is locked during callbacks.
+	void ShiftOrigin(const b2Vec2& newOrigin);
+
 	/// Create a rigid body given a definition. No reference to the definition
 	/// is retained.
 	/// @warning This function is locked during callbacks.
@@ -133,12 +176,25 @@ public:
 	/// @warning contacts are 
 	b2Contact* GetContactList();
 
+	/// Get the bodies simulated by the last time step, no other bodies moved.
+	/// The array is only valid until the next time step or until a body is
+	/// destroyed.
+	/// @return the solved bodies, see GetSolvedBodyCount for their number.
+	b2Body** GetSolvedBodies();
+
+	/// Get the number of bodies simulated by the last time step.
+	int32 GetSolvedBodyCount() const;
+
 	/// Enable/disable warm starting. For testing.
 	void SetWarmStarting(bool flag) { m_warmStarting = flag; }
 
 	/// Enable/disable continuous physics. For testing.
 	void SetContinuousPhysics(bool flag) { m_continuousPhysics = flag; }
 
+	/// Enable/disable solving contacts several at a time with SIMD. The results
+	/// match solving them one by one within round-off. For testing.
+	void SetWideContactSolving(bool flag) { m_wideContactSolving = flag; }
+
 	/// Get the number of broad-phase proxies.
 	int32 GetProxyCount() const;
 
@@ -177,10 +233,31 @@ private:
 	};
 
 	friend class b2Body;
+	friend class b2Contact;
 	friend class b2ContactManager;
 	friend class b2Controller;
 
+	// Keep the persistent islands up to date as bodies, contacts and joints
+	// come and go. Only active non-static bodies are linked into islands.
+	void LinkBody(b2Body* body);
+	void UnlinkBody(b2Body* body);
+	void LinkContact(b2Contact* contact);
+	void UnlinkContact(b2Contact* contact);
+	void LinkJoint(b2Joint* joint);
+	void UnlinkJoint(b2Joint* joint);
+
+	b2PersistentIsland* CreateIsland();
+	void DestroyIsland(b2PersistentIsland* island);
+	void WakeIsland(b2PersistentIsland* island);
+	void SleepIsland(b2PersistentIsland* island);
+	void SynchronizeContacts(b2Body* bodyList);
+	b2PersistentIsland* MergeIslands(b2PersistentIsland* islandA, b2PersistentIsland* islandB);
+	void SplitIsland(b2PersistentIsland* island);
+	void FinishIsland(b2PersistentIsland* island, b2Body** bodies, int32 bodyCount, bool sleep);
+
 	void Solve(const b2TimeStep& step);
+	void SolveIslands(const b2TimeStep& step, const b2Island* island,
+					  b2IslandRange* ranges, int32 count);
 	void SolveTOI();
 	void SolveTOI(b2Body* body);
 
@@ -200,6 +277,16 @@ private:
 	int32 m_bodyCount;
 	int32 m_jointCount;
 
+	// Islands with at least one awake body. Sleeping islands are only
+	// reachable through their bodies.
+	b2PersistentIsland* m_awakeIslandList;
+
+	// The non-static bodies solved in the last step, these are the only ones
+	// that moved.
+	b2Body** m_solvedBodies;
+	int32 m_solvedBodyCount;
+	int32 m_solvedBodyCapacity;
+
 	b2Vec2 m_gravity;
 	bool m_allowSleep;
 
@@ -208,6 +295,10 @@ private:
 	b2DestructionListener* m_destructionListener;
 	b2DebugDraw* m_debugDraw;
 
+	b2TaskScheduler* m_taskScheduler;
+	int32 m_threadCount;
+	b2StackAllocator* m_threadAllocators;
+
 	// This is used to compute the time step ratio to
 	// support a variable time step.
 	float32 m_inv_dt0;
@@ -217,6 +308,9 @@ private:
 
 	// This is for debugging the solver.
 	bool m_continuousPhysics;
+
+	// This is for debugging the solver.
+	bool m_wideContactSolving;
 };
 
 inline b2Body* b2World::GetBodyList()
@@ -234,6 +328,26 @@ inline b2Contact* b2World::GetContactList()
 	return m_contactManager.m_contactList;
 }
 
+inline b2Body** b2World::GetSolvedBodies()
+{
+	return m_solvedBodies;
+}
+
+inline int32 b2World::GetSolvedBodyCount() const
+{
+	return m_solvedBodyCount;
+}
+
+inline b2TaskScheduler* b2World::GetTaskScheduler() const
+{
+	return m_taskScheduler;
+}
+
+inline b2BroadPhaseType b2World::GetBroadPhaseType() const
+{
+	return m_contactManager.m_broadPhase->GetType();
+}
+
 inline int32 b2World::GetBodyCount() const
 {
 	return m_bodyCount;
@@ -57,6 +57,7 @@
 #include "VaryingRestitution.h"
 #include "VerticalStack.h"
 #include "Web.h"
+#include "WideSolver.h"
 
 TestEntry g_testEntries[] =
 {
@@ -96,5 +97,6 @@ TestEntry g_testEntries[] =
 	{"Slider Crank", SliderCrank::Create},
 	{"Varying Friction", VaryingFriction::Create},
 	{"Web", Web::Create},
+	{"Wide Solver", WideSolver::Create},
 	{NULL, NULL}
 };
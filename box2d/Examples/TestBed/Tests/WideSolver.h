@@ -0,0 +1,166 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef WIDE_SOLVER_H
+#define WIDE_SOLVER_H
+
+// Solves the same pyramid in the test world and in a second world that
+// solves its contacts one by one, and shows how far apart the boxes get.
+// The wide solver visits the contacts in another order, and a pyramid is
+// chaotic, so the two worlds drift apart. A third world solves the contacts
+// one by one but creates the boxes in reverse order, which shows how far
+// the scalar solver drifts from itself when only the order changes. The
+// wide solver should not drift further than that, unless the mouse or a
+// bomb disturbs the test world.
+class WideSolver : public Test
+{
+public:
+	enum
+	{
+		e_count = 20,
+		e_boxCount = e_count * (e_count + 1) / 2,
+	};
+
+	WideSolver()
+	{
+		b2Vec2 gravity(0.0f, -10.0f);
+		m_scalarWorld = new b2World(gravity, true);
+		m_scalarWorld->SetWideContactSolving(false);
+		m_reversedWorld = new b2World(gravity, true);
+		m_reversedWorld->SetWideContactSolving(false);
+		m_maxDistance = 0.0f;
+		m_maxReversedDistance = 0.0f;
+
+		CreatePyramid(m_world, m_boxes, false);
+		CreatePyramid(m_scalarWorld, m_scalarBoxes, false);
+		CreatePyramid(m_reversedWorld, m_reversedBoxes, true);
+	}
+
+	~WideSolver()
+	{
+		delete m_scalarWorld;
+		delete m_reversedWorld;
+	}
+
+	void CreatePyramid(b2World* world, b2Body** boxes, bool reversed)
+	{
+		{
+			b2BodyDef bd;
+			b2Body* ground = world->CreateBody(&bd);
+
+			b2PolygonShape shape;
+			shape.SetAsEdge(b2Vec2(-40.0f, 0.0f), b2Vec2(40.0f, 0.0f));
+			ground->CreateFixture(&shape, 0.0f);
+		}
+
+		{
+			float32 a = 0.5f;
+			b2PolygonShape shape;
+			shape.SetAsBox(a, a);
+
+			b2Vec2 positions[e_boxCount];
+			int32 count = 0;
+
+			b2Vec2 x(-7.0f, 0.75f);
+			b2Vec2 y;
+			b2Vec2 deltaX(0.5625f, 1.25f);
+			b2Vec2 deltaY(1.125f, 0.0f);
+
+			for (int32 i = 0; i < e_count; ++i)
+			{
+				y = x;
+
+				for (int32 j = i; j < e_count; ++j)
+				{
+					positions[count++] = y;
+					y += deltaY;
+				}
+
+				x += deltaX;
+			}
+
+			for (int32 i = 0; i < e_boxCount; ++i)
+			{
+				int32 index = reversed ? e_boxCount - 1 - i : i;
+
+				b2BodyDef bd;
+				bd.type = b2_dynamicBody;
+				bd.position = positions[index];
+				boxes[index] = world->CreateBody(&bd);
+				boxes[index]->CreateFixture(&shape, 5.0f);
+			}
+		}
+	}
+
+	void Step(Settings* settings)
+	{
+		bool stepping = settings->pause == 0 || settings->singleStep != 0;
+
+		Test::Step(settings);
+
+		if (stepping && settings->hz > 0.0f)
+		{
+			StepScalar(m_scalarWorld, settings);
+			StepScalar(m_reversedWorld, settings);
+		}
+
+		float32 distance = GetDistance(m_boxes, m_scalarBoxes);
+		m_maxDistance = b2Max(m_maxDistance, distance);
+		float32 reversedDistance = GetDistance(m_reversedBoxes, m_scalarBoxes);
+		m_maxReversedDistance = b2Max(m_maxReversedDistance, reversedDistance);
+
+		m_debugDraw.DrawString(5, m_textLine, "Distance from the scalar solver: %g, at most %g", distance, m_maxDistance);
+		m_textLine += 15;
+		m_debugDraw.DrawString(5, m_textLine, "Distance of the scalar solver in reverse order: %g, at most %g",
+			reversedDistance, m_maxReversedDistance);
+		m_textLine += 15;
+	}
+
+	void StepScalar(b2World* world, Settings* settings)
+	{
+		world->SetWarmStarting(settings->enableWarmStarting > 0);
+		world->SetContinuousPhysics(settings->enableContinuous > 0);
+		world->Step(1.0f / settings->hz, settings->velocityIterations, settings->positionIterations);
+	}
+
+	// The largest distance between the same box in two worlds.
+	float32 GetDistance(b2Body** boxes1, b2Body** boxes2)
+	{
+		float32 distance = 0.0f;
+		for (int32 i = 0; i < e_boxCount; ++i)
+		{
+			distance = b2Max(distance, b2Distance(boxes1[i]->GetPosition(), boxes2[i]->GetPosition()));
+		}
+		return distance;
+	}
+
+	static Test* Create()
+	{
+		return new WideSolver;
+	}
+
+	b2World* m_scalarWorld;
+	b2World* m_reversedWorld;
+	b2Body* m_boxes[e_boxCount];
+	b2Body* m_scalarBoxes[e_boxCount];
+	b2Body* m_reversedBoxes[e_boxCount];
+	float32 m_maxDistance;
+	float32 m_maxReversedDistance;
+};
+
+#endif
@@ -44,11 +44,16 @@ enum
   PROP_ANGULAR_VELOCITY,
   PROP_MODE,
   PROP_MANIPULATABLE,
+  PROP_REPORT_COLLISIONS,
+  PROP_COLLISION_THRESHOLD,
+  PROP_SHAPE,
 };
 
 enum
 {
   COLLISION,
+  CONTACT_BEGIN,
+  CONTACT_END,
   LAST_SIGNAL
 };
 
@@ -86,7 +91,6 @@ clutter_box2d_child_set_type2 (ClutterBox2DChild *box2d_child,
     {
       g_assert (box2d_child->priv->body);
 
-      g_hash_table_remove (box2d->priv->bodies, box2d_child->priv->body);
       world->DestroyBody (box2d_child->priv->body);
       box2d_child->priv->body = NULL;
       box2d_child->priv->fixture = NULL;
@@ -118,9 +122,9 @@ clutter_box2d_child_set_type2 (ClutterBox2DChild *box2d_child,
           bodyDef.type = b2_staticBody;
           box2d_child->priv->body = world->CreateBody (&bodyDef);
         }
+      box2d_child->priv->body->SetUserData (box2d_child);
+      _clutter_box2d_begin_fixture_batch (box2d);
       _clutter_box2d_sync_body (box2d, box2d_child);
-
-      g_hash_table_insert (box2d->priv->bodies, box2d_child->priv->body, box2d_child);
     }
 }
 
@@ -138,6 +142,14 @@ clutter_box2d_child_set_type (ClutterBox2D      *box2d,
   clutter_box2d_child_set_type2 (box2d_child, type);
 }
 
+static void
+clutter_box2d_child_transform_notify (ClutterBox2DChild *box2d_child)
+{
+  ClutterBox2D *box2d = CLUTTER_BOX2D (clutter_child_meta_get_container (
+                                       CLUTTER_CHILD_META (box2d_child)));
+  _clutter_box2d_queue_sync_body (box2d, box2d_child);
+}
+
 static inline void
 clutter_box2d_child_refresh_shape (ClutterBox2DChild *box2d_child)
 {
@@ -145,9 +157,7 @@ clutter_box2d_child_refresh_shape (ClutterBox2DChild *box2d_child)
     {
       ClutterBox2D *box2d = CLUTTER_BOX2D (clutter_child_meta_get_container (
                                            CLUTTER_CHILD_META (box2d_child)));
-      box2d_child->priv->body->DestroyFixture (box2d_child->priv->fixture);
-      box2d_child->priv->fixture = NULL;
-      _clutter_box2d_sync_body (box2d, box2d_child);
+      _clutter_box2d_refresh_shape (box2d, box2d_child);
     }
 }
 
@@ -272,6 +282,100 @@ clutter_box2d_child_set_angular_velocity_internal (ClutterBox2DChild *box2d_chil
   box2d_child->priv->body->SetAngularVelocity (velocity);
 }
 
+static void
+clutter_box2d_child_set_report_collisions_internal (ClutterBox2DChild *box2d_child,
+                                                    gboolean           report)
+{
+  if (box2d_child->priv->report_collisions != report)
+    {
+      box2d_child->priv->report_collisions = report;
+      g_object_notify (G_OBJECT (box2d_child), "report-collisions");
+    }
+}
+
+static void
+clutter_box2d_child_set_collision_threshold_internal (ClutterBox2DChild *box2d_child,
+                                                      gfloat             threshold)
+{
+  if (box2d_child->priv->collision_threshold != threshold)
+    {
+      box2d_child->priv->collision_threshold = threshold;
+      g_object_notify (G_OBJECT (box2d_child), "collision-threshold");
+    }
+}
+
+static void
+clutter_box2d_child_set_shape_internal (ClutterBox2DChild *box2d_child,
+                                        ClutterBox2DShape *shape)
+{
+  ClutterBox2DChildPrivate *priv = box2d_child->priv;
+  ClutterBox2DShape *old_shape = priv->shape;
+
+  if (old_shape == shape)
+    return;
+
+  priv->shape = shape ? clutter_box2d_shape_ref (shape) : NULL;
+
+  /* The fixture may be using the old shape, so it has to be replaced
+   * before that is released.
+   */
+  if (priv->fixture)
+    {
+      ClutterBox2D *box2d = CLUTTER_BOX2D (clutter_child_meta_get_container (
+                                           CLUTTER_CHILD_META (box2d_child)));
+      priv->body->DestroyFixture (priv->fixture);
+      priv->fixture = NULL;
+      _clutter_box2d_sync_body (box2d, box2d_child);
+    }
+
+  if (old_shape)
+    clutter_box2d_shape_unref (old_shape);
+
+  g_object_notify (G_OBJECT (box2d_child), "shape");
+}
+
+/* Whether collisions involving this child need to be reported, either
+ * because it was asked for explicitly or because somebody is listening to
+ * the "collision" signal. Checking for handlers is done at most once per
+ * step, as this is called from the contact listener.
+ */
+gboolean
+_clutter_box2d_child_reports_collisions (ClutterBox2DChild *box2d_child,
+                                         guint              step)
+{
+  ClutterBox2DChildPrivate *priv = box2d_child->priv;
+
+  if (priv->report_collisions)
+    return TRUE;
+
+  if (priv->handlers_step != step)
+    {
+      priv->has_handlers =
+        g_signal_has_handler_pending (box2d_child,
+                                      box2d_child_signals[COLLISION],
+                                      0, TRUE) ||
+        g_signal_has_handler_pending (box2d_child,
+                                      box2d_child_signals[CONTACT_BEGIN],
+                                      0, TRUE) ||
+        g_signal_has_handler_pending (box2d_child,
+                                      box2d_child_signals[CONTACT_END],
+                                      0, TRUE);
+      priv->handlers_step = step;
+    }
+
+  return priv->has_handlers;
+}
+
+void
+_clutter_box2d_child_emit_contact (ClutterBox2DChild *box2d_child,
+                                   gboolean           begin,
+                                   ClutterActor      *other)
+{
+  g_signal_emit (box2d_child,
+                 box2d_child_signals[begin ? CONTACT_BEGIN : CONTACT_END],
+                 0, other);
+}
+
 static void
 clutter_box2d_child_set_property (GObject      *gobject,
                                   guint         prop_id,
@@ -335,6 +439,20 @@ clutter_box2d_child_set_property (GObject      *gobject,
 
       break;
 
+    case PROP_REPORT_COLLISIONS:
+      clutter_box2d_child_set_report_collisions_internal (box2d_child,
+                                                          g_value_get_boolean (value));
+      break;
+
+    case PROP_SHAPE:
+      clutter_box2d_child_set_shape_internal (box2d_child,
+                        (ClutterBox2DShape *)g_value_get_boxed (value));
+      break;
+    case PROP_COLLISION_THRESHOLD:
+      clutter_box2d_child_set_collision_threshold_internal (box2d_child,
+                                                            g_value_get_float (value));
+      break;
+
     case PROP_OUTLINE:
       {
         GValueArray *array;
@@ -444,6 +562,15 @@ clutter_box2d_child_get_property (GObject      *gobject,
     case PROP_MANIPULATABLE:
       g_value_set_boolean (value, priv->manipulatable);
       break;
+    case PROP_REPORT_COLLISIONS:
+      g_value_set_boolean (value, priv->report_collisions);
+      break;
+    case PROP_COLLISION_THRESHOLD:
+      g_value_set_float (value, priv->collision_threshold);
+      break;
+    case PROP_SHAPE:
+      g_value_set_boxed (value, priv->shape);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (gobject, prop_id, pspec);
       break;
@@ -470,6 +597,24 @@ clutter_box2d_child_class_init (ClutterBox2DChildClass *klass)
                                  G_TYPE_NONE, 1, 
                                  CLUTTER_TYPE_BOX2D_COLLISION);
 
+  box2d_child_signals[CONTACT_BEGIN] = g_signal_new ("contact-begin",
+                                 G_TYPE_FROM_CLASS (gobject_class),
+                                 G_SIGNAL_RUN_LAST,
+                                 0,
+                                 NULL, NULL,
+                                 _clutter_box2d_marshal_VOID__OBJECT,
+                                 G_TYPE_NONE, 1,
+                                 CLUTTER_TYPE_ACTOR);
+
+  box2d_child_signals[CONTACT_END] = g_signal_new ("contact-end",
+                                 G_TYPE_FROM_CLASS (gobject_class),
+                                 G_SIGNAL_RUN_LAST,
+                                 0,
+                                 NULL, NULL,
+                                 _clutter_box2d_marshal_VOID__OBJECT,
+                                 G_TYPE_NONE, 1,
+                                 CLUTTER_TYPE_ACTOR);
+
   g_object_class_install_property (gobject_class,
                                    PROP_DENSITY,
                                    g_param_spec_float ("density",
@@ -557,6 +702,35 @@ clutter_box2d_child_class_init (ClutterBox2DChildClass *klass)
                                                                                  (GParamFlags)G_PARAM_READWRITE),
                                                              (GParamFlags)G_PARAM_READWRITE));
 
+  g_object_class_install_property (gobject_class,
+                                   PROP_REPORT_COLLISIONS,
+                                   g_param_spec_boolean ("report-collisions",
+                                                         "Report collisions",
+                                     "Whether collisions involving this actor are "
+                                     "reported even when nothing is connected to "
+                                     "its collision signal.",
+                                                         FALSE,
+                                                         (GParamFlags)G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class,
+                                   PROP_COLLISION_THRESHOLD,
+                                   g_param_spec_float ("collision-threshold",
+                                                       "Collision threshold",
+                                     "The normal impulse below which contact points "
+                                     "are not reported as collisions.",
+                                                       0.f, G_MAXFLOAT, 0.f,
+                                                       (GParamFlags)G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class,
+                                   PROP_SHAPE,
+                                   g_param_spec_boxed ("shape",
+                                                       "Shape",
+                                     "A shape shared with other actors, used "
+                                     "instead of the size and outline of the "
+                                     "actor.",
+                                                       CLUTTER_TYPE_BOX2D_SHAPE,
+                                                       (GParamFlags)G_PARAM_READWRITE));
+
   g_type_class_add_private (gobject_class, sizeof (ClutterBox2DChildPrivate));
 }
 
@@ -571,6 +745,17 @@ clutter_box2d_child_constructed (GObject *object)
   g_signal_connect_swapped (actor, "notify::natural-height",
                             G_CALLBACK (clutter_box2d_child_refresh_shape),
                             object);
+
+  /* Track the application moving the actor, to update the body */
+  g_signal_connect_swapped (actor, "notify::x",
+                            G_CALLBACK (clutter_box2d_child_transform_notify),
+                            object);
+  g_signal_connect_swapped (actor, "notify::y",
+                            G_CALLBACK (clutter_box2d_child_transform_notify),
+                            object);
+  g_signal_connect_swapped (actor, "notify::rotation-angle-z",
+                            G_CALLBACK (clutter_box2d_child_transform_notify),
+                            object);
 }
 
 static void
@@ -594,9 +779,14 @@ clutter_box2d_child_dispose (GObject *object)
   g_assert (priv->world);
 
   if (child_meta->actor)
-    g_signal_handlers_disconnect_by_func (child_meta->actor,
-                                          (gpointer)clutter_box2d_child_refresh_shape,
-                                          object);
+    {
+      g_signal_handlers_disconnect_by_func (child_meta->actor,
+                                            (gpointer)clutter_box2d_child_refresh_shape,
+                                            object);
+      g_signal_handlers_disconnect_by_func (child_meta->actor,
+                                            (gpointer)clutter_box2d_child_transform_notify,
+                                            object);
+    }
 
   /* This will disconnect any capture/press signal handlers */
   if (priv->manipulatable)
@@ -628,6 +818,9 @@ clutter_box2d_child_finalize (GObject *object)
 
   g_free (priv->outline);
   g_free (priv->b2outline);
+
+  if (priv->shape)
+    clutter_box2d_shape_unref (priv->shape);
 }
 
 static gboolean
@@ -1079,3 +1272,90 @@ clutter_box2d_child_get_manipulatable (ClutterBox2D *box2d,
     return FALSE;
 }
 
+
+void
+clutter_box2d_child_set_report_collisions (ClutterBox2D *box2d,
+                                           ClutterActor *child,
+                                           gboolean      report)
+{
+  ClutterBox2DChild *self;
+
+  g_return_if_fail (CLUTTER_IS_BOX2D (box2d));
+  g_return_if_fail (CLUTTER_IS_ACTOR (child));
+
+  if ((self = clutter_box2d_get_child (box2d, child)))
+    clutter_box2d_child_set_report_collisions_internal (self, report);
+}
+
+gboolean
+clutter_box2d_child_get_report_collisions (ClutterBox2D *box2d,
+                                           ClutterActor *child)
+{
+  ClutterBox2DChild *self;
+
+  g_return_val_if_fail (CLUTTER_IS_BOX2D (box2d), FALSE);
+  g_return_val_if_fail (CLUTTER_IS_ACTOR (child), FALSE);
+
+  if ((self = clutter_box2d_get_child (box2d, child)))
+    return self->priv->report_collisions;
+  else
+    return FALSE;
+}
+
+void
+clutter_box2d_child_set_collision_threshold (ClutterBox2D *box2d,
+                                             ClutterActor *child,
+                                             gfloat        threshold)
+{
+  ClutterBox2DChild *self;
+
+  g_return_if_fail (CLUTTER_IS_BOX2D (box2d));
+  g_return_if_fail (CLUTTER_IS_ACTOR (child));
+
+  if ((self = clutter_box2d_get_child (box2d, child)))
+    clutter_box2d_child_set_collision_threshold_internal (self, threshold);
+}
+
+gfloat
+clutter_box2d_child_get_collision_threshold (ClutterBox2D *box2d,
+                                             ClutterActor *child)
+{
+  ClutterBox2DChild *self;
+
+  g_return_val_if_fail (CLUTTER_IS_BOX2D (box2d), 0.f);
+  g_return_val_if_fail (CLUTTER_IS_ACTOR (child), 0.f);
+
+  if ((self = clutter_box2d_get_child (box2d, child)))
+    return self->priv->collision_threshold;
+  else
+    return 0.f;
+}
+
+void
+clutter_box2d_child_set_shape (ClutterBox2D      *box2d,
+                               ClutterActor      *child,
+                               ClutterBox2DShape *shape)
+{
+  ClutterBox2DChild *self;
+
+  g_return_if_fail (CLUTTER_IS_BOX2D (box2d));
+  g_return_if_fail (CLUTTER_IS_ACTOR (child));
+
+  if ((self = clutter_box2d_get_child (box2d, child)))
+    clutter_box2d_child_set_shape_internal (self, shape);
+}
+
+ClutterBox2DShape *
+clutter_box2d_child_get_shape (ClutterBox2D *box2d,
+                               ClutterActor *child)
+{
+  ClutterBox2DChild *self;
+
+  g_return_val_if_fail (CLUTTER_IS_BOX2D (box2d), NULL);
+  g_return_val_if_fail (CLUTTER_IS_ACTOR (child), NULL);
+
+  if ((self = clutter_box2d_get_child (box2d, child)))
+    return self->priv->shape;
+  else
+    return NULL;
+}
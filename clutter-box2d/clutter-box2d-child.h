@@ -63,6 +63,25 @@ struct _ClutterBox2DChildClass
   ClutterChildMetaClass parent_class;
 };
 
+/**
+ * ClutterBox2DChild::contact-begin:
+ * @box2d_child: the #ClutterBox2DChild that emitted the signal
+ * @other: the actor it started touching, or %NULL if that actor has been
+ *   removed from the #ClutterBox2D in the meantime
+ *
+ * Emitted once when the actor starts touching another actor, after the
+ * physics step in which that happened.
+ */
+
+/**
+ * ClutterBox2DChild::contact-end:
+ * @box2d_child: the #ClutterBox2DChild that emitted the signal
+ * @other: the actor it stopped touching, or %NULL if that actor has been
+ *   removed from the #ClutterBox2D in the meantime
+ *
+ * Emitted once when the actor stops touching another actor.
+ */
+
 GType   clutter_box2d_child_get_type  (void) G_GNUC_CONST;
 
 void clutter_box2d_child_set_is_bullet (ClutterBox2D *box2d,
@@ -128,6 +147,24 @@ void clutter_box2d_child_set_manipulatable (ClutterBox2D *box2d,
 gboolean clutter_box2d_child_get_manipulatable (ClutterBox2D *box2d,
                                                 ClutterActor *child);
 
+void clutter_box2d_child_set_report_collisions (ClutterBox2D *box2d,
+                                                ClutterActor *child,
+                                                gboolean      report);
+gboolean clutter_box2d_child_get_report_collisions (ClutterBox2D *box2d,
+                                                    ClutterActor *child);
+
+void clutter_box2d_child_set_collision_threshold (ClutterBox2D *box2d,
+                                                  ClutterActor *child,
+                                                  gfloat        threshold);
+gfloat clutter_box2d_child_get_collision_threshold (ClutterBox2D *box2d,
+                                                    ClutterActor *child);
+
+void clutter_box2d_child_set_shape (ClutterBox2D      *box2d,
+                                    ClutterActor      *child,
+                                    ClutterBox2DShape *shape);
+ClutterBox2DShape *clutter_box2d_child_get_shape (ClutterBox2D *box2d,
+                                                  ClutterActor *child);
+
 G_END_DECLS
 
 #endif
@@ -73,6 +73,35 @@ struct _ClutterBox2DCollisionClass
   GObjectClass parent_class;
 };
 
+/**
+ * ClutterBox2DCollisionRecord:
+ * @actor1: Actor 1 in collision
+ * @actor2: Actor 2 in collision
+ * @position: Centre of the contact points, in pixels
+ * @normal: Unit vector pointing from @actor1 to @actor2
+ * @normal_force: Contact solver's calculated collision intensity, summed
+ *   over all contact points
+ * @tangent_force: Contact solver's calculated friction, summed over all
+ *   contact points
+ * @id: Contact ID of the first contact point
+ *
+ * Contact information for two touching actors during a physics step, as
+ * delivered in batches by the #ClutterBox2D::collisions signal. Records
+ * are only valid for the duration of the signal emission.
+ */
+typedef struct _ClutterBox2DCollisionRecord ClutterBox2DCollisionRecord;
+
+struct _ClutterBox2DCollisionRecord
+{
+  ClutterActor   *actor1;
+  ClutterActor   *actor2;
+  ClutterVertex   position;
+  ClutterVertex   normal;
+  gdouble         normal_force;
+  gdouble         tangent_force;
+  gulong          id;
+};
+
 typedef void (*ClutterBox2DCollisionHandler) (
   ClutterActor          *actor,
   ClutterBox2DCollision *collision,
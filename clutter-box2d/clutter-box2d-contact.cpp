@@ -25,61 +25,138 @@ __ClutterBox2DContactListener::~__ClutterBox2DContactListener()
 }
 
 /**
- * PreSolve is called on each collision encountered during a Step in the Box2D
- * simulation.  This callback looks up the ClutterActors that correlate
- * to the objects within the Box2D world.  It creates a ClutterBox2DCollision
- * objects and initializes them appropriately.  It then chains those objects
- * onto the list of pending collisions (to be processed after the full set of
- * simulation Steps have finished in clutter_box2d_iterate().
+ * Queues a contact-begin or contact-end event for the children owning the
+ * two fixtures of @contact, if one of them reports collisions. The events
+ * are emitted after the simulation Step has finished in
+ * clutter_box2d_real_iterate(); EndContact may also be called outside of
+ * a Step, when a body is destroyed.
  */
 void
-__ClutterBox2DContactListener::PreSolve(b2Contact *contact, const b2Manifold *old_manifold)
+__ClutterBox2DContactListener::QueueContactEvent(b2Contact *contact, gboolean begin)
 {
-  ClutterBox2DCollision *collision;
+  ClutterBox2DContactEvent event;
+  ClutterBox2DChild *child1, *child2;
+  ClutterBox2DPrivate *priv;
+
+  child1 = (ClutterBox2DChild *)contact->GetFixtureA()->GetBody()->GetUserData();
+  if (!child1)
+    return;
+
+  child2 = (ClutterBox2DChild *)contact->GetFixtureB()->GetBody()->GetUserData();
+  if (!child2)
+    return;
+
+  priv = this->m_box2d->priv;
+
+  if (!_clutter_box2d_child_reports_collisions (child1, priv->step_count) &&
+      !_clutter_box2d_child_reports_collisions (child2, priv->step_count))
+    return;
+
+  event.begin = begin;
+  event.actor1 = CLUTTER_CHILD_META (child1)->actor;
+  event.actor2 = CLUTTER_CHILD_META (child2)->actor;
+
+  g_array_append_val (priv->contact_events, event);
+}
+
+void
+__ClutterBox2DContactListener::BeginContact(b2Contact *contact)
+{
+  QueueContactEvent (contact, TRUE);
+}
+
+void
+__ClutterBox2DContactListener::EndContact(b2Contact *contact)
+{
+  QueueContactEvent (contact, FALSE);
+}
+
+/**
+ * PostSolve is called for each touching contact once the Box2D contact
+ * solver has run.  This callback looks up the ClutterActors that correlate
+ * to the objects within the Box2D world, through the user data of their
+ * bodies.  Unless one of them reports collisions, nothing else is done.
+ * It then combines the solved impulses of all contact points into a single
+ * ClutterBox2DCollisionRecord, and appends it to the array of pending
+ * collisions if the impulse is large enough (to be processed after the
+ * simulation Step has finished in clutter_box2d_real_iterate()).
+ */
+void
+__ClutterBox2DContactListener::PostSolve(b2Contact *contact, const b2ContactImpulse *impulse)
+{
+  ClutterBox2DCollisionRecord record;
   ClutterActor *actor1, *actor2;
+  ClutterBox2DChild *child1, *child2;
+  gboolean reports1, reports2;
   b2WorldManifold world_manifold;
-  ClutterChildMeta *child_meta;
   ClutterBox2DPrivate *priv;
   b2Manifold *manifold;
-  void *tmp;
+  gfloat threshold;
+  float32 normal_impulse, tangent_impulse;
+  b2Vec2 position;
   gint i;
 
   manifold = contact->GetManifold();
   if (manifold->pointCount == 0)
     return;
 
-  tmp = g_hash_table_lookup (this->m_box2d->priv->bodies, contact->GetFixtureA()->GetBody());
-  if (!tmp)
+  child1 = (ClutterBox2DChild *)contact->GetFixtureA()->GetBody()->GetUserData();
+  if (!child1)
     return;
-  child_meta = CLUTTER_CHILD_META (tmp);
-  actor1 = child_meta->actor;
-  if (!actor1)
+
+  child2 = (ClutterBox2DChild *)contact->GetFixtureB()->GetBody()->GetUserData();
+  if (!child2)
     return;
 
-  tmp = g_hash_table_lookup (this->m_box2d->priv->bodies, contact->GetFixtureB()->GetBody());
-  if (!tmp)
+  priv = this->m_box2d->priv;
+
+  reports1 = _clutter_box2d_child_reports_collisions (child1, priv->step_count);
+  reports2 = _clutter_box2d_child_reports_collisions (child2, priv->step_count);
+  if (!reports1 && !reports2)
     return;
-  child_meta = CLUTTER_CHILD_META (tmp);
-  actor2 = CLUTTER_ACTOR (child_meta->actor);
-  if (!actor2)
+
+  actor1 = CLUTTER_CHILD_META (child1)->actor;
+  actor2 = CLUTTER_CHILD_META (child2)->actor;
+  if (!actor1 || !actor2)
     return;
 
-  contact->GetWorldManifold (&world_manifold);
-  priv = this->m_box2d->priv;
+  if (reports1 && reports2)
+    threshold = MIN (child1->priv->collision_threshold,
+                     child2->priv->collision_threshold);
+  else
+    threshold = reports1 ? child1->priv->collision_threshold :
+                           child2->priv->collision_threshold;
 
+  normal_impulse = 0;
+  tangent_impulse = 0;
   for (i = 0; i < manifold->pointCount; i++)
     {
-      collision = CLUTTER_BOX2D_COLLISION (g_object_new (CLUTTER_TYPE_BOX2D_COLLISION, NULL));
-      collision->actor1 = actor1;
-      collision->actor2 = actor2;
-      collision->normal.x = world_manifold.normal.x;
-      collision->normal.y = world_manifold.normal.y;
-      collision->normal_force = manifold->points[i].normalImpulse;
-      collision->tangent_force = manifold->points[i].tangentImpulse;
-      collision->id = manifold->points[i].id.key;
-      collision->position.x = world_manifold.points[i].x * priv->inv_scale_factor;
-      collision->position.y = world_manifold.points[i].y * priv->inv_scale_factor;
-
-      priv->collisions = g_list_prepend(priv->collisions, collision);
+      normal_impulse += impulse->normalImpulses[i];
+      tangent_impulse += impulse->tangentImpulses[i];
     }
+
+  if (normal_impulse < threshold)
+    return;
+
+  /* Report the impact at the centre of the contact points */
+  contact->GetWorldManifold (&world_manifold);
+  position.SetZero ();
+  for (i = 0; i < manifold->pointCount; i++)
+    position += world_manifold.points[i];
+  position *= 1.f / manifold->pointCount;
+
+  record.actor1 = actor1;
+  record.actor2 = actor2;
+  record.normal.x = world_manifold.normal.x;
+  record.normal.y = world_manifold.normal.y;
+  record.normal.z = 0;
+  record.normal_force = normal_impulse;
+  record.tangent_force = tangent_impulse;
+  record.id = manifold->points[0].id.key;
+  record.position.x = position.x * priv->inv_scale_factor;
+  record.position.y = position.y * priv->inv_scale_factor;
+  record.position.z = 0;
+
+  /* The storage of the array is kept between steps */
+  g_array_append_val (priv->collisions, record);
 }
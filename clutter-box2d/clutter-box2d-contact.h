@@ -21,7 +21,12 @@ private:
 public:
   __ClutterBox2DContactListener(ClutterBox2D *box2d);
   ~__ClutterBox2DContactListener();
-  void PreSolve(b2Contact* contact, const b2Manifold *old_manifold);
+  void BeginContact(b2Contact* contact);
+  void EndContact(b2Contact* contact);
+  void PostSolve(b2Contact* contact, const b2ContactImpulse *impulse);
+
+private:
+  void QueueContactEvent(b2Contact* contact, gboolean begin);
 };
 
 #endif
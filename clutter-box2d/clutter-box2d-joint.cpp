@@ -45,21 +45,18 @@ joint_new (ClutterBox2D          *box2d,
            b2Joint               *joint,
            ClutterBox2DJointType  type)
 {
-  ClutterBox2DPrivate *priv = box2d->priv;
   ClutterBox2DJoint *self = g_new0 (ClutterBox2DJoint, 1);
   self->box2d = box2d;
   self->joint = joint;
   self->type = type;
 
-  self->actor1 = (ClutterBox2DChild*)
-      g_hash_table_lookup (priv->bodies, joint->GetBodyA());
+  self->actor1 = (ClutterBox2DChild*) joint->GetBodyA()->GetUserData ();
   if (self->actor1)
     {
       self->actor1->priv->joints =
         g_list_append (self->actor1->priv->joints, self);
     }
-  self->actor2 = (ClutterBox2DChild*)
-      g_hash_table_lookup (priv->bodies, joint->GetBodyB());
+  self->actor2 = (ClutterBox2DChild*) joint->GetBodyB()->GetUserData ();
   if (self->actor2)
     {
       self->actor2->priv->joints =
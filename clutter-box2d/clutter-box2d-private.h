@@ -17,25 +17,64 @@
 
 G_BEGIN_DECLS
 
+class __ClutterBox2DTaskScheduler;
+
+/* A contact between two children that started or ended during a step */
+typedef struct
+{
+  gboolean      begin;
+  ClutterActor *actor1;
+  ClutterActor *actor2;
+} ClutterBox2DContactEvent;
+
+struct _ClutterBox2DShape
+{
+  volatile gint  ref_count;
+  gfloat         width;  /* Size of boxes and circles, in pixels */
+  gfloat         height;
+  ClutterVertex *outline; /* Vertices of outlines, in pixels */
+  guint          n_vertices;
+
+  b2Shape       *shape;  /* The shared Box2D shape, in world units */
+  b2MassData     mass;   /* Mass data of the shape at a density of 1 */
+  gfloat         scale_factor; /* Scale factor the above are computed for */
+};
+
 struct _ClutterBox2DPrivate
 {
   gint             iterations;  /* number of engine iterations per processing */
   gfloat           time_step;   /* Time step to simulate */
   gfloat           scale_factor; /* The scale factor of pixels to units */
   gfloat           inv_scale_factor; /* The inverse of the above */
-  guint            iterate_id;  /* The iteration callback */
+  gint             max_substeps; /* Cap on catch-up steps per frame */
+  gfloat           accumulator; /* Unsimulated time carried between frames */
+  ClutterTimeline *timeline;    /* Frame source driving the simulation */
+  ClutterBox2DInterpolation interpolation; /* How to fill in between steps */
   gboolean         simulate_inactive; /* Whether to simulate inactive bodies */
 
   b2World         *world;  /* The Box2D world which contains our simulation*/
   GHashTable      *actors; /* a hash table that maps actors to */
-  GHashTable      *bodies; /* a hash table that maps bodies to */
+  GPtrArray       *children; /* all ClutterBox2DChild, in no particular order */
+  GPtrArray       *moved_children; /* children moved by the application */
+  GPtrArray       *awake_children; /* children whose actors may still need
+                                    * synchronising with their bodies */
+  gboolean         syncing; /* Set while we move actors ourselves */
   GHashTable      *joints;
   b2Body          *ground_body;
   gboolean         dirty;  /* Shapes need to be recreated */
 
-  GList           *collisions; /* List of ClutterBox2DCollision contact 
-                                * points from last iteration through time */
+  GArray          *collisions; /* ClutterBox2DCollisionRecord contact points
+                                * from the last iteration through time */
+  ClutterBox2DCollision *collision; /* Reused for "collision" signals */
+  GArray          *contact_events; /* ClutterBox2DContactEvent since the
+                                    * last iteration */
+  guint            step_count; /* Amount of steps taken so far */
   ClutterBox2DContactListener *contact_listener;
+  gint             worker_threads; /* Threads to solve islands on */
+  ClutterBox2DBroadPhase broad_phase; /* How pairs of shapes are found */
+  gfloat           grid_cell_size; /* Grid broad-phase cell size, in pixels */
+  __ClutterBox2DTaskScheduler *task_scheduler;
+  guint            fixture_batch_id; /* Idle ending the batch of new fixtures */
 };
 
 struct _ClutterBox2DChildPrivate {
@@ -55,6 +94,7 @@ struct _ClutterBox2DChildPrivate {
                              affected by collisions. None: The object is not
                              included in the simulation. */
   gboolean          is_circle;
+  ClutterBox2DShape *shape; /* Shared shape used instead of the below */
   ClutterVertex    *outline;
   b2Vec2           *b2outline;
   guint             n_vertices;
@@ -63,6 +103,7 @@ struct _ClutterBox2DChildPrivate {
   b2Fixture        *fixture; /* Fixture for this body, if any */
   GList            *joints; /* list of joints this body participates in */
   b2World          *world;  /*the Box2D world (could be looked up through box2d)*/
+  guint             index;  /* position in the children array of the box2d */
 
   gfloat            density;
   gfloat            friction;
@@ -71,12 +112,36 @@ struct _ClutterBox2DChildPrivate {
   gfloat            old_x;   /* The last set position and rotation. */
   gfloat            old_y;   /* We store this to know when we need to resync */
   gdouble           old_rot; /* the box2d state with the Clutter state */
+
+  b2Vec2            prev_position; /* The body transform before the last */
+  float32           prev_angle;    /* step, used for interpolation */
+  gboolean          synced;  /* The actor shows the final resting state of
+                                the body, no need to sync while it sleeps */
+  gboolean          moved;   /* The child is queued in moved_children */
+  gboolean          awake;   /* The child is listed in awake_children */
+
+  gboolean          report_collisions; /* Report even without handlers */
+  gfloat            collision_threshold; /* Minimum impulse to report */
+  gboolean          has_handlers;  /* Cached check for contact handlers, */
+  guint             handlers_step; /* valid during this step */
 };
 
 ClutterBox2DChild * clutter_box2d_get_child (ClutterBox2D *box2d,
                                              ClutterActor *actor);
 void _clutter_box2d_sync_body (ClutterBox2D      *box2d,
                                ClutterBox2DChild *box2d_child);
+void _clutter_box2d_begin_fixture_batch (ClutterBox2D *box2d);
+void _clutter_box2d_refresh_shape (ClutterBox2D      *box2d,
+                                   ClutterBox2DChild *box2d_child);
+void _clutter_box2d_queue_sync_body (ClutterBox2D      *box2d,
+                                     ClutterBox2DChild *box2d_child);
+void _clutter_box2d_shape_ensure_scale (ClutterBox2DShape *shape,
+                                        gfloat             scale_factor);
+gboolean _clutter_box2d_child_reports_collisions (ClutterBox2DChild *box2d_child,
+                                                  guint              step);
+void _clutter_box2d_child_emit_contact (ClutterBox2DChild *box2d_child,
+                                        gboolean           begin,
+                                        ClutterActor      *other);
 
 G_END_DECLS
 
@@ -0,0 +1,143 @@
+/* clutter-box2d - Clutter box2d integration
+ *
+ * This file implements the C++ class that lets Box2D run parts of a
+ * simulation step on a pool of worker threads.
+ *
+ * Copyright 2010 Intel Corporation
+ * Licensed under the LGPL v2 or greater.
+ */
+
+#include "clutter-box2d-scheduler.h"
+
+__ClutterBox2DTaskScheduler::
+__ClutterBox2DTaskScheduler (gint n_threads)
+{
+#if !GLIB_CHECK_VERSION (2, 32, 0)
+  if (!g_thread_supported ())
+    g_thread_init (NULL);
+#endif
+
+  m_thread_count = MAX (n_threads, 1);
+  m_pending = 0;
+  m_task = NULL;
+  m_count = 0;
+  m_range = 1;
+  m_next = 0;
+
+#if GLIB_CHECK_VERSION (2, 32, 0)
+  g_mutex_init (&m_mutex_data);
+  g_cond_init (&m_cond_data);
+  m_mutex = &m_mutex_data;
+  m_cond = &m_cond_data;
+#else
+  m_mutex = g_mutex_new ();
+  m_cond = g_cond_new ();
+#endif
+
+  /* The thread calling ParallelFor() does its share of the work too, so
+   * the pool needs one thread less than we were asked for.
+   */
+  m_pool = NULL;
+  if (m_thread_count > 1)
+    m_pool = g_thread_pool_new (WorkerFunc, this, m_thread_count - 1,
+                                TRUE, NULL);
+  if (!m_pool)
+    m_thread_count = 1;
+}
+
+__ClutterBox2DTaskScheduler::~__ClutterBox2DTaskScheduler()
+{
+  if (m_pool)
+    g_thread_pool_free (m_pool, FALSE, TRUE);
+#if GLIB_CHECK_VERSION (2, 32, 0)
+  g_cond_clear (m_cond);
+  g_mutex_clear (m_mutex);
+#else
+  g_cond_free (m_cond);
+  g_mutex_free (m_mutex);
+#endif
+}
+
+int32
+__ClutterBox2DTaskScheduler::GetThreadCount() const
+{
+  return m_thread_count;
+}
+
+/**
+ * Executes ranges of the current task until none are left. Ranges are
+ * handed out on a first come, first served basis, so a thread that
+ * finishes early picks up work that would otherwise wait for a busy one.
+ */
+void
+__ClutterBox2DTaskScheduler::ExecuteRanges (gint thread_index)
+{
+  for (;;)
+    {
+#if GLIB_CHECK_VERSION (2, 32, 0)
+      gint begin = g_atomic_int_add (&m_next, m_range);
+#else
+      gint begin = g_atomic_int_exchange_and_add (&m_next, m_range);
+#endif
+
+      if (begin >= m_count)
+        break;
+
+      m_task->Execute (begin, MIN (begin + m_range, m_count), thread_index);
+    }
+}
+
+void
+__ClutterBox2DTaskScheduler::WorkerFunc (gpointer data,
+                                         gpointer user_data)
+{
+  __ClutterBox2DTaskScheduler *self =
+    static_cast<__ClutterBox2DTaskScheduler *>(user_data);
+
+  self->ExecuteRanges (GPOINTER_TO_INT (data));
+
+  g_mutex_lock (self->m_mutex);
+  if (--self->m_pending == 0)
+    g_cond_signal (self->m_cond);
+  g_mutex_unlock (self->m_mutex);
+}
+
+void
+__ClutterBox2DTaskScheduler::ParallelFor (b2Task *task,
+                                          int32   count,
+                                          int32   minRange)
+{
+  gint i, n_workers;
+
+  if (count <= 0)
+    return;
+
+  /* Split the work in a few ranges per thread, so uneven ranges even out */
+  m_range = MAX (minRange, count / (4 * m_thread_count));
+  m_range = MAX (m_range, 1);
+  n_workers = MIN (m_thread_count, (count + m_range - 1) / m_range) - 1;
+
+  if (n_workers <= 0)
+    {
+      task->Execute (0, count, 0);
+      return;
+    }
+
+  m_task = task;
+  m_count = count;
+  g_atomic_int_set (&m_next, 0);
+  m_pending = n_workers;
+
+  /* The calling thread has index 0, so the workers never get NULL */
+  for (i = 1; i <= n_workers; i++)
+    g_thread_pool_push (m_pool, GINT_TO_POINTER (i), NULL);
+
+  ExecuteRanges (0);
+
+  g_mutex_lock (m_mutex);
+  while (m_pending > 0)
+    g_cond_wait (m_cond, m_mutex);
+  g_mutex_unlock (m_mutex);
+
+  m_task = NULL;
+}
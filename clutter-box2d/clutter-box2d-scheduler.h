@@ -0,0 +1,46 @@
+/* clutter-box2d - Clutter box2d integration
+ *
+ * This file declares the C++ class that lets Box2D run parts of a
+ * simulation step on a pool of worker threads.
+ *
+ * Copyright 2010 Intel Corporation
+ * Licensed under the LGPL v2 or greater.
+ */
+
+#ifndef _CLUTTER_BOX2D_SCHEDULER_H
+#define _CLUTTER_BOX2D_SCHEDULER_H
+
+#include <glib.h>
+#include "Box2D.h"         /* b2TaskScheduler, b2Task */
+
+class __ClutterBox2DTaskScheduler : public b2TaskScheduler
+{
+private:
+  GThreadPool     *m_pool;
+  GMutex          *m_mutex;
+  GCond           *m_cond;
+#if GLIB_CHECK_VERSION (2, 32, 0)
+  GMutex           m_mutex_data; /* What the above point at */
+  GCond            m_cond_data;
+#endif
+  gint             m_thread_count;
+  gint             m_pending;  /* Workers still busy with the current task */
+
+  /* The task being executed and the next range of it to hand out */
+  b2Task          *m_task;
+  gint             m_count;
+  gint             m_range;
+  volatile gint    m_next;
+
+public:
+  __ClutterBox2DTaskScheduler(gint n_threads);
+  ~__ClutterBox2DTaskScheduler();
+  int32 GetThreadCount() const;
+  void ParallelFor(b2Task* task, int32 count, int32 minRange);
+
+private:
+  void ExecuteRanges(gint thread_index);
+  static void WorkerFunc(gpointer data, gpointer user_data);
+};
+
+#endif
@@ -0,0 +1,145 @@
+/* clutter-box2d - Clutter box2d integration
+ *
+ * This file implements ClutterBox2DShape, a physical shape that can be
+ * shared by many children of a ClutterBox2D container.
+ *
+ * Copyright 2010 Intel Corporation
+ * Licensed under the LGPL v2 or greater.
+ */
+
+#include "Box2D.h"
+#include <clutter/clutter.h>
+#include "clutter-box2d.h"
+#include "clutter-box2d-shape.h"
+#include "clutter-box2d-private.h"
+
+GType
+clutter_box2d_shape_get_type (void)
+{
+  static GType our_type = 0;
+
+  if (G_UNLIKELY (our_type == 0))
+    our_type = g_boxed_type_register_static ("ClutterBox2DShape",
+                                   (GBoxedCopyFunc) clutter_box2d_shape_ref,
+                                   (GBoxedFreeFunc) clutter_box2d_shape_unref);
+
+  return our_type;
+}
+
+static ClutterBox2DShape *
+clutter_box2d_shape_new (b2Shape *shape)
+{
+  ClutterBox2DShape *self = g_slice_new0 (ClutterBox2DShape);
+
+  self->ref_count = 1;
+  self->shape = shape;
+
+  return self;
+}
+
+ClutterBox2DShape *
+clutter_box2d_shape_new_box (gfloat width,
+                             gfloat height)
+{
+  ClutterBox2DShape *self = clutter_box2d_shape_new (new b2PolygonShape ());
+
+  self->width = width;
+  self->height = height;
+
+  return self;
+}
+
+ClutterBox2DShape *
+clutter_box2d_shape_new_circle (gfloat radius)
+{
+  ClutterBox2DShape *self = clutter_box2d_shape_new (new b2CircleShape ());
+
+  self->width = self->height = radius * 2;
+
+  return self;
+}
+
+ClutterBox2DShape *
+clutter_box2d_shape_new_outline (const ClutterVertex *outline,
+                                 guint                n_vertices)
+{
+  ClutterBox2DShape *self;
+
+  g_return_val_if_fail (outline != NULL, NULL);
+  g_return_val_if_fail (n_vertices > 2 &&
+                        n_vertices <= b2_maxPolygonVertices, NULL);
+
+  self = clutter_box2d_shape_new (new b2PolygonShape ());
+  self->outline = (ClutterVertex *)
+    g_memdup (outline, sizeof (ClutterVertex) * n_vertices);
+  self->n_vertices = n_vertices;
+
+  return self;
+}
+
+ClutterBox2DShape *
+clutter_box2d_shape_ref (ClutterBox2DShape *shape)
+{
+  g_return_val_if_fail (shape != NULL, NULL);
+
+  g_atomic_int_inc (&shape->ref_count);
+
+  return shape;
+}
+
+void
+clutter_box2d_shape_unref (ClutterBox2DShape *shape)
+{
+  g_return_if_fail (shape != NULL);
+
+  if (!g_atomic_int_dec_and_test (&shape->ref_count))
+    return;
+
+  delete shape->shape;
+  g_free (shape->outline);
+  g_slice_free (ClutterBox2DShape, shape);
+}
+
+/* Compute the geometry and mass of a shape for the given scale factor,
+ * unless that was already done for the last container that used it.
+ */
+void
+_clutter_box2d_shape_ensure_scale (ClutterBox2DShape *shape,
+                                   gfloat             scale_factor)
+{
+  if (shape->scale_factor == scale_factor)
+    return;
+
+  shape->scale_factor = scale_factor;
+
+  if (shape->shape->GetType () == b2Shape::e_circle)
+    {
+      b2CircleShape *circle = static_cast<b2CircleShape *>(shape->shape);
+
+      circle->m_radius = shape->width * 0.5 * scale_factor;
+      circle->m_p.Set (circle->m_radius, circle->m_radius);
+    }
+  else if (shape->outline)
+    {
+      guint i;
+      b2Vec2 b2outline[b2_maxPolygonVertices];
+      b2PolygonShape *polygon = static_cast<b2PolygonShape *>(shape->shape);
+
+      for (i = 0; i < shape->n_vertices; i++)
+        b2outline[i].Set (shape->outline[i].x * scale_factor,
+                          shape->outline[i].y * scale_factor);
+      polygon->Set (b2outline, i);
+    }
+  else
+    {
+      b2PolygonShape *polygon = static_cast<b2PolygonShape *>(shape->shape);
+
+      polygon->SetAsBox (shape->width * 0.5 * scale_factor,
+                         shape->height * 0.5 * scale_factor,
+                         b2Vec2 (shape->width * 0.5 * scale_factor,
+                                 shape->height * 0.5 * scale_factor), 0);
+    }
+
+  /* Scaled by the density of each body using the shape */
+  shape->shape->ComputeMass (&shape->mass, 1.f);
+}
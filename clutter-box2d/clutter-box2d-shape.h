@@ -0,0 +1,109 @@
+/* clutter-box2d - Clutter box2d integration
+ *
+ * This file declares ClutterBox2DShape, a physical shape that can be
+ * shared by many children of a ClutterBox2D container.
+ *
+ * Copyright 2010 Intel Corporation
+ * Licensed under the LGPL v2 or greater.
+ */
+
+#ifndef _CLUTTER_BOX2D_SHAPE_H
+#define _CLUTTER_BOX2D_SHAPE_H
+
+#include <clutter/clutter.h>
+
+G_BEGIN_DECLS
+
+/**
+ * SECTION:clutter-box2d-shape
+ * @short_description: Shapes shared between actors
+ *
+ * By default the physical shape of an actor in a #ClutterBox2D container
+ * is derived from the size of the actor, and every actor gets a shape of
+ * its own. When many actors have the same shape, for example a grid of
+ * identical tiles, a #ClutterBox2DShape can be created once and assigned
+ * to all of them with clutter_box2d_child_set_shape(). The geometry and
+ * mass of the shape are then only computed once, and adding another actor
+ * with that shape to the simulation doesn't construct a new shape.
+ *
+ * Unlike the default shape, a shared shape has a fixed size in pixels and
+ * does not follow the size of the actors using it. A shape may be used in
+ * several #ClutterBox2D containers, as long as they all use the same
+ * #ClutterBox2D:scale-factor.
+ */
+
+#define CLUTTER_TYPE_BOX2D_SHAPE    (clutter_box2d_shape_get_type ())
+
+/**
+ * ClutterBox2DShape:
+ *
+ * A reference counted handle to a shape shared between actors. The
+ * contents of this structure are private.
+ */
+typedef struct _ClutterBox2DShape ClutterBox2DShape;
+
+GType clutter_box2d_shape_get_type (void) G_GNUC_CONST;
+
+/**
+ * clutter_box2d_shape_new_box:
+ * @width: the width of the box, in pixels
+ * @height: the height of the box, in pixels
+ *
+ * Creates a rectangular shape, with its top-left corner at the position
+ * of the actors using it.
+ *
+ * Returns: a new #ClutterBox2DShape, free with clutter_box2d_shape_unref()
+ */
+ClutterBox2DShape *clutter_box2d_shape_new_box (gfloat width,
+                                                gfloat height);
+
+/**
+ * clutter_box2d_shape_new_circle:
+ * @radius: the radius of the circle, in pixels
+ *
+ * Creates a circular shape, fitting in a square of twice @radius with its
+ * top-left corner at the position of the actors using it. Actors with this
+ * shape rotate around their position, like actors with box shapes, rather
+ * than around their centre as with #ClutterBox2DChild:is-circle.
+ *
+ * Returns: a new #ClutterBox2DShape, free with clutter_box2d_shape_unref()
+ */
+ClutterBox2DShape *clutter_box2d_shape_new_circle (gfloat radius);
+
+/**
+ * clutter_box2d_shape_new_outline:
+ * @outline: an array of #ClutterVertex, in pixels relative to the position
+ *   of the actors using the shape
+ * @n_vertices: the amount of vertices in @outline, at least 3 and at most 8
+ *
+ * Creates a convex polygon shape. The vertices are given in the same order
+ * as for the #ClutterBox2DChild:outline child property, but in pixels
+ * rather than relative to the size of the actor.
+ *
+ * Returns: a new #ClutterBox2DShape, free with clutter_box2d_shape_unref()
+ */
+ClutterBox2DShape *clutter_box2d_shape_new_outline (const ClutterVertex *outline,
+                                                    guint                n_vertices);
+
+/**
+ * clutter_box2d_shape_ref:
+ * @shape: a #ClutterBox2DShape
+ *
+ * Increases the reference count of @shape.
+ *
+ * Returns: @shape
+ */
+ClutterBox2DShape *clutter_box2d_shape_ref (ClutterBox2DShape *shape);
+
+/**
+ * clutter_box2d_shape_unref:
+ * @shape: a #ClutterBox2DShape
+ *
+ * Decreases the reference count of @shape, freeing it when no actors or
+ * other references are left.
+ */
+void clutter_box2d_shape_unref (ClutterBox2DShape *shape);
+
+G_END_DECLS
+
+#endif
@@ -16,7 +16,9 @@
 #include "clutter-box2d.h"
 #include "clutter-box2d-child.h"
 #include "clutter-box2d-contact.h"
+#include "clutter-box2d-scheduler.h"
 #include "clutter-box2d-private.h"
+#include "clutter-box2d-marshal.h"
 #include "math.h"
 
 static void clutter_container_iface_init (ClutterContainerIface *iface);
@@ -39,15 +41,34 @@ enum
   PROP_SCALE_FACTOR,
   PROP_TIME_STEP,
   PROP_ITERATIONS,
-  PROP_SIMULATE_INACTIVE
+  PROP_SIMULATE_INACTIVE,
+  PROP_MAX_SUBSTEPS,
+  PROP_WORKER_THREADS,
+  PROP_INTERPOLATION,
+  PROP_BROAD_PHASE,
+  PROP_GRID_CELL_SIZE
 };
 
+enum
+{
+  COLLISIONS,
+  LAST_SIGNAL
+};
+
+static guint box2d_signals[LAST_SIGNAL];
+static guint child_collision_signal;
+
 static GObject * clutter_box2d_constructor (GType                  type,
                                             guint                  n_params,
                                             GObjectConstructParam *params);
 static void      clutter_box2d_dispose     (GObject               *object);
 
-static gboolean  clutter_box2d_iterate     (ClutterBox2D          *box2d);
+static void      clutter_box2d_new_frame   (ClutterTimeline       *timeline,
+                                            gint                   msecs,
+                                            ClutterBox2D          *box2d);
+
+static void      update_task_scheduler     (ClutterBox2D          *box2d);
+static void      update_broad_phase        (ClutterBox2D          *box2d);
 
 ClutterBox2DChild *
 clutter_box2d_get_child (ClutterBox2D *box2d,
@@ -65,21 +86,21 @@ clutter_box2d_get_child (ClutterBox2D *box2d,
 static void
 start_simulation (ClutterBox2D *self)
 {
-  if (!self->priv->iterate_id)
-    self->priv->iterate_id =
-      g_timeout_add_full (CLUTTER_PRIORITY_REDRAW, self->priv->time_step,
-                          (GSourceFunc)clutter_box2d_iterate,
-                          self, NULL);
+  ClutterBox2DPrivate *priv = self->priv;
+
+  if (!clutter_timeline_is_playing (priv->timeline))
+    {
+      /* Don't try to catch up on the time spent paused */
+      priv->accumulator = 0;
+      clutter_timeline_start (priv->timeline);
+    }
 }
 
 static void
 stop_simulation (ClutterBox2D *self)
 {
-  if (self->priv->iterate_id)
-    {
-      g_source_remove (self->priv->iterate_id);
-      self->priv->iterate_id = 0;
-    }
+  if (self->priv->timeline)
+    clutter_timeline_stop (self->priv->timeline);
 }
 
 static void
@@ -124,8 +145,6 @@ clutter_box2d_set_property (GObject      *gobject,
         if (box2d->priv->time_step != time_step)
           {
             box2d->priv->time_step = time_step;
-            stop_simulation (box2d);
-            start_simulation (box2d);
             g_object_notify (gobject, "time-step");
           }
       }
@@ -145,6 +164,50 @@ clutter_box2d_set_property (GObject      *gobject,
         box2d->priv->simulate_inactive = g_value_get_boolean (value);
       }
       break;
+    case PROP_MAX_SUBSTEPS:
+      {
+        gint max_substeps = g_value_get_int (value);
+        if (box2d->priv->max_substeps != max_substeps)
+          {
+            box2d->priv->max_substeps = max_substeps;
+            g_object_notify (gobject, "max-substeps");
+          }
+      }
+      break;
+    case PROP_WORKER_THREADS:
+      {
+        gint worker_threads = g_value_get_int (value);
+        if (box2d->priv->worker_threads != worker_threads)
+          {
+            box2d->priv->worker_threads = worker_threads;
+            if (box2d->priv->world)
+              update_task_scheduler (box2d);
+            g_object_notify (gobject, "worker-threads");
+          }
+      }
+      break;
+    case PROP_INTERPOLATION:
+      {
+        ClutterBox2DInterpolation interpolation =
+          (ClutterBox2DInterpolation) g_value_get_int (value);
+        if (box2d->priv->interpolation != interpolation)
+          {
+            box2d->priv->interpolation = interpolation;
+            g_object_notify (gobject, "interpolation");
+          }
+      }
+      break;
+    case PROP_BROAD_PHASE:
+      {
+        box2d->priv->broad_phase =
+          (ClutterBox2DBroadPhase) g_value_get_int (value);
+      }
+      break;
+    case PROP_GRID_CELL_SIZE:
+      {
+        box2d->priv->grid_cell_size = g_value_get_float (value);
+      }
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (gobject, prop_id, pspec);
       break;
@@ -189,12 +252,121 @@ clutter_box2d_get_property (GObject    *gobject,
       g_value_set_boolean (value, box2d->priv->simulate_inactive);
       break;
 
+    case PROP_MAX_SUBSTEPS:
+      g_value_set_int (value, box2d->priv->max_substeps);
+      break;
+    case PROP_WORKER_THREADS:
+      g_value_set_int (value, box2d->priv->worker_threads);
+      break;
+
+    case PROP_INTERPOLATION:
+      g_value_set_int (value, box2d->priv->interpolation);
+      break;
+
+    case PROP_BROAD_PHASE:
+      g_value_set_int (value, box2d->priv->broad_phase);
+      break;
+    case PROP_GRID_CELL_SIZE:
+      g_value_set_float (value, box2d->priv->grid_cell_size);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (gobject, prop_id, pspec);
       break;
     }
 }
 
+/* Replaces the worker threads of the world to match the worker-threads
+ * property. A single thread doesn't need a scheduler at all.
+ */
+static void
+update_task_scheduler (ClutterBox2D *box2d)
+{
+  ClutterBox2DPrivate *priv = box2d->priv;
+
+  priv->world->SetTaskScheduler (NULL);
+  if (priv->task_scheduler)
+    {
+      delete priv->task_scheduler;
+      priv->task_scheduler = NULL;
+    }
+
+  if (priv->worker_threads > 1)
+    {
+      priv->task_scheduler =
+        new __ClutterBox2DTaskScheduler (priv->worker_threads);
+      priv->world->SetTaskScheduler (priv->task_scheduler);
+    }
+}
+
+/* Switches the world to the broad-phase of the broad-phase property. The
+ * grid cells are sized in pixels, so the grid is rebuilt when the scale
+ * factor changes.
+ */
+static void
+update_broad_phase (ClutterBox2D *box2d)
+{
+  ClutterBox2DPrivate *priv = box2d->priv;
+
+  switch (priv->broad_phase)
+    {
+    case CLUTTER_BOX2D_BROAD_PHASE_SWEEP:
+      priv->world->SetBroadPhase (b2_sweepBroadPhase, 0.0f);
+      break;
+    case CLUTTER_BOX2D_BROAD_PHASE_GRID:
+      priv->world->SetBroadPhase (b2_gridBroadPhase,
+                                  priv->grid_cell_size * priv->scale_factor);
+      break;
+    default:
+      break;
+    }
+}
+
+static gboolean
+end_fixture_batch_idle (gpointer data)
+{
+  ClutterBox2D *box2d = CLUTTER_BOX2D (data);
+
+  box2d->priv->fixture_batch_id = 0;
+  box2d->priv->world->EndFixtureBatch ();
+
+  return FALSE;
+}
+
+static void
+end_fixture_batch (ClutterBox2D *box2d)
+{
+  ClutterBox2DPrivate *priv = box2d->priv;
+
+  if (priv->fixture_batch_id)
+    {
+      g_source_remove (priv->fixture_batch_id);
+      priv->fixture_batch_id = 0;
+      priv->world->EndFixtureBatch ();
+    }
+}
+
+/* Children that get a body, such as all the children of a scene that is
+ * being loaded, have their fixtures added to the broad-phase as one batch.
+ * That builds the tree top-down, quicker than adding them one by one. The
+ * broad-phase leaves the new fixtures out until the batch ends, so it is
+ * ended from an idle once the additions are over, and at the latest before
+ * the world is stepped.
+ */
+void
+_clutter_box2d_begin_fixture_batch (ClutterBox2D *box2d)
+{
+  ClutterBox2DPrivate *priv = box2d->priv;
+
+  if (priv->fixture_batch_id)
+    return;
+
+  priv->world->BeginFixtureBatch ();
+  priv->fixture_batch_id = g_idle_add_full (G_PRIORITY_HIGH_IDLE,
+                                            end_fixture_batch_idle,
+                                            box2d, NULL);
+}
+
 static void
 clutter_box2d_constructed (GObject *gobject)
 {
@@ -213,6 +385,9 @@ clutter_box2d_constructed (GObject *gobject)
   priv->contact_listener = (_ClutterBox2DContactListener *)
     new __ClutterBox2DContactListener (self);
 
+  update_task_scheduler (self);
+  update_broad_phase (self);
+
   priv->ground_body = priv->world->CreateBody (&bodyDef);
 
   start_simulation (self);
@@ -234,6 +409,16 @@ clutter_box2d_class_init (ClutterBox2DClass *klass)
 
   g_type_class_add_private (gobject_class, sizeof (ClutterBox2DPrivate));
 
+  box2d_signals[COLLISIONS] = g_signal_new ("collisions",
+                                 G_TYPE_FROM_CLASS (gobject_class),
+                                 G_SIGNAL_RUN_LAST,
+                                 0,
+                                 NULL, NULL,
+                                 _clutter_box2d_marshal_VOID__POINTER_UINT,
+                                 G_TYPE_NONE, 2,
+                                 G_TYPE_POINTER,
+                                 G_TYPE_UINT);
+
   /* gravity can only be set, not get */
   g_object_class_install_property (gobject_class,
                                    PROP_GRAVITY,
@@ -282,6 +467,50 @@ clutter_box2d_class_init (ClutterBox2DClass *klass)
                                                          "Whether to simulate inactive bodies",
                                                          TRUE,
                                                          static_cast<GParamFlags>(G_PARAM_READWRITE|G_PARAM_CONSTRUCT_ONLY)));
+
+  g_object_class_install_property (gobject_class,
+                                   PROP_MAX_SUBSTEPS,
+                                   g_param_spec_int ("max-substeps",
+                                                     "Maximum sub-steps",
+                                                     "The maximum amount of physics steps to perform in a single frame",
+                                                     1, G_MAXINT, 4,
+                                                     static_cast<GParamFlags>(G_PARAM_READWRITE)));
+
+  g_object_class_install_property (gobject_class,
+                                   PROP_WORKER_THREADS,
+                                   g_param_spec_int ("worker-threads",
+                                                     "Worker threads",
+                                                     "The amount of threads to simulate independent groups of bodies on",
+                                                     1, 64, 1,
+                                                     static_cast<GParamFlags>(G_PARAM_READWRITE)));
+
+  g_object_class_install_property (gobject_class,
+                                   PROP_INTERPOLATION,
+                                   g_param_spec_int ("interpolation",
+                                                     "Interpolation",
+                                                     "How actors are positioned in between physics steps",
+                                                     CLUTTER_BOX2D_INTERPOLATION_NONE,
+                                                     CLUTTER_BOX2D_INTERPOLATION_EXTRAPOLATE,
+                                                     CLUTTER_BOX2D_INTERPOLATION_NONE,
+                                                     static_cast<GParamFlags>(G_PARAM_READWRITE)));
+
+  g_object_class_install_property (gobject_class,
+                                   PROP_BROAD_PHASE,
+                                   g_param_spec_int ("broad-phase",
+                                                     "Broad-phase",
+                                                     "How pairs of possibly touching shapes are found",
+                                                     CLUTTER_BOX2D_BROAD_PHASE_TREE,
+                                                     CLUTTER_BOX2D_BROAD_PHASE_GRID,
+                                                     CLUTTER_BOX2D_BROAD_PHASE_TREE,
+                                                     static_cast<GParamFlags>(G_PARAM_READWRITE|G_PARAM_CONSTRUCT_ONLY)));
+
+  g_object_class_install_property (gobject_class,
+                                   PROP_GRID_CELL_SIZE,
+                                   g_param_spec_float ("grid-cell-size",
+                                                       "Grid cell size",
+                                                       "The size of a cell of the grid broad-phase, in pixels",
+                                                       1.f, G_MAXFLOAT, 64.f,
+                                                       static_cast<GParamFlags>(G_PARAM_READWRITE|G_PARAM_CONSTRUCT_ONLY)));
 }
 
 static void
@@ -296,12 +525,30 @@ clutter_box2d_init (ClutterBox2D *self)
   priv->iterations = 10;
   priv->time_step  = 1000 / 60.f;
   priv->simulate_inactive = TRUE;
+  priv->max_substeps = 4;
+  priv->worker_threads = 1;
+  priv->broad_phase = CLUTTER_BOX2D_BROAD_PHASE_TREE;
+  priv->grid_cell_size = 64.f;
 
   priv->scale_factor     = 1/50.f;
   priv->inv_scale_factor = 1.f / priv->scale_factor;
 
   priv->actors = g_hash_table_new (g_direct_hash, g_direct_equal);
-  priv->bodies = g_hash_table_new (g_direct_hash, g_direct_equal);
+  priv->children = g_ptr_array_new ();
+  priv->moved_children = g_ptr_array_new ();
+  priv->awake_children = g_ptr_array_new ();
+  priv->collisions = g_array_new (FALSE, FALSE,
+                                  sizeof (ClutterBox2DCollisionRecord));
+  priv->contact_events = g_array_new (FALSE, FALSE,
+                                      sizeof (ClutterBox2DContactEvent));
+
+  /* The simulation is stepped from a looping timeline, so that it is
+   * driven by the master clock and stays in phase with painting.
+   */
+  priv->timeline = clutter_timeline_new (1000);
+  clutter_timeline_set_loop (priv->timeline, TRUE);
+  g_signal_connect (priv->timeline, "new-frame",
+                    G_CALLBACK (clutter_box2d_new_frame), self);
 }
 
 ClutterActor *
@@ -332,16 +579,51 @@ clutter_box2d_dispose (GObject *object)
   G_OBJECT_CLASS (clutter_box2d_parent_class)->dispose (object);
 
   stop_simulation (self);
+  end_fixture_batch (self);
+
+  if (priv->timeline)
+    {
+      g_signal_handlers_disconnect_by_func (priv->timeline,
+                                            (gpointer)clutter_box2d_new_frame,
+                                            self);
+      g_object_unref (priv->timeline);
+      priv->timeline = NULL;
+    }
 
   if (priv->actors)
     {
       g_hash_table_destroy (priv->actors);
       priv->actors = NULL;
     }
-  if (priv->bodies)
+  if (priv->children)
     {
-      g_hash_table_destroy (priv->bodies);
-      priv->bodies = NULL;
+      g_ptr_array_free (priv->children, TRUE);
+      priv->children = NULL;
+    }
+  if (priv->moved_children)
+    {
+      g_ptr_array_free (priv->moved_children, TRUE);
+      priv->moved_children = NULL;
+    }
+  if (priv->awake_children)
+    {
+      g_ptr_array_free (priv->awake_children, TRUE);
+      priv->awake_children = NULL;
+    }
+  if (priv->collisions)
+    {
+      g_array_free (priv->collisions, TRUE);
+      priv->collisions = NULL;
+    }
+  if (priv->collision)
+    {
+      g_object_unref (priv->collision);
+      priv->collision = NULL;
+    }
+  if (priv->contact_events)
+    {
+      g_array_free (priv->contact_events, TRUE);
+      priv->contact_events = NULL;
     }
 
   if (priv->contact_listener)
@@ -349,6 +631,13 @@ clutter_box2d_dispose (GObject *object)
       delete (__ClutterBox2DContactListener *)priv->contact_listener;
       priv->contact_listener = NULL;
     }
+
+  if (priv->task_scheduler)
+    {
+      priv->world->SetTaskScheduler (NULL);
+      delete priv->task_scheduler;
+      priv->task_scheduler = NULL;
+    }
 }
 
 
@@ -372,6 +661,9 @@ clutter_box2d_create_child_meta (ClutterContainer *container,
   box2d_child->priv->world = priv->world;
 
   g_hash_table_insert (priv->actors, actor, child_meta);
+
+  box2d_child->priv->index = priv->children->len;
+  g_ptr_array_add (priv->children, box2d_child);
 }
 
 static void
@@ -382,12 +674,25 @@ clutter_box2d_destroy_child_meta (ClutterContainer *box2d,
   ClutterBox2DChild *box2d_child =
      CLUTTER_BOX2D_CHILD (clutter_container_get_child_meta ( box2d, actor));
   ClutterBox2DPrivate *priv = CLUTTER_BOX2D (box2d)->priv;
-  b2Body *body = box2d_child->priv->body;
+  guint index = box2d_child->priv->index;
+
+  if (box2d_child->priv->moved)
+    g_ptr_array_remove_fast (priv->moved_children, box2d_child);
+  if (box2d_child->priv->awake)
+    g_ptr_array_remove_fast (priv->awake_children, box2d_child);
+
+  /* Remove the child by moving the last one into its place */
+  g_ptr_array_remove_index_fast (priv->children, index);
+  if (index < priv->children->len)
+    {
+      ClutterBox2DChild *moved =
+        (ClutterBox2DChild *) g_ptr_array_index (priv->children, index);
+      moved->priv->index = index;
+    }
 
   g_object_unref (box2d_child);
 
   g_hash_table_remove (priv->actors, actor);
-  g_hash_table_remove (priv->bodies, body);
 }
 
 static ClutterChildMeta *
@@ -407,6 +712,127 @@ static void clutter_container_iface_init (ClutterContainerIface *iface)
   iface->get_child_meta = clutter_box2d_get_child_meta;
 }
 
+/* Whether the body of a child is at the centre of its actor rather than at
+ * its position, which is the case for circles sized after their actor.
+ */
+static inline gboolean
+is_centred (ClutterBox2DChild *box2d_child)
+{
+  return box2d_child->priv->is_circle && !box2d_child->priv->shape;
+}
+
+/* Compute the geometry of the shape of a child from the size of its actor,
+ * in world units. Either @circle or @polygon is filled in and returned.
+ */
+static b2Shape *
+compute_shape (ClutterBox2D      *box2d,
+               ClutterBox2DChild *box2d_child,
+               b2CircleShape     *circle,
+               b2PolygonShape    *polygon)
+{
+  gfloat width, height;
+  ClutterBox2DPrivate *priv = box2d->priv;
+  ClutterChildMeta *meta = CLUTTER_CHILD_META (box2d_child);
+
+  clutter_actor_get_size (meta->actor, &width, &height);
+
+  if (box2d_child->priv->is_circle)
+    {
+      circle->m_radius = MIN (width, height) * 0.5 * priv->scale_factor;
+      return circle;
+    }
+  else if (box2d_child->priv->outline)
+    {
+      gint i;
+      b2Vec2* b2outline = box2d_child->priv->b2outline;
+      ClutterVertex *vertices = box2d_child->priv->outline;
+
+      for (i = 0; i < box2d_child->priv->n_vertices; i++)
+        b2outline[i].Set(vertices[i].x * width * priv->scale_factor,
+                         vertices[i].y * height * priv->scale_factor);
+      polygon->Set(b2outline, i);
+      return polygon;
+    }
+  else
+    {
+      polygon->SetAsBox (width * 0.5 * priv->scale_factor,
+                         height * 0.5 * priv->scale_factor,
+                         b2Vec2 (width * 0.5 * priv->scale_factor,
+                         height * 0.5 * priv->scale_factor), 0);
+      return polygon;
+    }
+}
+
+/* List the child among those whose actors are synchronised after each
+ * frame, until its body rests and the actor shows where it rests.
+ */
+static inline void
+queue_sync_actor (ClutterBox2D *box2d, ClutterBox2DChild *box2d_child)
+{
+  if (box2d_child->priv->awake)
+    return;
+
+  box2d_child->priv->awake = TRUE;
+  g_ptr_array_add (box2d->priv->awake_children, box2d_child);
+}
+
+/* Update the existing fixture of a child to match the size, outline and
+ * material of the child. Unlike recreating the fixture this keeps the
+ * broad-phase proxy and the contacts of the fixture, so their impulses
+ * carry over. Returns FALSE if the kind of shape or the amount of vertices
+ * changed, in which case the fixture has to be recreated instead.
+ */
+static gboolean
+resize_shape (ClutterBox2D *box2d, ClutterBox2DChild *box2d_child)
+{
+  b2Fixture *fixture = box2d_child->priv->fixture;
+  b2Shape *old_shape = fixture->GetShape ();
+
+  if (box2d_child->priv->shape)
+    {
+      /* Shared shapes are rescaled by the first child to get here */
+      _clutter_box2d_shape_ensure_scale (box2d_child->priv->shape,
+                                         box2d->priv->scale_factor);
+      if (old_shape != box2d_child->priv->shape->shape)
+        return FALSE;
+    }
+  else
+    {
+      b2CircleShape circle;
+      b2PolygonShape polygon;
+      b2Shape *shape = compute_shape (box2d, box2d_child, &circle, &polygon);
+
+      if (shape->GetType () != old_shape->GetType ())
+        return FALSE;
+
+      if (shape == &circle)
+        *static_cast<b2CircleShape *>(old_shape) = circle;
+      else
+        {
+          b2PolygonShape *old_polygon =
+            static_cast<b2PolygonShape *>(old_shape);
+
+          /* Box2D caches vertex indices of polygons in contacts */
+          if (old_polygon->GetVertexCount () != polygon.GetVertexCount ())
+            return FALSE;
+
+          *old_polygon = polygon;
+        }
+    }
+
+  fixture->SetDensity (box2d_child->priv->density);
+  fixture->SetFriction (box2d_child->priv->friction);
+  fixture->SetRestitution (box2d_child->priv->restitution);
+
+  box2d_child->priv->body->RefreshFixture (fixture);
+
+  /* The actor may need to be offset differently for the new size */
+  box2d_child->priv->synced = FALSE;
+  queue_sync_actor (box2d, box2d_child);
+
+  return TRUE;
+}
+
 /* make sure that the shape attached to the body matches the clutter realms
  * idea of the shape.
  */
@@ -415,8 +841,9 @@ ensure_shape (ClutterBox2D *box2d, ClutterBox2DChild *box2d_child)
 {
   ClutterBox2DPrivate *priv = box2d->priv;
 
-  /* If the dirty flag is set, forcibly recreate the fixture */
-  if (priv->dirty && box2d_child->priv->fixture)
+  /* If the dirty flag is set, rescale the fixture */
+  if (priv->dirty && box2d_child->priv->fixture &&
+      !resize_shape (box2d, box2d_child))
     {
       box2d_child->priv->body->DestroyFixture (box2d_child->priv->fixture);
       box2d_child->priv->fixture = NULL;
@@ -424,50 +851,72 @@ ensure_shape (ClutterBox2D *box2d, ClutterBox2DChild *box2d_child)
 
   if (box2d_child->priv->fixture == NULL)
     {
-      gfloat width, height;
-      b2Shape *shape;
       b2FixtureDef fixture;
       b2CircleShape circle;
       b2PolygonShape polygon;
-      ClutterChildMeta *meta = CLUTTER_CHILD_META (box2d_child);
+      ClutterBox2DShape *shape = box2d_child->priv->shape;
 
-      clutter_actor_get_size (meta->actor, &width, &height);
-
-      if (box2d_child->priv->is_circle)
+      if (shape)
         {
-
-          circle.m_radius = MIN (width, height) * 0.5 * priv->scale_factor;
-          shape = &circle;
-        }
-      else if (box2d_child->priv->outline)
-        {
-          gint i;
-          b2Vec2* b2outline = box2d_child->priv->b2outline;
-          ClutterVertex *vertices = box2d_child->priv->outline;
-
-          for (i = 0; i < box2d_child->priv->n_vertices; i++)
-            b2outline[i].Set(vertices[i].x * width * priv->scale_factor,
-                             vertices[i].y * height * priv->scale_factor);
-          polygon.Set(b2outline, i);
-          shape = &polygon;
+          /* Use the shared shape as it is, and its precomputed mass
+           * instead of having the body compute the mass of the fixture.
+           */
+          _clutter_box2d_shape_ensure_scale (shape, priv->scale_factor);
+          fixture.shape = shape->shape;
+          fixture.shareShape = true;
+          fixture.density = 0;
         }
       else
         {
-          polygon.SetAsBox (width * 0.5 * priv->scale_factor,
-                            height * 0.5 * priv->scale_factor,
-                            b2Vec2 (width * 0.5 * priv->scale_factor,
-                            height * 0.5 * priv->scale_factor), 0);
-          shape = &polygon;
+          fixture.shape = compute_shape (box2d, box2d_child, &circle, &polygon);
+          fixture.density = box2d_child->priv->density;
         }
-
-      fixture.shape = shape;
       fixture.friction = box2d_child->priv->friction;
-      fixture.density = box2d_child->priv->density;
       fixture.restitution = box2d_child->priv->restitution;
 
       box2d_child->priv->fixture =
         box2d_child->priv->body->CreateFixture (&fixture);
+
+      if (shape && box2d_child->priv->density > 0)
+        {
+          b2MassData mass = shape->mass;
+
+          mass.mass *= box2d_child->priv->density;
+          mass.I *= box2d_child->priv->density;
+
+          box2d_child->priv->fixture->SetDensity (box2d_child->priv->density);
+          box2d_child->priv->body->SetMassData (&mass);
+        }
+
+      /* The actor may need to be offset differently for the new shape */
+      box2d_child->priv->synced = FALSE;
+      queue_sync_actor (box2d, box2d_child);
+    }
+}
+
+/* Called when the size, outline or material of a child changes, update
+ * its fixture in place when possible and recreate it otherwise.
+ */
+void
+_clutter_box2d_refresh_shape (ClutterBox2D      *box2d,
+                              ClutterBox2DChild *box2d_child)
+{
+  if (!box2d_child->priv->fixture)
+    return;
+
+  if (resize_shape (box2d, box2d_child))
+    {
+      /* Only circles are positioned relative to their size */
+      if (!is_centred (box2d_child))
+        return;
+    }
+  else
+    {
+      box2d_child->priv->body->DestroyFixture (box2d_child->priv->fixture);
+      box2d_child->priv->fixture = NULL;
     }
+
+  _clutter_box2d_sync_body (box2d, box2d_child);
 }
 
 
@@ -496,7 +945,7 @@ _clutter_box2d_sync_body (ClutterBox2D *box2d, ClutterBox2DChild *box2d_child)
   x = clutter_actor_get_x (actor);
   y = clutter_actor_get_y (actor);
 
-  if (box2d_child->priv->is_circle)
+  if (is_centred (box2d_child))
     {
       gfloat radius = MIN (clutter_actor_get_width (actor),
                            clutter_actor_get_height (actor)) / 2.f;
@@ -511,14 +960,46 @@ _clutter_box2d_sync_body (ClutterBox2D *box2d, ClutterBox2DChild *box2d_child)
   body->SetTransform (b2Vec2 (x * priv->scale_factor, y * priv->scale_factor),
                       rot / (180 / G_PI));
 
+  /* The body was moved from outside of the simulation, don't interpolate
+   * from wherever it was before.
+   */
+  box2d_child->priv->prev_position = body->GetPosition ();
+  box2d_child->priv->prev_angle = body->GetAngle ();
+  box2d_child->priv->synced = FALSE;
+  queue_sync_actor (box2d, box2d_child);
+
   SYNCLOG ("\t setxform: %d, %d, %f\n", x, y, rot);
 }
 
+/* Called when the position or rotation of a child actor changes, queue
+ * the change to be pushed to the body before the next step, unless it
+ * was us who moved the actor.
+ */
+void
+_clutter_box2d_queue_sync_body (ClutterBox2D      *box2d,
+                                ClutterBox2DChild *box2d_child)
+{
+  ClutterBox2DPrivate *priv = box2d->priv;
+
+  if (priv->syncing || box2d_child->priv->moved)
+    return;
+
+  box2d_child->priv->moved = TRUE;
+  g_ptr_array_add (priv->moved_children, box2d_child);
+}
+
+/* Synchronise the actor with the state of the body, @alpha is the fraction
+ * of a time-step that has passed since the last physics step.
+ */
 static void
-_clutter_box2d_sync_actor (ClutterBox2D *box2d, ClutterBox2DChild *box2d_child)
+_clutter_box2d_sync_actor (ClutterBox2D      *box2d,
+                           ClutterBox2DChild *box2d_child,
+                           gfloat             alpha)
 {
   gdouble rot;
   gfloat x, y, centre_x, centre_y;
+  b2Vec2 position;
+  float32 angle;
   ClutterBox2DPrivate *priv = box2d->priv;
   ClutterActor *actor = CLUTTER_CHILD_META (box2d_child)->actor;
   b2Body       *body  = box2d_child->priv->body;
@@ -528,10 +1009,37 @@ _clutter_box2d_sync_actor (ClutterBox2D *box2d, ClutterBox2DChild *box2d_child)
 
   ensure_shape (box2d, box2d_child);
 
-  x = body->GetPosition ().x * priv->inv_scale_factor;
-  y = body->GetPosition ().y * priv->inv_scale_factor;
+  position = body->GetPosition ();
+  angle = body->GetAngle ();
 
-  if (box2d_child->priv->is_circle)
+  /* Once the body stopped moving during a step, there is nothing left
+   * to interpolate and the position computed below is final.
+   */
+  box2d_child->priv->synced =
+    (position == box2d_child->priv->prev_position) &&
+    (angle == box2d_child->priv->prev_angle);
+
+  switch (priv->interpolation)
+    {
+    case CLUTTER_BOX2D_INTERPOLATION_INTERPOLATE:
+      position = (1.f - alpha) * box2d_child->priv->prev_position +
+                 alpha * position;
+      angle = (1.f - alpha) * box2d_child->priv->prev_angle + alpha * angle;
+      break;
+
+    case CLUTTER_BOX2D_INTERPOLATION_EXTRAPOLATE:
+      position += alpha * (position - box2d_child->priv->prev_position);
+      angle += alpha * (angle - box2d_child->priv->prev_angle);
+      break;
+
+    default:
+      break;
+    }
+
+  x = position.x * priv->inv_scale_factor;
+  y = position.y * priv->inv_scale_factor;
+
+  if (is_centred (box2d_child))
     {
       gfloat width = clutter_actor_get_width (actor);
       gfloat height = clutter_actor_get_height (actor);
@@ -549,14 +1057,31 @@ _clutter_box2d_sync_actor (ClutterBox2D *box2d, ClutterBox2DChild *box2d_child)
       centre_y = 0;
     }
 
-  rot = body->GetAngle () * (180 / G_PI);
+  rot = angle * (180 / G_PI);
+
+  /* Avoid needless notifications and relayouts for unchanged actors */
+  if ((box2d_child->priv->old_x == x) &&
+      (box2d_child->priv->old_y == y) &&
+      (box2d_child->priv->old_rot == rot))
+    {
+      gfloat old_centre_x = 0, old_centre_y = 0;
+
+      /* The centre of circles moves when they are resized */
+      if (is_centred (box2d_child))
+        clutter_actor_get_rotation (actor, CLUTTER_Z_AXIS,
+                                    &old_centre_x, &old_centre_y, NULL);
+
+      if ((old_centre_x == centre_x) && (old_centre_y == centre_y))
+        return;
+    }
 
   SYNCLOG ("setting actor position: ' %f %f angle: %lf\n", x, y, rot);
 
+  priv->syncing = TRUE;
   clutter_actor_set_position (actor, x, y);
-  clutter_actor_set_rotation (actor, CLUTTER_Z_AXIS,
-                              body->GetAngle () * (180 / G_PI),
+  clutter_actor_set_rotation (actor, CLUTTER_Z_AXIS, rot,
                               centre_x, centre_y, 0);
+  priv->syncing = FALSE;
 
   /* Store the set values to know when to resync the body */
   box2d_child->priv->old_x = x;
@@ -564,26 +1089,105 @@ _clutter_box2d_sync_actor (ClutterBox2D *box2d, ClutterBox2DChild *box2d_child)
   box2d_child->priv->old_rot = rot;
 }
 
+/* Synchronise actors to have geometrical sync with bodies */
+static void
+clutter_box2d_sync_actors (ClutterBox2D *box2d,
+                           gfloat        alpha)
+{
+  ClutterBox2DPrivate *priv = box2d->priv;
+  guint                i;
+
+  /* Rescaling has to go through the shapes of all children */
+  if (priv->dirty)
+    for (i = 0; i < priv->children->len; i++)
+      queue_sync_actor (box2d, (ClutterBox2DChild*)
+                        g_ptr_array_index (priv->children, i));
+
+  i = 0;
+  while (i < priv->awake_children->len)
+    {
+      ClutterBox2DChild *box2d_child =
+        (ClutterBox2DChild*) g_ptr_array_index (priv->awake_children, i);
+      b2Body *body = box2d_child->priv->body;
+
+      /* Bodies that don't move and that the actor already reflects don't
+       * need synchronising at all, until they are woken or moved again.
+       * Their shapes still need rescaling when the scale factor changed.
+       */
+      if (!body ||
+          (!priv->dirty && box2d_child->priv->synced &&
+           (!body->IsAwake () || (body->GetType () == b2_staticBody))))
+        {
+          box2d_child->priv->awake = FALSE;
+          g_ptr_array_remove_index_fast (priv->awake_children, i);
+          continue;
+        }
+
+      _clutter_box2d_sync_actor (box2d, box2d_child, alpha);
+      i++;
+    }
+
+  /* Reset the 'dirty' flag - all shapes would be rescaled by the above
+   * loop in the ensure_shape function.
+   */
+  priv->dirty = FALSE;
+}
+
+/* Fill in the collision object passed to "collision" handlers. The object
+ * is reused between emissions, unless a handler kept a reference to it.
+ */
+static ClutterBox2DCollision *
+clutter_box2d_get_collision (ClutterBox2D                      *box2d,
+                             const ClutterBox2DCollisionRecord *record)
+{
+  ClutterBox2DPrivate   *priv = box2d->priv;
+  ClutterBox2DCollision *collision;
+
+  if (priv->collision && (G_OBJECT (priv->collision)->ref_count > 1))
+    {
+      g_object_unref (priv->collision);
+      priv->collision = NULL;
+    }
+
+  if (!priv->collision)
+    priv->collision = CLUTTER_BOX2D_COLLISION (
+      g_object_new (CLUTTER_TYPE_BOX2D_COLLISION, NULL));
+
+  collision = priv->collision;
+  collision->actor1 = record->actor1;
+  collision->actor2 = record->actor2;
+  collision->position = record->position;
+  collision->normal = record->normal;
+  collision->normal_force = record->normal_force;
+  collision->tangent_force = record->tangent_force;
+  collision->id = record->id;
+
+  return collision;
+}
+
 static void
 clutter_box2d_real_iterate (ClutterBox2D *box2d)
 {
   ClutterBox2DPrivate *priv = box2d->priv;
   gint                 steps = priv->iterations;
   b2World             *world = priv->world;
-  GList               *actors = g_hash_table_get_values (priv->actors);
-  GList *iter;
+  b2Body             **solved_bodies;
+  guint                i;
 
-  /* First we check for each actor the need for, and perform a sync
-   * from the actor to the body, if necessary, before running simulation
+  /* First we perform a sync from the actor to the body for the actors
+   * that were moved by the application since the last step.
    */
-  for (iter = actors; iter; iter = g_list_next (iter))
+  for (i = 0; i < priv->moved_children->len; i++)
     {
       gfloat x, y;
       gdouble rot;
 
-      ClutterBox2DChild *box2d_child = (ClutterBox2DChild*) iter->data;
+      ClutterBox2DChild *box2d_child =
+        (ClutterBox2DChild*) g_ptr_array_index (priv->moved_children, i);
       ClutterActor *actor = CLUTTER_CHILD_META (box2d_child)->actor;
 
+      box2d_child->priv->moved = FALSE;
+
       clutter_actor_get_position (actor, &x, &y);
       rot = clutter_actor_get_rotation (actor, CLUTTER_Z_AXIS,
                                         NULL, NULL, NULL);
@@ -593,63 +1197,159 @@ clutter_box2d_real_iterate (ClutterBox2D *box2d)
           (box2d_child->priv->old_rot != rot))
         _clutter_box2d_sync_body (box2d, box2d_child);
     }
+  g_ptr_array_set_size (priv->moved_children, 0);
+
+  end_fixture_batch (box2d);
+
+  /* Remember where the bodies were before stepping, to interpolate.
+   * Resting children that aren't listed already remember where they rest.
+   */
+  for (i = 0; i < priv->awake_children->len; i++)
+    {
+      ClutterBox2DChild *box2d_child =
+        (ClutterBox2DChild*) g_ptr_array_index (priv->awake_children, i);
+
+      if (box2d_child->priv->body)
+        {
+          box2d_child->priv->prev_position =
+            box2d_child->priv->body->GetPosition ();
+          box2d_child->priv->prev_angle = box2d_child->priv->body->GetAngle ();
+        }
+    }
 
   /* Iterate Box2D simulation of bodies */
+  priv->step_count ++;
   world->Step (priv->time_step / 1000.f, steps, steps);
 
-  /* Synchronise actor to have geometrical sync with bodies */
-  for (iter = actors; iter; iter = g_list_next (iter))
+  /* Only the bodies that were solved may have moved, even those that
+   * just fell asleep, list their children to synchronise the actors.
+   */
+  solved_bodies = world->GetSolvedBodies ();
+  for (i = 0; i < (guint) world->GetSolvedBodyCount (); i++)
     {
-      ClutterBox2DChild *box2d_child = (ClutterBox2DChild*) iter->data;
-      _clutter_box2d_sync_actor (box2d, box2d_child);
+      ClutterBox2DChild *box2d_child =
+        (ClutterBox2DChild*) solved_bodies[i]->GetUserData ();
+
+      if (box2d_child)
+        {
+          box2d_child->priv->synced = FALSE;
+          queue_sync_actor (box2d, box2d_child);
+        }
     }
-  g_list_free (actors);
 
-  /* Reset the 'dirty' flag - all shapes would be recreated by the above
-   * for-loop in the ensure_shape function.
-   */
-  priv->dirty = FALSE;
+  /* Emit the contacts that began and ended */
+  for (i = 0; i < priv->contact_events->len; i++)
+    {
+      ClutterBox2DContactEvent *event;
+      ClutterBox2DChild        *box2d_child1, *box2d_child2;
+
+      event = &g_array_index (priv->contact_events,
+                              ClutterBox2DContactEvent, i);
+
+      /* Either actor may have been removed by a previous handler */
+      box2d_child1 = clutter_box2d_get_child (box2d, event->actor1);
+      box2d_child2 = clutter_box2d_get_child (box2d, event->actor2);
+
+      if (box2d_child1 &&
+          _clutter_box2d_child_reports_collisions (box2d_child1,
+                                                   priv->step_count))
+        _clutter_box2d_child_emit_contact (box2d_child1, event->begin,
+                                           box2d_child2 ? event->actor2 : NULL);
+
+      if (box2d_child2 &&
+          _clutter_box2d_child_reports_collisions (box2d_child2,
+                                                   priv->step_count))
+        _clutter_box2d_child_emit_contact (box2d_child2, event->begin,
+                                           box2d_child1 ? event->actor1 : NULL);
+    }
+  g_array_set_size (priv->contact_events, 0);
+
+  if (priv->collisions->len == 0)
+    return;
+
+  /* Deliver the whole batch of collisions first */
+  g_signal_emit (box2d, box2d_signals[COLLISIONS], 0,
+                 priv->collisions->data, priv->collisions->len);
+
+  /* Records only exist for children, so their class is initialised by now */
+  if (G_UNLIKELY (!child_collision_signal))
+    child_collision_signal = g_signal_lookup ("collision",
+                                              CLUTTER_TYPE_BOX2D_CHILD);
 
   /* Process list of collisions and emit signals for any actors with
    * a registered callback. */
-  for (iter = priv->collisions; iter; iter = g_list_next (iter))
+  for (i = 0; i < priv->collisions->len; i++)
     {
-      ClutterBox2DCollision  *collision;
-      ClutterBox2DChild      *box2d_child1, *box2d_child2;
-      ClutterBox2DChildClass *klass;
+      ClutterBox2DCollisionRecord *record;
+      ClutterBox2DCollision       *collision;
+      ClutterBox2DChild           *box2d_child1, *box2d_child2;
 
-      collision = CLUTTER_BOX2D_COLLISION (iter->data);
+      record = &g_array_index (priv->collisions,
+                               ClutterBox2DCollisionRecord, i);
 
-      box2d_child1 = clutter_box2d_get_child (box2d, collision->actor1);
+      box2d_child1 = clutter_box2d_get_child (box2d, record->actor1);
+      box2d_child2 = clutter_box2d_get_child (box2d, record->actor2);
 
-      if (box2d_child1)
-        {
-          klass = CLUTTER_BOX2D_CHILD_CLASS (G_OBJECT_GET_CLASS (box2d_child1));
-          g_signal_emit_by_name (box2d_child1, "collision", collision);
-        }
+      /* Only emit on children that listen and care about this impact */
+      if (box2d_child1 &&
+          (!_clutter_box2d_child_reports_collisions (box2d_child1,
+                                                     priv->step_count) ||
+           record->normal_force < box2d_child1->priv->collision_threshold))
+        box2d_child1 = NULL;
 
-      box2d_child2 = clutter_box2d_get_child (box2d, collision->actor2);
+      if (box2d_child2 &&
+          (!_clutter_box2d_child_reports_collisions (box2d_child2,
+                                                     priv->step_count) ||
+           record->normal_force < box2d_child2->priv->collision_threshold))
+        box2d_child2 = NULL;
 
-      if (box2d_child2)
-        {
-          klass = CLUTTER_BOX2D_CHILD_CLASS (G_OBJECT_GET_CLASS (box2d_child2));
-          g_signal_emit_by_name (box2d_child2, "collision", collision);
-        }
+      if (!box2d_child1 && !box2d_child2)
+        continue;
 
-      g_object_unref (collision);
+      collision = clutter_box2d_get_collision (box2d, record);
+
+      if (box2d_child1)
+        g_signal_emit (box2d_child1, child_collision_signal, 0, collision);
+
+      if (box2d_child2)
+        g_signal_emit (box2d_child2, child_collision_signal, 0, collision);
     }
-  g_list_free (priv->collisions);
-  priv->collisions = NULL;
+  g_array_set_size (priv->collisions, 0);
 }
 
-static gboolean
-clutter_box2d_iterate (ClutterBox2D *box2d)
+static void
+clutter_box2d_new_frame (ClutterTimeline *timeline,
+                         gint             msecs,
+                         ClutterBox2D    *box2d)
 {
   ClutterBox2DPrivate *priv = box2d->priv;
+  gint                 steps = 0;
 
-  CLUTTER_BOX2D_GET_CLASS (box2d)->iterate (box2d);
+  /* Accumulate the real time that passed since the last frame and run
+   * as many fixed-size steps as fit in it. Whatever is left over is
+   * carried to the next frame.
+   */
+  priv->accumulator += clutter_timeline_get_delta (timeline);
 
-  return TRUE;
+  while ((priv->accumulator >= priv->time_step) &&
+         (steps < priv->max_substeps))
+    {
+      CLUTTER_BOX2D_GET_CLASS (box2d)->iterate (box2d);
+      priv->accumulator -= priv->time_step;
+      steps ++;
+    }
+
+  /* If we couldn't keep up, drop the backlog rather than trying to
+   * catch up on it over the next frames, which would only make us
+   * fall further behind.
+   */
+  if (priv->accumulator >= priv->time_step)
+    priv->accumulator = fmodf (priv->accumulator, priv->time_step);
+
+  /* Without interpolation, actors only move when a step was taken */
+  if (steps || (priv->interpolation != CLUTTER_BOX2D_INTERPOLATION_NONE))
+    clutter_box2d_sync_actors (box2d,
+                               priv->accumulator / priv->time_step);
 }
 
 void
@@ -701,7 +1401,7 @@ clutter_box2d_set_simulating (ClutterBox2D  *box2d,
 
   priv = box2d->priv;
 
-  if (!!simulating == !!priv->iterate_id)
+  if (!!simulating == !!clutter_timeline_is_playing (priv->timeline))
     return;
 
   if (simulating)
@@ -721,7 +1421,7 @@ clutter_box2d_get_simulating (ClutterBox2D *box2d)
 
   priv = box2d->priv;
 
-  return priv->iterate_id ? TRUE : FALSE;
+  return clutter_timeline_is_playing (priv->timeline);
 }
 
 void
@@ -738,6 +1438,8 @@ clutter_box2d_set_scale_factor (ClutterBox2D *box2d,
       priv->scale_factor = scale_factor;
       priv->inv_scale_factor = 1.f/scale_factor;
       priv->dirty = TRUE;
+      if (priv->world && priv->broad_phase == CLUTTER_BOX2D_BROAD_PHASE_GRID)
+        update_broad_phase (box2d);
       g_object_notify (G_OBJECT (box2d), "scale-factor");
     }
 }
@@ -748,3 +1450,37 @@ clutter_box2d_get_scale_factor (ClutterBox2D *box2d)
   g_return_val_if_fail (CLUTTER_IS_BOX2D (box2d), 0.f);
   return box2d->priv->scale_factor;
 }
+
+void
+clutter_box2d_shift_origin (ClutterBox2D *box2d,
+                            gfloat        x,
+                            gfloat        y)
+{
+  ClutterBox2DPrivate *priv;
+  b2Vec2               offset;
+  guint                i;
+
+  g_return_if_fail (CLUTTER_IS_BOX2D (box2d));
+
+  priv = box2d->priv;
+  offset = b2Vec2 (x * priv->scale_factor, y * priv->scale_factor);
+
+  priv->world->ShiftOrigin (offset);
+
+  /* Move the actors along with their bodies, including where they were
+   * before the last step so that interpolation carries on smoothly.
+   */
+  priv->syncing = TRUE;
+  for (i = 0; i < priv->children->len; i++)
+    {
+      ClutterBox2DChild *box2d_child =
+        (ClutterBox2DChild*) g_ptr_array_index (priv->children, i);
+
+      box2d_child->priv->prev_position -= offset;
+      box2d_child->priv->old_x -= x;
+      box2d_child->priv->old_y -= y;
+
+      clutter_actor_move_by (CLUTTER_CHILD_META (box2d_child)->actor, -x, -y);
+    }
+  priv->syncing = FALSE;
+}
@@ -113,6 +113,115 @@ GType            clutter_box2d_get_type         (void) G_GNUC_CONST;
  * at the cost of CPU usage.
  */
 
+/**
+ * ClutterBox2D::collisions:
+ * @box2d: the #ClutterBox2D that emitted the signal
+ * @records: an array of #ClutterBox2DCollisionRecord
+ * @n_records: the amount of records in @records
+ *
+ * Emitted after each physics step in which contacts were found, with
+ * one record for every pair of touching actors, carrying the impulse the
+ * contact solver applied between them. This is emitted before the
+ * per-child "collision" signals, and is a much cheaper alternative to
+ * those when many contacts are of interest.
+ *
+ * Only contacts involving at least one child that reports collisions are
+ * recorded. A child reports collisions when a handler is connected to its
+ * "collision" signal, or when its "report-collisions" child property is
+ * set. Contacts with a normal impulse below the "collision-threshold"
+ * of the reporting children are left out.
+ */
+
+/**
+ * ClutterBox2D:max-substeps
+ *
+ * The simulation is advanced once per frame by as many steps of
+ * #ClutterBox2D:time-step as fit in the time since the previous frame.
+ * This caps the amount of steps performed in a single frame; when a frame
+ * takes longer than that to arrive, the excess time is dropped and the
+ * simulation slows down rather than stalling the application.
+ */
+
+/**
+ * ClutterBox2D:worker-threads
+ *
+ * The amount of threads used to simulate a step. Contacts between pairs
+ * of shapes are computed on all threads. Groups of bodies that don't touch
+ * each other, and aren't connected by joints, are independent of each
+ * other and can be simulated on different threads. The results
+ * don't depend on the amount of threads, and collision signals and
+ * callbacks are still emitted in the thread running the main loop. When
+ * larger than 1, a pool of worker threads is kept alive for as long as
+ * the container exists.
+ */
+
+
+/**
+ * ClutterBox2D:interpolation
+ *
+ * How actor positions are computed for frames that fall in between two
+ * physics steps, see #ClutterBox2DInterpolation. Interpolating allows
+ * running the simulation at a lower rate than the stage is painted at,
+ * for example by setting #ClutterBox2D:time-step to 1000/30, without
+ * visible stutter.
+ */
+
+/**
+ * ClutterBox2DInterpolation:
+ * @CLUTTER_BOX2D_INTERPOLATION_NONE: Actors are placed at the position of
+ *   the last physics step
+ * @CLUTTER_BOX2D_INTERPOLATION_INTERPOLATE: Actors are placed in between
+ *   the last two physics steps. This is smooth, but lags behind the
+ *   simulation by up to one step
+ * @CLUTTER_BOX2D_INTERPOLATION_EXTRAPOLATE: Actors are placed ahead of the
+ *   last physics step, predicted from the movement during that step. This
+ *   doesn't lag, but may briefly overshoot when bodies collide
+ *
+ * How actor positions are derived from the physics simulation in between
+ * physics steps.
+ */
+typedef enum {
+  CLUTTER_BOX2D_INTERPOLATION_NONE = 0,
+  CLUTTER_BOX2D_INTERPOLATION_INTERPOLATE,
+  CLUTTER_BOX2D_INTERPOLATION_EXTRAPOLATE
+} ClutterBox2DInterpolation;
+
+/**
+ * ClutterBox2D:broad-phase
+ *
+ * How pairs of possibly touching shapes are found, see
+ * #ClutterBox2DBroadPhase. This can only be set when the container is
+ * created.
+ */
+
+/**
+ * ClutterBox2D:grid-cell-size
+ *
+ * The width and height of a cell of the grid broad-phase, in pixels. Only
+ * used when #ClutterBox2D:broad-phase is %CLUTTER_BOX2D_BROAD_PHASE_GRID.
+ * This works best at about the size of a typical child.
+ */
+
+/**
+ * ClutterBox2DBroadPhase:
+ * @CLUTTER_BOX2D_BROAD_PHASE_TREE: Shapes are kept in a tree of bounding
+ *   boxes. This suits scenes of any size and layout
+ * @CLUTTER_BOX2D_BROAD_PHASE_SWEEP: Shapes are kept sorted along the
+ *   x-axis. This suits scenes that are spread out horizontally, such as
+ *   side scrollers
+ * @CLUTTER_BOX2D_BROAD_PHASE_GRID: Shapes are kept in the cells of a
+ *   uniform grid. This suits many shapes of about the same size
+ *
+ * The algorithm used to find pairs of possibly touching shapes. Each of
+ * them finds the same collisions, but in a different order, so contacts
+ * are solved in a different order too. Simulations can therefore differ
+ * slightly from one broad-phase to another.
+ */
+typedef enum {
+  CLUTTER_BOX2D_BROAD_PHASE_TREE = 0,
+  CLUTTER_BOX2D_BROAD_PHASE_SWEEP,
+  CLUTTER_BOX2D_BROAD_PHASE_GRID
+} ClutterBox2DBroadPhase;
 
 /**
  * clutter_box2d_new:
@@ -185,6 +294,21 @@ void  clutter_box2d_set_scale_factor (ClutterBox2D *box2d,
  */
 gfloat  clutter_box2d_get_scale_factor (ClutterBox2D *box2d);
 
+/**
+ * clutter_box2d_shift_origin:
+ * @box2d: a #ClutterBox2D
+ * @x: the x coordinate of the new origin, in pixels
+ * @y: the y coordinate of the new origin, in pixels
+ *
+ * Moves all the children of @box2d by -@x, -@y pixels at once, for
+ * instance to scroll a large scene. Unlike moving the children one by
+ * one, this does not disturb the simulation: no body is woken up and no
+ * collision is looked for.
+ */
+void  clutter_box2d_shift_origin (ClutterBox2D *box2d,
+                                  gfloat        x,
+                                  gfloat        y);
+
 /**
  * SECTION:clutter-box2d-actor
  * @short_description: Options for the children of ClutterBox2D
@@ -223,6 +347,7 @@ G_END_DECLS
 
 #endif
 
+#include <clutter-box2d/clutter-box2d-shape.h>
 #include <clutter-box2d/clutter-box2d-child.h>
 #include <clutter-box2d/clutter-box2d-collision.h>
 #include <clutter-box2d/clutter-box2d-joint.h>